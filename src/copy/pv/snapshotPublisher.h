@@ -0,0 +1,116 @@
+/* snapshotPublisher.h */
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#ifndef SNAPSHOTPUBLISHER_H
+#define SNAPSHOTPUBLISHER_H
+
+#include <pv/pvData.h>
+#include <pv/lock.h>
+#include <pv/bitSet.h>
+#include <pv/sharedPtr.h>
+#include <pv/noDefaultMethods.h>
+
+#include <shareLib.h>
+
+namespace epics { namespace pvData {
+
+/** @brief Publish consistent snapshots of a PVStructure to many reader threads.
+ *
+ * One writer thread calls publish() after updating a PVStructure which it owns.
+ * Reader threads call current() or read() to see a consistent value,
+ * eg. alarm, timeStamp, and value from the same update, without locking the writer's PVStructure.
+ *
+ * Each snapshot is an immutable copy, which is released when the last reader drops its reference
+ * (deferred reclamation).  The writer never waits for a reader to finish copying.
+ * An internal lock is held only while the pointer to the latest snapshot is copied or replaced.
+ *
+ * The elements of structure and union arrays are copied, by publish() and read(),
+ * so that neither snapshots nor readers share them with the writer's PVStructure.
+ *
+ * publish() re-uses the snapshot before the latest when no reader still holds it, or its value,
+ * so that publishing costs in proportion to the number of changed fields.
+ * Otherwise a new snapshot is allocated and copied in full.
+ *
+ @code
+   // writer
+   SnapshotPublisher pub(record->getStructure());
+   ...
+   record->getSubFieldT<PVDouble>("value")->put(v);
+   changed.set(valueOffset);
+   pub.publish(*record, changed);
+
+   // each reader
+   PVStructurePtr mine(pub.current()->value->getStructure()->build());
+   size_t seq = SnapshotPublisher::initial;
+   BitSet updated;
+   if(pub.read(*mine, seq, &updated)) {...}
+ @endcode
+ *
+ * @since 8.0.8
+ */
+class epicsShareClass SnapshotPublisher
+{
+    EPICS_NOT_COPYABLE(SnapshotPublisher)
+public:
+    POINTER_DEFINITIONS(SnapshotPublisher);
+
+    //! One published value.  Not modified while referenced outside of the SnapshotPublisher.
+    struct Snapshot {
+        POINTER_DEFINITIONS(Snapshot);
+        //! Incremented by each publish().  The snapshot made by the constructor is zero.
+        size_t sequence;
+        //! The value.  A reader may keep a reference to it after releasing the Snapshot.
+        PVStructure::const_shared_pointer value;
+        //! Fields changed since the previous snapshot
+        BitSet changed;
+    };
+
+    //! Value of read() sequence for a destination which has never been updated.
+    static const size_t initial = (size_t)-1;
+
+    /** Create with an initial snapshot of default values.
+     * @param type The Structure of published values.
+     */
+    explicit SnapshotPublisher(const StructureConstPtr& type);
+    ~SnapshotPublisher();
+
+    /** Publish a new snapshot.  Only one thread may publish.
+     *
+     * @param from A PVStructure of the published type, owned by the calling thread.
+     * @param changed Fields of 'from' changed since the previous publish(), as offsets in 'from'.
+     * @throws std::invalid_argument if 'from' is not of the published type.
+     */
+    void publish(const PVStructure& from, const BitSet& changed);
+    //! Publish a new snapshot with all fields changed.
+    void publish(const PVStructure& from);
+
+    //! The latest snapshot.  May be called from any thread.
+    Snapshot::const_shared_pointer current() const;
+
+    /** Bring a copy up to date from the latest snapshot.  May be called from any thread.
+     *
+     * Copies only the changed fields when dest was updated from the snapshot before the latest,
+     * otherwise all fields.
+     *
+     * @param dest A PVStructure of the published type.
+     * @param sequence Sequence of the snapshot from which dest was last updated, or initial.
+     *                 Updated to the sequence of the latest snapshot.
+     * @param changed If not NULL, set to the fields of dest which were copied.
+     * @returns false if dest was already up to date.
+     * @throws std::invalid_argument if dest is not of the published type.
+     */
+    bool read(PVStructure& dest, size_t& sequence, BitSet* changed = 0) const;
+
+private:
+    const StructureConstPtr type;
+    const bool elements; // type has structure or union arrays, whose elements must be copied
+    mutable Mutex lock; // guards latest
+    Snapshot::shared_pointer latest;
+    Snapshot::shared_pointer spare; // the snapshot before latest.  only used by publish()
+};
+
+}} // namespace epics::pvData
+
+#endif // SNAPSHOTPUBLISHER_H
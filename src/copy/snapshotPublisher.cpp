@@ -0,0 +1,235 @@
+/* snapshotPublisher.cpp */
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <stdexcept>
+
+#include <epicsAtomic.h>
+
+#define epicsExportSharedSymbols
+#include <pv/snapshotPublisher.h>
+
+namespace {
+using namespace epics::pvData;
+
+// Whether only the SnapshotPublisher references a snapshot, or its value.
+// A reader releases its reference after its last access, so the barriers order
+// the writer's later modifications after that access.
+bool unused(const SnapshotPublisher::Snapshot::shared_pointer& snap)
+{
+    if(!snap || !snap.unique())
+        return false;
+    epicsAtomicReadMemoryBarrier();
+    // a reader may have taken a reference to the value before releasing the Snapshot
+    if(!snap->value.unique())
+        return false;
+    epicsAtomicReadMemoryBarrier();
+    return true;
+}
+
+PVStructure& modify(const SnapshotPublisher::Snapshot::shared_pointer& snap)
+{
+    return const_cast<PVStructure&>(*snap->value);
+}
+
+// Whether copyUnchecked() of this type may share PVFields, the elements of
+// structure and union arrays, which the source could modify in place.
+bool hasElements(const Field& fld)
+{
+    switch(fld.getType()) {
+    case structure: {
+        const FieldConstPtrArray& fields = static_cast<const Structure&>(fld).getFields();
+        for(size_t i=0, N=fields.size(); i<N; i++) {
+            if(hasElements(*fields[i]))
+                return true;
+        }
+        return false;
+    }
+    case structureArray:
+    case unionArray:
+    case union_: // may select either
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Replace any structure or union array elements shared by copyUnchecked() with copies.
+void ownElements(PVField& fld)
+{
+    PVDataCreatePtr create(getPVDataCreate());
+
+    switch(fld.getField()->getType()) {
+    case structure: {
+        const PVFieldPtrArray& fields = static_cast<PVStructure&>(fld).getPVFields();
+        for(size_t i=0, N=fields.size(); i<N; i++)
+            ownElements(*fields[i]);
+        break;
+    }
+    case union_: {
+        // PVUnion::copyUnchecked() copies the selected value
+        PVFieldPtr value(static_cast<PVUnion&>(fld).get());
+        if(value)
+            ownElements(*value);
+        break;
+    }
+    case structureArray: {
+        PVStructureArray& arr = static_cast<PVStructureArray&>(fld);
+        PVStructureArray::const_svector cur(arr.view());
+        if(cur.empty())
+            break;
+        PVStructureArray::svector copy(cur.size());
+        for(size_t i=0, N=cur.size(); i<N; i++) {
+            if(!cur[i])
+                continue;
+            PVStructurePtr elem(create->createPVStructure(cur[i]->getStructure()));
+            elem->copyUnchecked(*cur[i]);
+            ownElements(*elem);
+            copy[i] = elem;
+        }
+        arr.replace(freeze(copy));
+        break;
+    }
+    case unionArray: {
+        PVUnionArray& arr = static_cast<PVUnionArray&>(fld);
+        PVUnionArray::const_svector cur(arr.view());
+        if(cur.empty())
+            break;
+        PVUnionArray::svector copy(cur.size());
+        for(size_t i=0, N=cur.size(); i<N; i++) {
+            if(!cur[i])
+                continue;
+            PVUnionPtr elem(create->createPVUnion(cur[i]->getUnion()));
+            elem->copyUnchecked(*cur[i]);
+            ownElements(*elem);
+            copy[i] = elem;
+        }
+        arr.replace(freeze(copy));
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+// Only those fields selected by mask, as with copyUnchecked()
+void ownElements(PVStructure& top, const BitSet& mask)
+{
+    const uint32 end = static_cast<uint32>(top.getNextFieldOffset());
+    int32 i = mask.nextSetBit(static_cast<uint32>(top.getFieldOffset()));
+    if(i==static_cast<int32>(top.getFieldOffset())) {
+        ownElements(static_cast<PVField&>(top));
+        return;
+    }
+    while(i>=0 && static_cast<uint32>(i)<end) {
+        PVFieldPtr fld(top.getSubField(static_cast<size_t>(i)));
+        if(!fld)
+            break;
+        ownElements(*fld);
+        i = mask.nextSetBit(static_cast<uint32>(fld->getNextFieldOffset()));
+    }
+}
+
+} // namespace
+
+namespace epics { namespace pvData {
+
+const size_t SnapshotPublisher::initial;
+
+SnapshotPublisher::SnapshotPublisher(const StructureConstPtr& type)
+    :type(type)
+    ,elements(type && hasElements(*type))
+{
+    if(!type)
+        throw std::invalid_argument("SnapshotPublisher requires a Structure");
+
+    latest.reset(new Snapshot);
+    latest->sequence = 0u;
+    latest->value = getPVDataCreate()->createPVStructure(type);
+    latest->changed.set(0);
+}
+
+SnapshotPublisher::~SnapshotPublisher() {}
+
+void SnapshotPublisher::publish(const PVStructure& from, const BitSet& changed)
+{
+    if(*from.getStructure()!=*type)
+        throw std::invalid_argument("structure definitions do not match");
+
+    Snapshot::shared_pointer next;
+
+    // Only publish() references 'spare' or modifies 'latest', so neither needs the lock here.
+    // Once no reader holds 'spare' or its value, none can take a new reference to either.
+    if(unused(spare)) {
+        next.swap(spare);
+        // 'next' has the value before 'latest', so also needs the changes made by 'latest'
+        BitSet mask(latest->changed);
+        mask |= changed;
+        modify(next).copyUnchecked(from, mask);
+        if(elements)
+            ownElements(modify(next), mask);
+
+    } else {
+        // still in use.  left to the last reader to free.
+        spare.reset();
+        next.reset(new Snapshot);
+        PVStructurePtr value(getPVDataCreate()->createPVStructure(type));
+        value->copyUnchecked(from);
+        if(elements)
+            ownElements(*value);
+        next->value = value;
+    }
+    next->changed = changed;
+    next->sequence = latest->sequence+1u;
+
+    {
+        Lock G(lock);
+        latest.swap(next);
+    }
+    spare.swap(next);
+}
+
+void SnapshotPublisher::publish(const PVStructure& from)
+{
+    BitSet all;
+    all.set(0);
+    publish(from, all);
+}
+
+SnapshotPublisher::Snapshot::const_shared_pointer SnapshotPublisher::current() const
+{
+    Lock G(lock);
+    return latest;
+}
+
+bool SnapshotPublisher::read(PVStructure& dest, size_t& sequence, BitSet* changed) const
+{
+    if(*dest.getStructure()!=*type)
+        throw std::invalid_argument("structure definitions do not match");
+
+    Snapshot::const_shared_pointer snap(current());
+
+    if(snap->sequence==sequence)
+        return false;
+
+    if(snap->sequence==sequence+1u) {
+        dest.copyUnchecked(*snap->value, snap->changed);
+        if(elements)
+            ownElements(dest, snap->changed);
+        if(changed)
+            *changed = snap->changed;
+    } else {
+        dest.copyUnchecked(*snap->value);
+        if(elements)
+            ownElements(dest);
+        if(changed) {
+            changed->clear();
+            changed->set(0);
+        }
+    }
+    sequence = snap->sequence;
+    return true;
+}
+
+}} // namespace epics::pvData
@@ -9,14 +9,35 @@
 #include <algorithm>
 #include <iterator>
 #include <sstream>
+#include <stdexcept>
+
+#include <string.h>
+#include <math.h>
+
+// SSE2 is always available on x86_64
+#if defined(__SSE2__) || defined(_M_X64)
+#  include <emmintrin.h>
+#  define PVD_COMPARE_SSE2
+#endif
 
 #define epicsExportSharedSymbols
 #include <pv/pvData.h>
+#include <pv/bitSet.h>
 
 using std::string;
 
 namespace epics { namespace pvData {
 
+namespace detail {
+struct field_compare {
+    // Hashes are computed when a Field is added to the FieldCreate cache,
+    // so different hashes show that Fields differ without recursing.
+    static bool differ(const Field& a, const Field& b) {
+        return a.m_hash && b.m_hash && a.m_hash!=b.m_hash;
+    }
+};
+} // namespace detail
+
 // Introspection object comparison
 
 /** Field equality conditions:
@@ -27,7 +48,7 @@ bool compare(const Field& a, const Field& b)
 {
     if(&a==&b)
         return true;
-    if(a.getType()!=b.getType())
+    if(a.getType()!=b.getType() || detail::field_compare::differ(a, b))
         return false;
     switch(a.getType()) {
     case scalar: {
@@ -69,26 +90,40 @@ bool compare(const Scalar& a, const Scalar& b)
 {
     if(&a==&b)
         return true;
-    return a.getScalarType()==b.getScalarType();
+    if(a.getScalarType()!=b.getScalarType())
+        return false;
+    const BoundedString *A = dynamic_cast<const BoundedString*>(&a),
+                        *B = dynamic_cast<const BoundedString*>(&b);
+    return !A==!B && (!A || A->getMaximumLength()==B->getMaximumLength());
 }
 
 bool compare(const ScalarArray& a, const ScalarArray& b)
 {
     if(&a==&b)
         return true;
-    return a.getElementType()==b.getElementType();
+    return a.getElementType()==b.getElementType()
+            && a.getArraySizeType()==b.getArraySizeType()
+            && a.getMaximumCapacity()==b.getMaximumCapacity();
 }
 
 bool compare(const Structure& a, const Structure& b)
 {
     if(&a==&b)
         return true;
-    if (a.getID()!=b.getID())
+    if(detail::field_compare::differ(a, b))
+        return false;
+    // interned, so compares pointers
+    if (a.getInternedID()!=b.getInternedID())
         return false;
     size_t nflds=a.getNumberFields();
     if (b.getNumberFields()!=nflds)
         return false;
 
+    std::vector<InternedString> const & an = a.getInternedFieldNames();
+    std::vector<InternedString> const & bn = b.getInternedFieldNames();
+    if(!std::equal( an.begin(), an.end(), bn.begin() ))
+        return false;
+
     // std::equals does not work, since FieldConstPtrArray is an array of shared_pointers
     FieldConstPtrArray const & af = a.getFields();
     FieldConstPtrArray const & bf = b.getFields();
@@ -96,9 +131,7 @@ bool compare(const Structure& a, const Structure& b)
         if (*(af[i].get()) != *(bf[i].get()))
             return false;
 
-    StringArray const & an = a.getFieldNames();
-    StringArray const & bn = b.getFieldNames();
-    return std::equal( an.begin(), an.end(), bn.begin() );
+    return true;
 }
 
 bool compare(const StructureArray& a, const StructureArray& b)
@@ -110,12 +143,20 @@ bool compare(const Union& a, const Union& b)
 {
     if(&a==&b)
         return true;
-    if (a.getID()!=b.getID())
+    if(detail::field_compare::differ(a, b))
+        return false;
+    // interned, so compares pointers
+    if (a.getInternedID()!=b.getInternedID())
         return false;
     size_t nflds=a.getNumberFields();
     if (b.getNumberFields()!=nflds)
         return false;
 
+    std::vector<InternedString> const & an = a.getInternedFieldNames();
+    std::vector<InternedString> const & bn = b.getInternedFieldNames();
+    if(!std::equal( an.begin(), an.end(), bn.begin() ))
+        return false;
+
     // std::equals does not work, since FieldConstPtrArray is an array of shared_pointers
     FieldConstPtrArray const & af = a.getFields();
     FieldConstPtrArray const & bf = b.getFields();
@@ -123,9 +164,7 @@ bool compare(const Union& a, const Union& b)
         if (*(af[i].get()) != *(bf[i].get()))
             return false;
 
-    StringArray const & an = a.getFieldNames();
-    StringArray const & bn = b.getFieldNames();
-    return std::equal( an.begin(), an.end(), bn.begin() );
+    return true;
 }
 
 bool compare(const UnionArray& a, const UnionArray& b)
@@ -152,11 +191,71 @@ bool compareScalar(const PVScalarValue<T>* left, const PVScalarValue<T>* right)
     return left->get()==right->get();
 }
 
+// Integers are equal when their bits are.  memcmp() is vectorized by the C library.
+template<typename T>
+bool equalElements(const T* a, const T* b, size_t n)
+{
+    return a==b || memcmp(a, b, n*sizeof(T))==0;
+}
+
+// Floating point values are compared with ==, so NaN differs from everything and 0.0 equals -0.0.
+// Elements of a shared buffer are still compared, as a NaN differs from itself.
+// The SSE2 compare has the same result as ==.
+
+bool equalElements(const double* a, const double* b, size_t n)
+{
+    size_t i = 0u;
+#ifdef PVD_COMPARE_SSE2
+    for(; i+8u<=n; i+=8u) {
+        __m128d e = _mm_and_pd(_mm_and_pd(_mm_cmpeq_pd(_mm_loadu_pd(a+i), _mm_loadu_pd(b+i)),
+                                          _mm_cmpeq_pd(_mm_loadu_pd(a+i+2), _mm_loadu_pd(b+i+2))),
+                               _mm_and_pd(_mm_cmpeq_pd(_mm_loadu_pd(a+i+4), _mm_loadu_pd(b+i+4)),
+                                          _mm_cmpeq_pd(_mm_loadu_pd(a+i+6), _mm_loadu_pd(b+i+6))));
+        if(_mm_movemask_pd(e)!=0x3)
+            return false;
+    }
+#endif
+    for(; i<n; i++) {
+        if(!(a[i]==b[i]))
+            return false;
+    }
+    return true;
+}
+
+bool equalElements(const float* a, const float* b, size_t n)
+{
+    size_t i = 0u;
+#ifdef PVD_COMPARE_SSE2
+    for(; i+16u<=n; i+=16u) {
+        __m128 e = _mm_and_ps(_mm_and_ps(_mm_cmpeq_ps(_mm_loadu_ps(a+i), _mm_loadu_ps(b+i)),
+                                         _mm_cmpeq_ps(_mm_loadu_ps(a+i+4), _mm_loadu_ps(b+i+4))),
+                              _mm_and_ps(_mm_cmpeq_ps(_mm_loadu_ps(a+i+8), _mm_loadu_ps(b+i+8)),
+                                         _mm_cmpeq_ps(_mm_loadu_ps(a+i+12), _mm_loadu_ps(b+i+12))));
+        if(_mm_movemask_ps(e)!=0xf)
+            return false;
+    }
+#endif
+    for(; i<n; i++) {
+        if(!(a[i]==b[i]))
+            return false;
+    }
+    return true;
+}
+
+bool equalElements(const string* a, const string* b, size_t n)
+{
+    return a==b || std::equal(a, a+n, b);
+}
+
 template<typename T>
 bool compareArray(const PVValueArray<T>* left, const PVValueArray<T>* right)
 {
     typename PVValueArray<T>::const_svector lhs(left->view()), rhs(right->view());
-    return std::equal(lhs.begin(), lhs.end(), rhs.begin());
+    if(lhs.size()!=rhs.size())
+        return false;
+    else if(lhs.empty())
+        return true;
+    return equalElements(lhs.data(), rhs.data(), lhs.size());
 }
 
 // partially typed comparisons
@@ -243,6 +342,8 @@ bool compareField(const PVStructureArray* left, const PVStructureArray* right)
 
     if(ld.size()!=rd.size())
         return false;
+    else if(ld.data()==rd.data())
+        return true;
 
     PVStructureArray::const_svector::const_iterator lit, lend, rit;
 
@@ -250,12 +351,12 @@ bool compareField(const PVStructureArray* left, const PVStructureArray* right)
         lit!=lend;
         ++lit, ++rit)
     {
+        // the same element, or both null
+        if (*lit == *rit)
+            continue;
         // element can be null
-        if (!(*lit) || !(*rit))
-        {
-            if (*lit || *rit)
-                return false;
-        }
+        else if (!(*lit) || !(*rit))
+            return false;
         else if (**lit != **rit)
             return false;
     }
@@ -302,6 +403,8 @@ bool compareField(const PVUnionArray* left, const PVUnionArray* right)
 
     if(ld.size()!=rd.size())
         return false;
+    else if(ld.data()==rd.data())
+        return true;
 
     PVUnionArray::const_svector::const_iterator lit, lend, rit;
 
@@ -309,12 +412,12 @@ bool compareField(const PVUnionArray* left, const PVUnionArray* right)
         lit!=lend;
         ++lit, ++rit)
     {
+        // the same element, or both null
+        if (*lit == *rit)
+            continue;
         // element can be null
-        if (!(*lit) || !(*rit))
-        {
-            if (*lit || *rit)
-                return false;
-        }
+        else if (!(*lit) || !(*rit))
+            return false;
         else if (**lit != **rit)
             return false;
     }
@@ -345,4 +448,146 @@ bool operator==(const PVField& left, const PVField& right)
     throw std::logic_error("PVField with invalid type!");
 }
 
+
+// value differences for diff()
+
+namespace {
+
+typedef std::map<uint32, double> deadbands_t;
+
+template<typename T>
+bool differValue(T a, T b, const double *deadband)
+{
+    if(deadband) {
+        double A(a), B(b);
+        // NaN only differs from a number
+        if(A!=A || B!=B)
+            return (A!=A)!=(B!=B);
+        return fabs(B-A) > *deadband;
+    }
+    return memcmp(&a, &b, sizeof(T))!=0;
+}
+
+template<typename T>
+bool differArray(const PVValueArray<T>* a, const PVValueArray<T>* b, const double *deadband)
+{
+    typename PVValueArray<T>::const_svector A(a->view()), B(b->view());
+    if(A.size()!=B.size())
+        return true;
+    else if(A.empty() || A.data()==B.data())
+        return false;
+    else if(!deadband)
+        return memcmp(A.data(), B.data(), A.size()*sizeof(T))!=0;
+
+    for(size_t i=0, N=A.size(); i<N; i++) {
+        if(differValue(A[i], B[i], deadband))
+            return true;
+    }
+    return false;
+}
+
+template<>
+bool differArray(const PVValueArray<string>* a, const PVValueArray<string>* b, const double *)
+{
+    PVStringArray::const_svector A(a->view()), B(b->view());
+    if(A.size()!=B.size())
+        return true;
+    else if(A.data()==B.data())
+        return false;
+    return !std::equal(A.begin(), A.end(), B.begin());
+}
+
+bool differField(const PVScalar* a, const PVScalar* b, const double *deadband)
+{
+    switch(a->getScalar()->getScalarType()) {
+#define OP(ENUM, TYPE) case ENUM: return differValue(static_cast<const PVScalarValue<TYPE>*>(a)->get(), static_cast<const PVScalarValue<TYPE>*>(b)->get(), deadband)
+    OP(pvBoolean, uint8);
+    OP(pvUByte, uint8);
+    OP(pvByte, int8);
+    OP(pvUShort, uint16);
+    OP(pvShort, int16);
+    OP(pvUInt, uint32);
+    OP(pvInt, int32);
+    OP(pvULong, uint64);
+    OP(pvLong, int64);
+    OP(pvFloat, float);
+    OP(pvDouble, double);
+#undef OP
+    case pvString:
+        return static_cast<const PVString*>(a)->get()!=static_cast<const PVString*>(b)->get();
+    }
+    throw std::logic_error("PVScalar with invalid scalar type!");
+}
+
+bool differField(const PVScalarArray* a, const PVScalarArray* b, const double *deadband)
+{
+    switch(a->getScalarArray()->getElementType()) {
+#define OP(ENUM, TYPE) case ENUM: return differArray(static_cast<const PVValueArray<TYPE>*>(a), static_cast<const PVValueArray<TYPE>*>(b), deadband)
+    OP(pvBoolean, uint8);
+    OP(pvUByte, uint8);
+    OP(pvByte, int8);
+    OP(pvUShort, uint16);
+    OP(pvShort, int16);
+    OP(pvUInt, uint32);
+    OP(pvInt, int32);
+    OP(pvULong, uint64);
+    OP(pvLong, int64);
+    OP(pvFloat, float);
+    OP(pvDouble, double);
+    OP(pvString, string);
+#undef OP
+    }
+    throw std::logic_error("PVScalarArray with invalid element type!");
+}
+
+// a and b have the same type
+bool diffField(const PVField& a, const PVField& b, BitSet& changed, const deadbands_t *deadbands)
+{
+    const double *deadband = 0;
+    bool differ;
+
+    switch(b.getField()->getType()) {
+    case structure: {
+        const PVFieldPtrArray& af = static_cast<const PVStructure&>(a).getPVFields();
+        const PVFieldPtrArray& bf = static_cast<const PVStructure&>(b).getPVFields();
+        bool ret = false;
+        for(size_t i=0, N=bf.size(); i<N; i++) {
+            if(diffField(*af[i], *bf[i], changed, deadbands))
+                ret = true;
+        }
+        return ret;
+    }
+    case scalar:
+    case scalarArray:
+        if(deadbands && !deadbands->empty()) {
+            deadbands_t::const_iterator it(deadbands->find(static_cast<uint32>(b.getFieldOffset())));
+            if(it!=deadbands->end())
+                deadband = &it->second;
+        }
+        if(b.getField()->getType()==scalar)
+            differ = differField(static_cast<const PVScalar*>(&a), static_cast<const PVScalar*>(&b), deadband);
+        else
+            differ = differField(static_cast<const PVScalarArray*>(&a), static_cast<const PVScalarArray*>(&b), deadband);
+        break;
+    default:
+        differ = a!=b;
+        break;
+    }
+
+    if(differ)
+        changed.set(static_cast<uint32>(b.getFieldOffset()));
+    return differ;
+}
+
+} // namespace
+
+bool diff(const PVStructure& a, const PVStructure& b, BitSet& changed, const std::map<uint32, double>* deadbands)
+{
+    if(*a.getStructure()!=*b.getStructure())
+        throw std::invalid_argument("structure definitions do not match");
+    else if(&a==&b)
+        return false;
+    return diffField(a, b, changed, deadbands);
+}
+
 }} // namespace epics::pvData
@@ -34,19 +34,78 @@ using std::string;
 
 namespace epics { namespace pvData {
 
-size_t Field::num_instances;
+epics::RefCounter Field::num_instances;
 
 
 struct Field::Helper {
+    static void mix(unsigned& H, size_t v) {
+        H = (H ^ unsigned(v)) * 16777619u;
+    }
+    template<typename FLD>
+    static void mixMembers(unsigned& H, const FLD *fld) {
+        mix(H, fld->getInternedID().hash());
+        const std::vector<InternedString>& names = fld->getInternedFieldNames();
+        const FieldConstPtrArray& fields = fld->getFields();
+        for(size_t i=0; i<fields.size(); i++) {
+            mix(H, names[i].hash());
+            mix(H, compute(fields[i].get()));
+        }
+    }
+    // Combine the hashes of the members of a Field.
+    // Sub-fields have already been cached, so their hash is known.
+    // Stable within this process.
+    static unsigned compute(const Field *fld) {
+        if(fld->m_hash)
+            return fld->m_hash;
+
+        unsigned H = 0xbadc0de1;
+        mix(H, fld->getType());
+        switch(fld->getType()) {
+        case scalar: {
+            const Scalar *S = static_cast<const Scalar*>(fld);
+            mix(H, S->getScalarType());
+            if(const BoundedString *B = dynamic_cast<const BoundedString*>(S))
+                mix(H, B->getMaximumLength());
+        }
+            break;
+        case scalarArray: {
+            const ScalarArray *A = static_cast<const ScalarArray*>(fld);
+            mix(H, A->getElementType());
+            mix(H, A->getArraySizeType());
+            mix(H, A->getMaximumCapacity());
+        }
+            break;
+        case structure:
+            mixMembers(H, static_cast<const Structure*>(fld));
+            break;
+        case union_:
+            mixMembers(H, static_cast<const Union*>(fld));
+            break;
+        case structureArray:
+            mix(H, compute(static_cast<const StructureArray*>(fld)->getStructure().get()));
+            break;
+        case unionArray:
+            mix(H, compute(static_cast<const UnionArray*>(fld)->getUnion().get()));
+            break;
+        }
+        return H;
+    }
     static unsigned hash(Field *fld) {
-        std::ostringstream key;
-        // hash the output of operator<<()
-        // not efficient, but stable within this process.
-        key<<(*fld);
-        unsigned H = epicsStrHash(key.str().c_str(), 0xbadc0de1);
+        unsigned H = compute(fld);
         fld->m_hash = H;
         return H;
     }
+    // Equal to compute() of a Structure or Union with these members, which need not exist
+    static unsigned members(Type type, const string& id, const StringArray& names, const FieldConstPtrArray& fields) {
+        unsigned H = 0xbadc0de1;
+        mix(H, type);
+        mix(H, InternedString::hashOf(id));
+        for(size_t i=0; i<fields.size(); i++) {
+            mix(H, InternedString::hashOf(names[i]));
+            mix(H, compute(fields[i].get()));
+        }
+        return H;
+    }
 };
 
 struct FieldCreate::Helper {
@@ -64,6 +123,7 @@ struct FieldCreate::Helper {
             if(centx && compare(*centx, *ent)) {
                 try{
                     ent = std::tr1::static_pointer_cast<FLD>(cent->shared_from_this());
+                    create->cacheHits++;
                     return;
                 }catch(std::tr1::bad_weak_ptr&){
                     // we're racing destruction.
@@ -75,8 +135,47 @@ struct FieldCreate::Helper {
         }
 
         create->cache.insert(std::make_pair(hash, ent.get()));
+        create->cacheMisses++;
         // cache cleaned from Field::~Field
     }
+
+    // Find a cached Structure or Union with these members before constructing one,
+    // so that a hit does not intern the ID and field names again.
+    template<typename FLD>
+    static bool find(const FieldCreate *create, Type type, const string& id, const StringArray& names,
+                     const FieldConstPtrArray& fields, std::tr1::shared_ptr<const FLD>& ret) {
+        if(names.size()!=fields.size())
+            return false;
+        for(size_t i=0; i<fields.size(); i++)
+            if(!fields[i])
+                return false;
+        unsigned hash = Field::Helper::members(type, id, names, fields);
+
+        Lock G(create->mutex);
+
+        std::pair<cache_t::iterator, cache_t::iterator> itp(create->cache.equal_range(hash));
+        for(; itp.first!=itp.second; ++itp.first) {
+            Field* cent(itp.first->second);
+            FLD* centx(dynamic_cast<FLD*>(cent));
+            if(!centx || centx->getInternedID().str()!=id || centx->getFieldNames()!=names)
+                continue;
+            const FieldConstPtrArray& cfields = centx->getFields();
+            bool match = true;
+            for(size_t i=0; match && i<fields.size(); i++)
+                match = *cfields[i]==*fields[i];
+            if(!match)
+                continue;
+            try{
+                ret = std::tr1::static_pointer_cast<const FLD>(cent->shared_from_this());
+                create->cacheHits++;
+                return true;
+            }catch(std::tr1::bad_weak_ptr&){
+                // racing destruction
+                continue;
+            }
+        }
+        return false;
+    }
 };
 
 Field::Field(Type type)
@@ -523,6 +622,10 @@ Structure::Structure (
       fields(infields),
       id(inid)
 {
+    internedNames.reserve(fieldNames.size());
+    for(size_t i=0, N=fieldNames.size(); i<N; i++)
+        internedNames.push_back(InternedString(fieldNames[i]));
+
     if(inid.empty()) {
         THROW_EXCEPTION2(std::invalid_argument, "Can't construct Structure, id is empty string");
     }
@@ -558,7 +661,7 @@ Structure::~Structure()
 
 string Structure::getID() const
 {
-    return id;
+    return id.str();
 }
 
 FieldConstPtr  Structure::getField(string const & fieldName) const {
@@ -570,6 +673,14 @@ FieldConstPtr  Structure::getField(string const & fieldName) const {
     return FieldConstPtr();
 }
 
+size_t Structure::getFieldIndex(InternedString const &fieldName) const {
+    for(size_t i=0, N=internedNames.size(); i<N; i++) {
+        if(fieldName==internedNames[i])
+            return i;
+    }
+    return -1;
+}
+
 size_t Structure::getFieldIndex(string const &fieldName) const {
     size_t numberFields = fields.size();
     for(size_t i=0; i<numberFields; i++) {
@@ -700,6 +811,10 @@ Union::Union (
       fields(infields),
       id(inid)
 {
+    internedNames.reserve(fieldNames.size());
+    for(size_t i=0, N=fieldNames.size(); i<N; i++)
+        internedNames.push_back(InternedString(fieldNames[i]));
+
     if(inid.empty()) {
         THROW_EXCEPTION2(std::invalid_argument, "Can't construct Union, id is empty string");
     }
@@ -774,7 +889,7 @@ int32 Union::guess(Type t, ScalarType s) const
 
 string Union::getID() const
 {
-    return id;
+    return id.str();
 }
 
 FieldConstPtr  Union::getField(string const & fieldName) const {
@@ -787,6 +902,14 @@ FieldConstPtr  Union::getField(string const & fieldName) const {
     return FieldConstPtr();
 }
 
+size_t Union::getFieldIndex(InternedString const &fieldName) const {
+    for(size_t i=0, N=internedNames.size(); i<N; i++) {
+        if(fieldName==internedNames[i])
+            return i;
+    }
+    return -1;
+}
+
 size_t Union::getFieldIndex(string const &fieldName) const {
     size_t numberFields = fields.size();
     for(size_t i=0; i<numberFields; i++) {
@@ -1333,6 +1456,9 @@ StructureConstPtr FieldCreate::createStructure (
     StringArray const & fieldNames,FieldConstPtrArray const & fields) const
 {
       validateFieldNames(fieldNames);
+      StructureConstPtr ret;
+      if(Helper::find(this, structure, Structure::defaultId(), fieldNames, fields, ret))
+          return ret;
       std::tr1::shared_ptr<Structure> sp(new Structure(fieldNames,fields));
       Helper::cache(this, sp);
       return sp;
@@ -1344,6 +1470,9 @@ StructureConstPtr FieldCreate::createStructure (
     FieldConstPtrArray const & fields) const
 {
       validateFieldNames(fieldNames);
+      StructureConstPtr ret;
+      if(Helper::find(this, structure, id, fieldNames, fields, ret))
+          return ret;
       std::tr1::shared_ptr<Structure> sp(new Structure(fieldNames,fields,id));
       Helper::cache(this, sp);
       return sp;
@@ -1361,6 +1490,9 @@ UnionConstPtr FieldCreate::createUnion (
     StringArray const & fieldNames,FieldConstPtrArray const & fields) const
 {
       validateFieldNames(fieldNames);
+      UnionConstPtr ret;
+      if(Helper::find(this, union_, Union::defaultId(), fieldNames, fields, ret))
+          return ret;
       std::tr1::shared_ptr<Union> sp(new Union(fieldNames,fields));
       Helper::cache(this, sp);
       return sp;
@@ -1372,6 +1504,9 @@ UnionConstPtr FieldCreate::createUnion (
     FieldConstPtrArray const & fields) const
 {
       validateFieldNames(fieldNames);
+      UnionConstPtr ret;
+      if(Helper::find(this, union_, id, fieldNames, fields, ret))
+          return ret;
       std::tr1::shared_ptr<Union> sp(new Union(fieldNames,fields,id));
       Helper::cache(this, sp);
       return sp;
@@ -1474,6 +1609,67 @@ static int decodeScalar(int8 code)
     }
 }
 
+namespace {
+size_t heapBytes(const std::string& s)
+{
+    static const size_t inplace = std::string().capacity();
+    return s.capacity() > inplace ? s.capacity()+1u : 0u;
+}
+
+template<typename FLD>
+size_t compositeBytes(const FLD& fld)
+{
+    const StringArray& names = fld.getFieldNames();
+    size_t ret = sizeof(FLD)
+            + fld.getFields().capacity()*sizeof(FieldConstPtr)
+            + names.capacity()*sizeof(std::string)
+            + fld.getInternedFieldNames().capacity()*sizeof(InternedString);
+    for(size_t i=0; i<names.size(); i++)
+        ret += heapBytes(names[i]);
+    return ret;
+}
+
+size_t fieldBytes(const Field *fld)
+{
+    // most derived first
+    if(const Structure *S = dynamic_cast<const Structure*>(fld))
+        return compositeBytes(*S);
+    else if(const Union *U = dynamic_cast<const Union*>(fld))
+        return compositeBytes(*U);
+    else if(dynamic_cast<const BoundedString*>(fld))
+        return sizeof(BoundedString);
+    else if(dynamic_cast<const BoundedScalarArray*>(fld))
+        return sizeof(BoundedScalarArray);
+    else if(dynamic_cast<const FixedScalarArray*>(fld))
+        return sizeof(FixedScalarArray);
+    else if(dynamic_cast<const StructureArray*>(fld))
+        return sizeof(StructureArray);
+    else if(dynamic_cast<const UnionArray*>(fld))
+        return sizeof(UnionArray);
+    else if(dynamic_cast<const ScalarArray*>(fld))
+        return sizeof(ScalarArray);
+    else
+        return sizeof(Scalar);
+}
+} // namespace
+
+FieldCreate::CacheStats FieldCreate::cacheStats() const
+{
+    // shared_ptr control block, and multimap node
+    const size_t overhead = 2u*sizeof(void*) + 2u*sizeof(int)
+                          + 4u*sizeof(void*) + sizeof(cache_t::value_type);
+    CacheStats ret;
+
+    Lock G(mutex);
+    ret.entries = cache.size();
+    ret.hits = cacheHits;
+    ret.misses = cacheMisses;
+    for(cache_t::const_iterator it(cache.begin()), end(cache.end()); it!=end; ++it)
+        ret.bytes += fieldBytes(it->second) + overhead;
+
+    return ret;
+}
+
 FieldConstPtr FieldCreate::deserialize(ByteBuffer* buffer, DeserializableControl* control) const
 {
     control->ensureData(1);
@@ -1628,6 +1824,9 @@ const FieldCreatePtr& FieldCreate::getFieldCreate()
 }
 
 FieldCreate::FieldCreate()
+    :mutex("FieldCreate")
+    ,cacheHits(0u)
+    ,cacheMisses(0u)
 {
     for (int i = 0; i <= MAX_SCALAR_TYPE; i++)
     {
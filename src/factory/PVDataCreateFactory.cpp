@@ -22,6 +22,7 @@
 #include <pv/factory.h>
 #include <pv/serializeHelper.h>
 #include <pv/reftrack.h>
+#include <pv/arrayAllocator.h>
 
 using std::tr1::static_pointer_cast;
 using std::size_t;
@@ -281,8 +282,17 @@ void PVValueArray<T>::setLength(size_t length)
 
     if (length < value.size())
         value.slice(0, length);
-    else
+    else if (value.unique() && length <= value.capacity())
         value.resize(length);
+    else {
+        svector next(allocate_shared_vector<T>(std::max(length, value.capacity())));
+        std::copy(value.begin(), value.end(), next.begin());
+        // zero all of the spare capacity, which may be re-used storage,
+        // as a later setLength() may grow into it in place.
+        std::fill(next.begin()+value.size(), next.end(), T());
+        next.resize(length);
+        value = freeze(next);
+    }
 }
 
 template<typename T>
@@ -320,8 +330,13 @@ void PVValueArray<T>::deserialize(ByteBuffer *pbuffer,
                 this->getArray()->getMaximumCapacity() :
                 SerializeHelper::readSize(pbuffer, pcontrol);
 
-    svector nextvalue(thaw(value));
-    nextvalue.resize(size); // TODO: avoid copy of stuff we will then overwrite
+    // all elements will be overwritten, so never copy the old value.
+    svector nextvalue;
+    if(value.unique())
+        nextvalue = thaw(value);
+    else
+        value.clear();
+    resize_for_overwrite(nextvalue, size, ArrayAllocator::CacheLine);
 
     T* cur = nextvalue.data();
 
@@ -330,6 +345,7 @@ void PVValueArray<T>::deserialize(ByteBuffer *pbuffer,
     if (!pbuffer->reverse<T>())
         if (pcontrol->directDeserialize(pbuffer, (char*)cur, size, sizeof(T)))
         {
+        value = freeze(nextvalue);
         // inform about the change?
         PVField::postPut();
         return;
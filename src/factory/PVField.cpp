@@ -10,6 +10,7 @@
 #include <cstdlib>
 #include <string>
 #include <cstdio>
+#include <ostream>
 
 #include <epicsMutex.h>
 
@@ -23,9 +24,148 @@ using std::tr1::const_pointer_cast;
 using std::size_t;
 using std::string;
 
+namespace {
+using namespace epics::pvData;
+
+// Estimated size of a shared_ptr control block.  vtable, use and weak counts, and pointer
+const size_t ctrlBlockBytes = 2u*sizeof(void*) + 2u*sizeof(int);
+
+size_t heapBytes(const std::string& s)
+{
+    static const size_t inplace = std::string().capacity();
+    return s.capacity() > inplace ? s.capacity()+1u : 0u;
+}
+
+template<typename T>
+size_t elementHeapBytes(const shared_vector<const T>&) { return 0u; }
+
+template<>
+size_t elementHeapBytes(const shared_vector<const std::string>& value)
+{
+    size_t ret = 0u;
+    for(size_t i=0; i<value.size(); i++)
+        ret += heapBytes(value[i]);
+    return ret;
+}
+
+// Storage, and control block, of an array held by a PVField.
+// 'value' is a copy, so an exclusively owned buffer has two references.
+template<typename T>
+bool arrayUsage(const shared_vector<const T>& value, MemoryUsage& U)
+{
+    if(!value.dataPtr())
+        return true;
+    size_t bytes = (value.dataOffset()+value.dataTotal())*sizeof(T) + elementHeapBytes(value);
+    if(value.dataPtr().use_count()<=2) {
+        U.exclusiveArrayBytes += bytes;
+        U.controlBlockBytes += ctrlBlockBytes;
+        return true;
+    } else {
+        U.sharedArrayBytes += bytes + ctrlBlockBytes;
+        return false;
+    }
+}
+
+template<typename T>
+void scalarUsage(const PVField& fld, MemoryUsage& U)
+{
+    U.objectBytes += sizeof(PVScalarValue<T>);
+}
+
+template<>
+void scalarUsage<std::string>(const PVField& fld, MemoryUsage& U)
+{
+    U.objectBytes += sizeof(PVString);
+    U.stringBytes += heapBytes(static_cast<const PVString&>(fld).get());
+}
+
+template<typename T>
+void scalarArrayUsage(const PVField& fld, MemoryUsage& U)
+{
+    U.objectBytes += sizeof(PVValueArray<T>);
+    arrayUsage(static_cast<const PVValueArray<T>&>(fld).view(), U);
+}
+
+void fieldUsage(const PVField& fld, MemoryUsage& U);
+
+// elements of a structure or union array
+template<typename A>
+void elementsUsage(const A& arr, MemoryUsage& U)
+{
+    U.objectBytes += sizeof(A);
+    typename A::const_svector value(arr.view());
+    MemoryUsage E;
+    for(size_t i=0; i<value.size(); i++) {
+        if(value[i])
+            fieldUsage(*value[i], E);
+    }
+    if(arrayUsage(value, U)) {
+        U += E;
+    } else {
+        // elements are shared along with the array storage
+        U.fields += E.fields;
+        U.sharedArrayBytes += E.total();
+    }
+}
+
+void fieldUsage(const PVField& fld, MemoryUsage& U)
+{
+    U.fields++;
+    U.controlBlockBytes += ctrlBlockBytes;
+
+    switch(fld.getField()->getType()) {
+    case scalar:
+        switch(static_cast<const Scalar*>(fld.getField().get())->getScalarType()) {
+#define CASE(BASETYPE, PVATYPE, DBFTYPE, PVACODE) case pv ## PVACODE: scalarUsage<PVATYPE>(fld, U); break;
+#define CASE_REAL_INT64
+#define CASE_STRING
+#include "pv/typemap.h"
+#undef CASE_REAL_INT64
+#undef CASE_STRING
+#undef CASE
+        }
+        break;
+    case scalarArray:
+        switch(static_cast<const ScalarArray*>(fld.getField().get())->getElementType()) {
+#define CASE(BASETYPE, PVATYPE, DBFTYPE, PVACODE) case pv ## PVACODE: scalarArrayUsage<PVATYPE>(fld, U); break;
+#define CASE_REAL_INT64
+#define CASE_STRING
+#include "pv/typemap.h"
+#undef CASE_REAL_INT64
+#undef CASE_STRING
+#undef CASE
+        }
+        break;
+    case structure: {
+        const PVStructure& S = static_cast<const PVStructure&>(fld);
+        const PVFieldPtrArray& fields = S.getPVFields();
+        U.objectBytes += sizeof(PVStructure) + fields.capacity()*sizeof(PVFieldPtr);
+        for(size_t i=0; i<fields.size(); i++)
+            fieldUsage(*fields[i], U);
+    }
+        break;
+    case structureArray:
+        elementsUsage(static_cast<const PVStructureArray&>(fld), U);
+        break;
+    case union_: {
+        const PVUnion& V = static_cast<const PVUnion&>(fld);
+        U.objectBytes += sizeof(PVUnion);
+        PVField::const_shared_pointer value(V.get());
+        if(value)
+            fieldUsage(*value, U);
+    }
+        break;
+    case unionArray:
+        elementsUsage(static_cast<const PVUnionArray&>(fld), U);
+        break;
+    }
+}
+
+} // namespace
+
 namespace epics { namespace pvData {
 
-size_t PVField::num_instances;
+epics::RefCounter PVField::num_instances;
 
 PVField::PVField(FieldConstPtr field)
 : parent(NULL),field(field),
@@ -41,6 +181,25 @@ PVField::~PVField()
 }
 
 
+MemoryUsage PVField::memoryUsage() const
+{
+    MemoryUsage ret;
+    fieldUsage(*this, ret);
+    return ret;
+}
+
+std::ostream& operator<<(std::ostream& o, const MemoryUsage& usage)
+{
+    o<<"fields: "<<usage.fields<<"\n"
+       "objects: "<<usage.objectBytes<<" bytes\n"
+       "string values: "<<usage.stringBytes<<" bytes\n"
+       "exclusive arrays: "<<usage.exclusiveArrayBytes<<" bytes\n"
+       "shared arrays: "<<usage.sharedArrayBytes<<" bytes\n"
+       "control blocks: "<<usage.controlBlockBytes<<" bytes\n"
+       "total: "<<usage.total()<<" bytes ("<<usage.exclusive()<<" exclusive)\n";
+    return o;
+}
+
 size_t PVField::getFieldOffset() const
 {
     if(nextFieldOffset==0) computeOffset(this);
@@ -64,7 +223,17 @@ void PVField::setImmutable() {immutable = true;}
 
 void PVField::postPut()
 {
-   if(postHandler) postHandler->postPut();
+    // Defer to the innermost active Transaction, if any.
+    // Parent chains are short, so this costs little when there is none.
+    for(PVStructure *S = field->getType()==structure ? static_cast<PVStructure*>(this) : parent;
+        S; S = S->parent)
+    {
+        if(S->transaction) {
+            S->transaction->posted.set(static_cast<uint32>(getFieldOffset()));
+            return;
+        }
+    }
+    if(postHandler) postHandler->postPut();
 }
 
 void PVField::setPostHandler(PostHandlerPtr const &handler)
@@ -78,7 +247,7 @@ void PVField::setPostHandler(PostHandlerPtr const &handler)
     postHandler = handler;
 }
 
-void PVField::setParentAndName(PVStructure * xxx,string const & name)
+void PVField::setParentAndName(PVStructure * xxx,InternedString const & name)
 {
     parent = xxx;
     fieldName = name;
@@ -96,7 +265,7 @@ std::ostream& operator<<(std::ostream& o, const PVField& f)
 
 string PVField::getFullName() const
 {
-    string ret(fieldName);
+    string ret(fieldName.str());
     for(const PVField *fld=getParent(); fld; fld=fld->getParent())
     {
         if(fld->getFieldName().size()==0) break;
@@ -29,4 +29,28 @@ namespace epics { namespace pvData {
        return static_pointer_cast<const ScalarArray>(PVField::getField());
     }
 
+    bool PVScalarArray::deduplicate(ArrayDedup& pool, bool includeMutable)
+    {
+        if(!includeMutable && !isImmutable())
+            return false;
+
+        shared_vector<const void> cur;
+        _getAsVoid(cur);
+        shared_vector<const void> next(pool.dedup(cur));
+        if(next.dataPtr()==cur.dataPtr())
+            return false;
+
+        switch(getScalarArray()->getElementType()) {
+#define CASE(BASETYPE, PVATYPE, DBFTYPE, PVACODE) case pv ## PVACODE: \
+        static_cast<PVValueArray<PVATYPE>*>(this)->value = static_shared_vector_cast<const PVATYPE>(next); break;
+#define CASE_REAL_INT64
+#define CASE_STRING
+#include "pv/typemap.h"
+#undef CASE_REAL_INT64
+#undef CASE_STRING
+#undef CASE
+        }
+        return true;
+    }
+
 }}
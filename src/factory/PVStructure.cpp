@@ -11,6 +11,7 @@
 #include <string>
 #include <cstdio>
 #include <vector>
+#include <iostream>
 
 #define epicsExportSharedSymbols
 #include <pv/pvData.h>
@@ -27,11 +28,12 @@ namespace epics { namespace pvData {
 PVStructure::PVStructure(StructureConstPtr const & structurePtr)
 : PVField(structurePtr),
   structurePtr(structurePtr),
-  extendsStructureName("")
+  extendsStructureName(""),
+  transaction(0)
 {
     size_t numberFields = structurePtr->getNumberFields();
     FieldConstPtrArray const & fields = structurePtr->getFields();
-    StringArray const & fieldNames = structurePtr->getFieldNames();
+    std::vector<InternedString> const & fieldNames = structurePtr->getInternedFieldNames();
     pvFields.reserve(numberFields);
     PVDataCreatePtr pvDataCreate = getPVDataCreate();
     for(size_t i=0; i<numberFields; i++) {
@@ -47,10 +49,11 @@ PVStructure::PVStructure(StructureConstPtr const & structurePtr,
 )
 : PVField(structurePtr),
   structurePtr(structurePtr),
-  extendsStructureName("")
+  extendsStructureName(""),
+  transaction(0)
 {
     size_t numberFields = structurePtr->getNumberFields();
-    StringArray const & fieldNames = structurePtr->getFieldNames();
+    std::vector<InternedString> const & fieldNames = structurePtr->getInternedFieldNames();
     pvFields.reserve(numberFields);
     for(size_t i=0; i<numberFields; i++) {
         pvFields.push_back(pvs[i]);
@@ -72,6 +75,48 @@ void PVStructure::setImmutable()
     PVField::setImmutable();
 }
 
+namespace {
+size_t dedupField(PVField& fld, ArrayDedup& pool, bool includeMutable)
+{
+    switch(fld.getField()->getType()) {
+    case scalarArray:
+        return static_cast<PVScalarArray&>(fld).deduplicate(pool, includeMutable) ? 1u : 0u;
+    case structure:
+        return static_cast<PVStructure&>(fld).deduplicate(pool, includeMutable);
+    case union_: {
+        PVFieldPtr value(static_cast<PVUnion&>(fld).get());
+        return value ? dedupField(*value, pool, includeMutable) : 0u;
+    }
+    case structureArray: {
+        PVStructureArray::const_svector elems(static_cast<PVStructureArray&>(fld).view());
+        size_t ret = 0u;
+        for(size_t i=0; i<elems.size(); i++)
+            if(elems[i])
+                ret += elems[i]->deduplicate(pool, includeMutable);
+        return ret;
+    }
+    case unionArray: {
+        PVUnionArray::const_svector elems(static_cast<PVUnionArray&>(fld).view());
+        size_t ret = 0u;
+        for(size_t i=0; i<elems.size(); i++)
+            if(elems[i])
+                ret += dedupField(*elems[i], pool, includeMutable);
+        return ret;
+    }
+    default:
+        return 0u;
+    }
+}
+} // namespace
+
+size_t PVStructure::deduplicate(ArrayDedup& pool, bool includeMutable)
+{
+    size_t ret = 0u;
+    for(size_t i=0, N=pvFields.size(); i<N; i++)
+        ret += dedupField(*pvFields[i], pool, includeMutable);
+    return ret;
+}
+
 PVFieldPtr  PVStructure::getSubFieldImpl(size_t fieldOffset, bool throws) const
 {
     const PVStructure *current = this;
@@ -374,30 +419,100 @@ void PVStructure::copyUnchecked(const PVStructure& from, const BitSet& maskBitSe
     PVFieldPtrArray const & fromPVFields = from.getPVFields();
     PVFieldPtrArray const & toPVFields = getPVFields();
 
-    size_t fieldsSize = fromPVFields.size();
-    for(size_t i = 0; i<fieldsSize; i++) {
-        PVFieldPtr pvField = fromPVFields[i];
-        offset = pvField->getFieldOffset();
-        int32 inumberFields = static_cast<int32>(pvField->getNumberFields());
-        next = inverse ?
-                    maskBitSet.nextClearBit(static_cast<uint32>(offset)) :
-                    maskBitSet.nextSetBit(static_cast<uint32>(offset));
-
-        // no more changes
-        if(next<0) return;
-        //  no change in this pvField
-        if(next>=static_cast<int32>(offset+inumberFields)) continue;
+    // Visit only those sub-fields which contain a selected bit,
+    // so that the cost follows the number of changes, not the number of fields.
+    const size_t end = offset+numberFields;
+    size_t first = 0u;
+    while(next>=0 && static_cast<size_t>(next)<end) {
+        // sub-fields are ordered by offset.  find the last starting at or before 'next'
+        size_t lo = first, hi = fromPVFields.size();
+        while(hi-lo>1u) {
+            size_t mid = lo+(hi-lo)/2u;
+            if(fromPVFields[mid]->getFieldOffset()<=static_cast<size_t>(next))
+                lo = mid;
+            else
+                hi = mid;
+        }
 
-        // serialize field or fields
-        if(inumberFields==1) {
-            toPVFields[i]->copyUnchecked(*pvField);
+        const PVField& pvField = *fromPVFields[lo];
+        if(pvField.getNumberFields()==1) {
+            toPVFields[lo]->copyUnchecked(pvField);
         } else {
-            PVStructure::shared_pointer fromPVStructure = std::tr1::static_pointer_cast<PVStructure>(pvField);
-            PVStructure::shared_pointer toPVStructure = std::tr1::static_pointer_cast<PVStructure>(toPVFields[i]);
-            toPVStructure->copyUnchecked(*fromPVStructure, maskBitSet, inverse);
-       }
+            static_cast<PVStructure&>(*toPVFields[lo]).copyUnchecked(static_cast<const PVStructure&>(pvField), maskBitSet, inverse);
+        }
+
+        first = lo+1u;
+        const uint32 skip = static_cast<uint32>(pvField.getNextFieldOffset());
+        next = inverse ? maskBitSet.nextClearBit(skip) : maskBitSet.nextSetBit(skip);
+    }
+}
+
+namespace {
+void postSubFields(PVStructure& top, const BitSet& posted)
+{
+    const int32 self = static_cast<int32>(top.getFieldOffset());
+    for(int32 i = posted.nextSetBit(self+1); i>=0; i = posted.nextSetBit(i+1)) {
+        PVFieldPtr fld(top.getSubField(static_cast<size_t>(i)));
+        if(fld)
+            fld->postPut();
+    }
+}
+}
+
+void PostHandler::postTransaction(PVStructure& top, const BitSet& changed)
+{
+    postSubFields(top, changed);
+    postPut();
+}
+
+void PVStructure::postTransaction(const BitSet& posted)
+{
+    // no Transaction is active, so handlers may put() again, which posts immediately.
+    try {
+        if(postHandler)
+            postHandler->postTransaction(*this, posted);
+        else
+            postSubFields(*this, posted);
+    } catch(std::exception& e) {
+        std::cerr<<"Unhandled exception from PostHandler : "<<e.what()<<"\n";
     }
 }
 
+PVStructure::Transaction::Transaction(PVStructure& top)
+    :owner(&top)
+    ,active(this)
+    ,depth(1u)
+{
+    for(PVStructure *S = &top; S; S = S->parent) {
+        if(S->transaction) {
+            owner = S;
+            active = S->transaction;
+            active->depth++;
+            return;
+        }
+    }
+    top.transaction = this;
+}
+
+PVStructure::Transaction::~Transaction()
+{
+    if(--active->depth)
+        return;
+
+    owner->transaction = 0;
+
+    if(posted.isEmpty())
+        return;
+
+    // a Transaction on a parent began after ours, so is delivered after ours
+    for(PVStructure *S = owner->parent; S; S = S->parent) {
+        if(S->transaction) {
+            S->transaction->posted |= posted;
+            return;
+        }
+    }
+
+    owner->postTransaction(posted);
+}
 
 }}
@@ -0,0 +1,397 @@
+/* ValueHash.cpp */
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <map>
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string.h>
+
+#include <epicsGuard.h>
+#include <epicsMutex.h>
+#include <epicsThread.h>
+
+// SSE2 is always available on x86_64
+#if defined(__SSE2__) || defined(_M_X64)
+#  include <emmintrin.h>
+#  define PVD_HASH_SSE2
+#endif
+
+#define epicsExportSharedSymbols
+#include <pv/pvData.h>
+#include <pv/bitSet.h>
+
+namespace {
+using namespace epics::pvData;
+
+typedef epicsGuard<epicsMutex> Guard;
+
+#define HASH_U64(HI, LO) ((uint64(HI##u)<<32) | uint64(LO##u))
+
+const uint64 prime = HASH_U64(0x9E3779B1, 0x85EBCA87);
+
+// Constants xor'd with input in each of eight 64-bit lanes
+const uint64 secret[8] = {
+    HASH_U64(0xbe4ba423, 0x396cfeb8), HASH_U64(0x1cad21f7, 0x2c81017c),
+    HASH_U64(0xdb979083, 0xe96dd4de), HASH_U64(0x1f67b3b7, 0xa4a44072),
+    HASH_U64(0x78e5c0cc, 0x4ee679cb), HASH_U64(0x2172ffcc, 0x7dd05a82),
+    HASH_U64(0x8e2443f7, 0x744608b8), HASH_U64(0x4c263a81, 0xe69035e0),
+};
+
+// finalizer of MurmurHash3
+inline uint64 fmix(uint64 h)
+{
+    h ^= h>>33;
+    h *= HASH_U64(0xff51afd7, 0xed558ccd);
+    h ^= h>>33;
+    h *= HASH_U64(0xc4ceb9fe, 0x1a85ec53);
+    h ^= h>>33;
+    return h;
+}
+
+inline uint64 combine(uint64 h, uint64 v)
+{
+    return fmix(h ^ (v*prime));
+}
+
+/* Hash of a byte stream, in the manner of the XXH3 accumulate loop.
+ * Each 64 byte stripe is added into eight 64-bit lanes, as a 32x32 bit product,
+ * which SSE2 computes two lanes at a time.  The result does not depend on SSE2.
+ * Assumes little endian when SSE2 is used.
+ */
+struct Hasher {
+    uint64 acc[8];
+    unsigned char buf[64];
+    size_t nbuf;
+    uint64 total;
+
+    explicit Hasher(uint64 seed) :nbuf(0u), total(0u)
+    {
+        for(unsigned i=0; i<8; i++)
+            acc[i] = seed ^ secret[(i+1u)&7u];
+    }
+
+    void stripes(const unsigned char *p, size_t n)
+    {
+#ifdef PVD_HASH_SSE2
+        __m128i A[4];
+        for(unsigned j=0; j<4; j++)
+            A[j] = _mm_loadu_si128((const __m128i*)&acc[2*j]);
+        for(; n; n--, p+=64) {
+            for(unsigned j=0; j<4; j++) {
+                __m128i d = _mm_loadu_si128((const __m128i*)(p+16*j));
+                __m128i k = _mm_xor_si128(d, _mm_loadu_si128((const __m128i*)&secret[2*j]));
+                __m128i prod = _mm_mul_epu32(k, _mm_shuffle_epi32(k, _MM_SHUFFLE(0,3,0,1)));
+                A[j] = _mm_add_epi64(A[j], _mm_add_epi64(prod, _mm_shuffle_epi32(d, _MM_SHUFFLE(1,0,3,2))));
+            }
+        }
+        for(unsigned j=0; j<4; j++)
+            _mm_storeu_si128((__m128i*)&acc[2*j], A[j]);
+#else
+        for(; n; n--, p+=64) {
+            for(unsigned i=0; i<8; i++) {
+                uint64 d = 0u;
+                for(unsigned b=0; b<8; b++)
+                    d |= uint64(p[8*i+b])<<(8*b);
+                const uint64 k = d ^ secret[i];
+                acc[i^1u] += d;
+                acc[i] += (k&0xffffffffu)*(k>>32);
+            }
+        }
+#endif
+    }
+
+    void update(const void *raw, size_t len)
+    {
+        const unsigned char *p = static_cast<const unsigned char*>(raw);
+        total += len;
+        if(nbuf) {
+            size_t n = std::min(len, sizeof(buf)-nbuf);
+            memcpy(buf+nbuf, p, n);
+            nbuf += n;
+            p += n;
+            len -= n;
+            if(nbuf<sizeof(buf))
+                return;
+            stripes(buf, 1u);
+            nbuf = 0u;
+        }
+        stripes(p, len/64u);
+        p += len&~size_t(63u);
+        len &= 63u;
+        memcpy(buf, p, len);
+        nbuf = len;
+    }
+
+    uint64 finish()
+    {
+        // zero padded.  total distinguishes trailing zeros.
+        if(nbuf) {
+            memset(buf+nbuf, 0, sizeof(buf)-nbuf);
+            stripes(buf, 1u);
+        }
+        uint64 h = total*prime;
+        for(unsigned i=0; i<8; i++)
+            h = combine(h, acc[i]);
+        return h;
+    }
+};
+
+// operator== finds 0.0 and -0.0 equal.  Adding 0.0 changes -0.0 to 0.0, and nothing else.
+template<typename T>
+void hashFloats(Hasher& H, const T* v, size_t n)
+{
+    T temp[64];
+    while(n) {
+        const size_t c = std::min(n, size_t(64u));
+        for(size_t i=0; i<c; i++)
+            temp[i] = v[i] + T(0);
+        H.update(temp, c*sizeof(T));
+        v += c;
+        n -= c;
+    }
+}
+
+template<typename T>
+void hashElements(Hasher& H, const T* v, size_t n)
+{
+    H.update(v, n*sizeof(T));
+}
+
+void hashElements(Hasher& H, const float* v, size_t n) { hashFloats(H, v, n); }
+void hashElements(Hasher& H, const double* v, size_t n) { hashFloats(H, v, n); }
+
+void hashElements(Hasher& H, const std::string* v, size_t n)
+{
+    for(size_t i=0; i<n; i++) {
+        const uint64 len = v[i].size();
+        H.update(&len, sizeof(len));
+        H.update(v[i].c_str(), v[i].size());
+    }
+}
+
+/* Cache of the hashes of large array buffers, keyed by address.
+ * An entry holds a reference to the buffer, which can then not be thaw()'d
+ * and modified in place, so the cached hash remains correct.
+ * Entries for buffers no longer referenced elsewhere are dropped on each insert.
+ */
+struct hashcache_t {
+    epicsMutex lock;
+    struct Entry {
+        shared_vector<const void> ref;
+        ScalarType type;
+        uint64 hash;
+    };
+    typedef std::multimap<const void*, Entry> entries_t;
+    entries_t entries;
+    size_t bytes; // retained by entries
+    hashcache_t() :bytes(0u) {}
+} *hashcache;
+
+// Only cache buffers of at least this many bytes
+const size_t cacheThreshold = 4096u;
+const size_t cacheLimit = 256u;
+// Limit on the total size of the buffers held by the cache
+const size_t cacheByteLimit = 64u*1024u*1024u;
+
+void hashcache_init(void *)
+{
+    try {
+        hashcache = new hashcache_t;
+    } catch(std::exception& e) {
+        std::cerr<<"Failed to create array hash cache :"<<e.what()<<"\n";
+    }
+}
+
+epicsThreadOnceId hashcache_once = EPICS_THREAD_ONCE_INIT;
+
+template<typename T>
+uint64 hashArray(const shared_vector<const T>& value, ScalarType type)
+{
+    const size_t nbytes = value.size()*sizeof(T);
+    // besides the PVScalarArray and the caller's view(), someone else holds this buffer
+    const bool cachable = nbytes>=cacheThreshold && nbytes<=cacheByteLimit && value.dataPtr().use_count()>2;
+
+    if(cachable) {
+        epicsThreadOnce(&hashcache_once, &hashcache_init, 0);
+        if(!hashcache)
+            throw std::runtime_error("Failed to create array hash cache");
+
+        Guard G(hashcache->lock);
+        std::pair<hashcache_t::entries_t::iterator, hashcache_t::entries_t::iterator> itp(hashcache->entries.equal_range(value.data()));
+        for(; itp.first!=itp.second; ++itp.first) {
+            const hashcache_t::Entry& E = itp.first->second;
+            if(E.type==type && E.ref.size()==nbytes)
+                return E.hash;
+        }
+    }
+
+    Hasher H(type);
+    hashElements(H, value.data(), value.size());
+    const uint64 hash = H.finish();
+
+    if(cachable) {
+        hashcache_t::Entry E;
+        E.ref = static_shared_vector_cast<const void>(value);
+        E.type = type;
+        E.hash = hash;
+
+        // release buffers outside of the lock
+        hashcache_t::entries_t junk;
+        {
+            Guard G(hashcache->lock);
+            // drop entries no longer referenced elsewhere
+            for(hashcache_t::entries_t::iterator it(hashcache->entries.begin()), end(hashcache->entries.end()); it!=end; ) {
+                hashcache_t::entries_t::iterator cur(it++);
+                if(cur->second.ref.dataPtr().use_count()==1) {
+                    hashcache->bytes -= cur->second.ref.size();
+                    junk.insert(*cur);
+                    hashcache->entries.erase(cur);
+                }
+            }
+            // if still full, drop all
+            if(hashcache->entries.size()>=cacheLimit || hashcache->bytes+nbytes>cacheByteLimit) {
+                junk.insert(hashcache->entries.begin(), hashcache->entries.end());
+                hashcache->entries.clear();
+                hashcache->bytes = 0u;
+            }
+            hashcache->entries.insert(std::make_pair(value.data(), E));
+            hashcache->bytes += nbytes;
+        }
+    }
+    return hash;
+}
+
+uint64 hashField(const PVField& fld);
+
+uint64 hashScalar(const PVScalar& fld)
+{
+    const ScalarType type = fld.getScalar()->getScalarType();
+    uint64 bits = 0u;
+    switch(type) {
+#define CASE(BASETYPE, PVATYPE, DBFTYPE, PVACODE) case pv ## PVACODE: { \
+        PVATYPE v = static_cast<const PVScalarValue<PVATYPE>&>(fld).get() + PVATYPE(0); \
+        memcpy(&bits, &v, sizeof(v)); break; }
+#define CASE_REAL_INT64
+#include "pv/typemap.h"
+#undef CASE_REAL_INT64
+#undef CASE
+    case pvString: {
+        const std::string& v = static_cast<const PVString&>(fld).get();
+        Hasher H(type);
+        H.update(v.c_str(), v.size());
+        return H.finish();
+    }
+    }
+    return combine(type, bits);
+}
+
+uint64 hashScalarArray(const PVScalarArray& fld)
+{
+    const ScalarType type = fld.getScalarArray()->getElementType();
+    switch(type) {
+#define CASE(BASETYPE, PVATYPE, DBFTYPE, PVACODE) case pv ## PVACODE: \
+        return hashArray(static_cast<const PVValueArray<PVATYPE>&>(fld).view(), type);
+#define CASE_REAL_INT64
+#define CASE_STRING
+#include "pv/typemap.h"
+#undef CASE_REAL_INT64
+#undef CASE_STRING
+#undef CASE
+    }
+    throw std::logic_error("PVScalarArray with invalid element type!");
+}
+
+uint64 hashUnion(const PVUnion& fld)
+{
+    uint64 h = combine(union_, uint64(fld.getSelectedIndex()));
+    const PVField::const_shared_pointer& value = fld.get();
+    if(value)
+        h = combine(h, hashField(*value));
+    return h;
+}
+
+template<typename A>
+uint64 hashElementArray(const A& fld, Type type)
+{
+    typename A::const_svector elems(fld.view());
+    uint64 h = combine(type, elems.size());
+    for(size_t i=0, N=elems.size(); i<N; i++)
+        h = combine(h, elems[i] ? hashField(*elems[i]) : 0u);
+    return h;
+}
+
+uint64 hashStructure(const PVStructure& fld)
+{
+    const PVFieldPtrArray& fields = fld.getPVFields();
+    uint64 h = combine(structure, fields.size());
+    for(size_t i=0, N=fields.size(); i<N; i++)
+        h = combine(h, hashField(*fields[i]));
+    return h;
+}
+
+uint64 hashField(const PVField& fld)
+{
+    switch(fld.getField()->getType()) {
+    case scalar: return hashScalar(static_cast<const PVScalar&>(fld));
+    case scalarArray: return hashScalarArray(static_cast<const PVScalarArray&>(fld));
+    case structure: return hashStructure(static_cast<const PVStructure&>(fld));
+    case structureArray: return hashElementArray(static_cast<const PVStructureArray&>(fld), structureArray);
+    case union_: return hashUnion(static_cast<const PVUnion&>(fld));
+    case unionArray: return hashElementArray(static_cast<const PVUnionArray&>(fld), unionArray);
+    }
+    throw std::logic_error("PVField with invalid type!");
+}
+
+// Visits only those sub-fields containing a selected bit, as does PVStructure::copyUnchecked()
+uint64 hashMasked(const PVStructure& fld, const BitSet& mask, uint64 h)
+{
+    const size_t offset = fld.getFieldOffset(), end = offset+fld.getNumberFields();
+    int32 next = mask.nextSetBit(static_cast<uint32>(offset));
+
+    if(next<0 || static_cast<size_t>(next)>=end)
+        return h;
+    else if(static_cast<size_t>(next)==offset)
+        return combine(combine(h, offset), hashStructure(fld));
+
+    const PVFieldPtrArray& fields = fld.getPVFields();
+    size_t first = 0u;
+    while(next>=0 && static_cast<size_t>(next)<end) {
+        size_t lo = first, hi = fields.size();
+        while(hi-lo>1u) {
+            size_t mid = lo+(hi-lo)/2u;
+            if(fields[mid]->getFieldOffset()<=static_cast<size_t>(next))
+                lo = mid;
+            else
+                hi = mid;
+        }
+
+        const PVField& sub = *fields[lo];
+        if(sub.getNumberFields()==1)
+            h = combine(combine(h, sub.getFieldOffset()), hashField(sub));
+        else
+            h = hashMasked(static_cast<const PVStructure&>(sub), mask, h);
+
+        first = lo+1u;
+        next = mask.nextSetBit(static_cast<uint32>(sub.getNextFieldOffset()));
+    }
+    return h;
+}
+
+} // namespace
+
+namespace epics { namespace pvData {
+
+size_t PVField::hashValue() const
+{
+    return size_t(hashField(*this));
+}
+
+size_t PVStructure::hashValue(const BitSet& mask) const
+{
+    return size_t(fmix(hashMasked(*this, mask, prime)));
+}
+
+}} // namespace epics::pvData
@@ -9,9 +9,11 @@
 #include <string>
 #include <stdexcept>
 #include <memory>
+#include <algorithm>
 
 #define epicsExportSharedSymbols
 #include <pv/pvSubArrayCopy.h>
+#include <pv/arrayAllocator.h>
 
 using std::cout;
 using std::endl;
@@ -37,12 +39,41 @@ void copy(
     size_t newLength = toOffset + count*toStride;
     size_t capacity = pvTo.getCapacity();
     if(newLength>capacity) capacity = newLength;
-    shared_vector<T> temp(capacity);
+    {
+        // as replace() would, but before the old value may be modified in place
+        const Array& type = *pvTo.getArray();
+        if(type.getArraySizeType()==Array::fixed && capacity!=type.getMaximumCapacity())
+            throw std::invalid_argument("invalid length for a fixed size array");
+        else if(type.getArraySizeType()==Array::bounded && capacity>type.getMaximumCapacity())
+            throw std::invalid_argument("new array capacity too large for a bounded size array");
+    }
     typename PVValueArray<T>::const_svector vecFrom = pvFrom.view();
-    typename PVValueArray<T>::const_svector vecTo = pvTo.view();
-    for(size_t i=0; i<pvTo.getLength(); ++i) temp[i] = vecTo[i];
-    for(size_t i=pvTo.getLength(); i< capacity; ++i) temp[i] = T();
-    for(size_t i=0; i<count; ++i) temp[i*toStride + toOffset] = vecFrom[i*fromStride+fromOffset];
+    shared_vector<T> temp;
+    size_t toLength;
+    {
+        typename PVValueArray<T>::const_svector vecTo;
+        pvTo.swap(vecTo);
+        toLength = vecTo.size();
+        if(vecTo.unique() && capacity<=vecTo.capacity()) {
+            // no one else can see the old value, so modify it in place
+            temp = thaw(vecTo);
+            temp.resize(capacity);
+        } else {
+            try {
+                temp = allocate_shared_vector<T>(capacity, ArrayAllocator::CacheLine);
+                std::copy(vecTo.begin(), vecTo.end(), temp.begin());
+            } catch(...) {
+                pvTo.swap(vecTo);
+                throw;
+            }
+        }
+    }
+    std::fill(temp.begin()+toLength, temp.end(), T());
+    if(fromStride==1 && toStride==1) {
+        std::copy(vecFrom.begin()+fromOffset, vecFrom.begin()+fromOffset+count, temp.begin()+toOffset);
+    } else {
+        for(size_t i=0; i<count; ++i) temp[i*toStride + toOffset] = vecFrom[i*fromStride+fromOffset];
+    }
     shared_vector<const T> temp2(freeze(temp));
     pvTo.replace(temp2);
 }
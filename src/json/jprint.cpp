@@ -302,4 +302,40 @@ void printJSON(std::ostream& strm,
     show_field(A, &val, 0);
 }
 
+NDJSONWriter::NDJSONWriter(std::ostream& strm,
+                           const JSONPrintOptions& opts)
+    :p_strm(strm)
+    ,p_opts(opts)
+    ,p_count(0u)
+{
+    p_opts.multiLine = false;
+    p_opts.indent = 0u;
+}
+
+NDJSONWriter::~NDJSONWriter() {}
+
+void NDJSONWriter::write(const PVStructure& val, const BitSet& changed)
+{
+    p_mask = changed; // re-use storage
+    expandBS(val, p_mask, true);
+    if(p_mask.get(0)) {
+        args A(p_strm, p_opts);
+        show_struct(A, &val, &p_mask);
+    } else {
+        p_strm<<"{}";
+    }
+    p_strm.put('\n');
+    p_count++;
+}
+
+void NDJSONWriter::write(const PVStructure& val)
+{
+    {
+        args A(p_strm, p_opts);
+        show_struct(A, &val, 0);
+    }
+    p_strm.put('\n');
+    p_count++;
+}
+
 }} // namespace epics::pvData
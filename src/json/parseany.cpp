@@ -66,6 +66,7 @@ int jtree_boolean(void * ctx, int boolVal)
             if(self->arr.size()>0 && self->arr.original_type()!=pvd::pvBoolean)
                 throw std::runtime_error("Mixed type array not supported");
             pvd::shared_vector<pvd::boolean> arr(pvd::static_shared_vector_cast<pvd::boolean>(self->arr));
+            self->arr.clear(); // release our reference so push_back() need not copy
             arr.push_back(boolVal);
             self->arr = pvd::static_shared_vector_cast<void>(arr);
             break;
@@ -92,6 +93,7 @@ int jtree_integer(void * ctx, integer_arg integerVal)
             if(self->arr.size()>0 && self->arr.original_type()!=pvd::pvLong)
                 throw std::runtime_error("Mixed type array not supported");
             pvd::shared_vector<pvd::int64> arr(pvd::static_shared_vector_cast<pvd::int64>(self->arr));
+            self->arr.clear();
             arr.push_back(integerVal);
             self->arr = pvd::static_shared_vector_cast<void>(arr);
             break;
@@ -118,6 +120,7 @@ int jtree_double(void * ctx, double doubleVal)
             if(self->arr.size()>0 && self->arr.original_type()!=pvd::pvDouble)
                 throw std::runtime_error("Mixed type array not supported");
             pvd::shared_vector<double> arr(pvd::static_shared_vector_cast<double>(self->arr));
+            self->arr.clear();
             arr.push_back(doubleVal);
             self->arr = pvd::static_shared_vector_cast<void>(arr);
             break;
@@ -146,6 +149,7 @@ int jtree_string(void * ctx, const unsigned char * stringVal,
             if(self->arr.size()>0 && self->arr.original_type()!=pvd::pvString)
                 throw std::runtime_error("Mixed type array not supported");
             pvd::shared_vector<std::string> arr(pvd::static_shared_vector_cast<std::string>(self->arr));
+            self->arr.clear();
             arr.push_back(sval);
             self->arr = pvd::static_shared_vector_cast<void>(arr);
             break;
@@ -247,34 +251,68 @@ struct handler {
     operator yajl_handle() { return handle; }
 };
 
-} // namespace
-
-namespace epics{namespace pvData{
-
-epics::pvData::PVStructure::shared_pointer
-parseJSON(std::istream& strm)
+yajl_handle jtree_alloc(context *ctxt)
 {
 #ifndef EPICS_YAJL_VERSION
     yajl_parser_config conf;
     memset(&conf, 0, sizeof(conf));
     conf.allowComments = 1;
     conf.checkUTF8 = 1;
-#endif
-
-    context ctxt;
 
-#ifndef EPICS_YAJL_VERSION
-    handler handle(yajl_alloc(&jtree_cbs, &conf, NULL, &ctxt));
+    return yajl_alloc(&jtree_cbs, &conf, NULL, ctxt);
 #else
-    handler handle(yajl_alloc(&jtree_cbs, NULL, &ctxt));
+    yajl_handle handle = yajl_alloc(&jtree_cbs, NULL, ctxt);
 
-    yajl_config(handle, yajl_allow_comments, 1);
+    if(handle)
+        yajl_config(handle, yajl_allow_comments, 1);
+    return handle;
 #endif
+}
+
+template<typename Feed>
+pvd::PVStructure::shared_pointer parse_any(const Feed& feed)
+{
+    context ctxt;
+
+    handler handle(jtree_alloc(&ctxt));
 
-    if(!yajl_parse_helper(strm, handle))
+    if(!feed(handle))
         throw std::runtime_error(ctxt.msg);
 
     return ctxt.cur->buildPVStructure();
 }
 
+struct stream_feed {
+    std::istream& strm;
+    explicit stream_feed(std::istream& strm) :strm(strm) {}
+    bool operator()(yajl_handle handle) const {
+        return pvd::yajl_parse_helper(strm, handle);
+    }
+};
+
+struct buffer_feed {
+    const char *buf;
+    size_t len;
+    buffer_feed(const char *buf, size_t len) :buf(buf), len(len) {}
+    bool operator()(yajl_handle handle) const {
+        return pvd::yajl_parse_helper(buf, len, handle);
+    }
+};
+
+} // namespace
+
+namespace epics{namespace pvData{
+
+epics::pvData::PVStructure::shared_pointer
+parseJSON(std::istream& strm)
+{
+    return parse_any(stream_feed(strm));
+}
+
+epics::pvData::PVStructure::shared_pointer
+parseJSON(const char *buf, size_t len)
+{
+    return parse_any(buffer_feed(buf, len));
+}
+
 }} // namespace epics::pvData
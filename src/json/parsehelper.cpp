@@ -5,6 +5,17 @@
 
 #include <stdexcept>
 #include <sstream>
+#include <fstream>
+#include <algorithm>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define HAVE_MMAP
+#endif
 
 #define epicsExportSharedSymbols
 #include <pv/pvdVersion.h>
@@ -13,13 +24,49 @@
 
 namespace {
 
-void check_trailing(const std::string& line)
+using epics::pvData::yajl::size_arg;
+
+// Largest slice of an in-memory buffer passed to a single yajl_parse() call.
+// yajl 1.x takes an 'unsigned' length.
+const size_t json_slice = 1u<<24;
+
+void check_trailing(const char *buf, size_t len)
 {
-    size_t idx = line.find_first_not_of(" \t\n\r");
-    if(idx==line.npos) return;
-    // TODO: detect the end of potentially multi-line comments...
-    // for now trailing comments not allowed
-    throw std::runtime_error("Trailing junk");
+    for(size_t i=0; i<len; i++) {
+        switch(buf[i]) {
+        case ' ':
+        case '\t':
+        case '\n':
+        case '\r':
+            continue;
+        default:
+            // TODO: detect the end of potentially multi-line comments...
+            // for now trailing comments not allowed
+            throw std::runtime_error("Trailing junk");
+        }
+    }
+}
+
+// returns false if parsing cancelled by callback
+bool complete_parse(yajl_handle handle)
+{
+#ifndef EPICS_YAJL_VERSION
+    switch(yajl_parse_complete(handle)) {
+#else
+    switch(yajl_complete_parse(handle)) {
+#endif
+    case yajl_status_ok:
+        break;
+    case yajl_status_client_canceled:
+        return false;
+#ifndef EPICS_YAJL_VERSION
+    case yajl_status_insufficient_data:
+        throw std::runtime_error("unexpected end of input");
+#endif
+    case yajl_status_error:
+        throw std::runtime_error("Error while completing parsing");
+    }
+    return true;
 }
 
 } // namespace
@@ -40,7 +87,7 @@ bool yajl_parse_helper(std::istream& src,
 
 #ifndef EPICS_YAJL_VERSION
         if(done) {
-            check_trailing(line);
+            check_trailing(line.c_str(), line.size());
             continue;
         }
 #endif
@@ -52,7 +99,7 @@ bool yajl_parse_helper(std::istream& src,
             size_t consumed = yajl_get_bytes_consumed(handle);
 
             if(consumed<line.size()) {
-                check_trailing(line.substr(consumed));
+                check_trailing(line.c_str()+consumed, line.size()-consumed);
             }
 
 #ifndef EPICS_YAJL_VERSION
@@ -94,25 +141,133 @@ bool yajl_parse_helper(std::istream& src,
 
 #ifndef EPICS_YAJL_VERSION
     } else if(!done) {
-        switch(yajl_parse_complete(handle)) {
 #else
     } else {
-        switch(yajl_complete_parse(handle)) {
 #endif
-        case yajl_status_ok:
+        return complete_parse(handle);
+    }
+
+    return true;
+}
+
+bool yajl_parse_helper(const char *buf,
+                       size_t len,
+                       yajl_handle handle)
+{
+    const char * const start = buf;
+
+    while(len) {
+        size_t slice = std::min(len, json_slice);
+
+        yajl_status sts = yajl_parse(handle, (const unsigned char*)buf, (size_arg)slice);
+
+        switch(sts) {
+        case yajl_status_ok: {
+            size_t consumed = yajl_get_bytes_consumed(handle);
+
+#ifndef EPICS_YAJL_VERSION
+            // yajl 1.x stops after the first complete value
+            check_trailing(buf+consumed, len-consumed);
+            return true;
+#else
+            if(consumed<slice) {
+                check_trailing(buf+consumed, len-consumed);
+                return complete_parse(handle);
+            }
             break;
+#endif
+        }
         case yajl_status_client_canceled:
             return false;
 #ifndef EPICS_YAJL_VERSION
         case yajl_status_insufficient_data:
-            throw std::runtime_error("unexpected end of input");
+            // continue with next slice
+            break;
 #endif
         case yajl_status_error:
-            throw std::runtime_error("Error while completing parsing");
+        {
+            size_t offset = (buf-start) + std::min(yajl_get_bytes_consumed(handle), slice);
+            size_t linenum = 1u + std::count(start, start+offset, '\n');
+
+            std::ostringstream msg;
+            unsigned char *raw = yajl_get_error(handle, 1, (const unsigned char*)buf, (size_arg)slice);
+            if(!raw) {
+                msg<<"Unknown error on line "<<linenum;
+            } else {
+                try {
+                    msg<<"Error on line "<<linenum<<" : "<<(const char*)raw;
+                }catch(...){
+                    yajl_free_error(handle, raw);
+                    throw;
+                }
+                yajl_free_error(handle, raw);
+            }
+            throw std::runtime_error(msg.str());
+        }
         }
+
+        buf += slice;
+        len -= slice;
     }
 
-    return true;
+    return complete_parse(handle);
+}
+
+JSONMappedFile::JSONMappedFile(const std::string& fname)
+    :p_data("")
+    ,p_size(0u)
+    ,p_mapped(false)
+{
+#ifdef HAVE_MMAP
+    int fd = open(fname.c_str(), O_RDONLY);
+    if(fd<0)
+        throw std::runtime_error(std::string("Unable to open ")+fname);
+
+    struct stat info;
+    if(fstat(fd, &info)) {
+        close(fd);
+        throw std::runtime_error(std::string("Unable to stat ")+fname);
+    }
+
+    if(S_ISREG(info.st_mode) && info.st_size>0) {
+        void *mem = mmap(0, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(mem!=MAP_FAILED) {
+            // parsing is one forward pass
+            (void)madvise(mem, info.st_size, MADV_SEQUENTIAL);
+            p_data = (const char*)mem;
+            p_size = info.st_size;
+            p_mapped = true;
+        }
+    }
+    close(fd);
+
+    if(p_mapped || (S_ISREG(info.st_mode) && info.st_size==0))
+        return;
+    // not a regular file, or mmap() failed.  Fall back to reading
+#endif
+    std::ifstream strm(fname.c_str(), std::ios_base::in | std::ios_base::binary);
+    if(!strm.is_open())
+        throw std::runtime_error(std::string("Unable to open ")+fname);
+
+    char chunk[4096];
+    while(strm.read(chunk, sizeof(chunk)) || strm.gcount()>0)
+        p_buffer.insert(p_buffer.end(), chunk, chunk+strm.gcount());
+
+    if(strm.bad())
+        throw std::runtime_error(std::string("I/O error reading ")+fname);
+
+    if(!p_buffer.empty()) {
+        p_data = &p_buffer[0];
+        p_size = p_buffer.size();
+    }
+}
+
+JSONMappedFile::~JSONMappedFile()
+{
+#ifdef HAVE_MMAP
+    if(p_mapped)
+        munmap((void*)p_data, p_size);
+#endif
 }
 
 }} // namespace epics::pvData
@@ -33,6 +33,7 @@ struct context {
     typedef std::vector<frame> stack_t;
     stack_t stack;
 
+    context() {}
     context(const pvd::PVFieldPtr& root, pvd::BitSet *assigned)
     {
         stack.push_back(frame(root, assigned));
@@ -303,44 +304,640 @@ struct noop {
     void operator()(pvd::PVField*) {}
 };
 
-} // namespace
-
-namespace epics{namespace pvData{
-
-epicsShareFunc
-void parseJSON(std::istream& strm,
-               PVField& dest,
-               BitSet *assigned)
+yajl_handle jtree_alloc(context *ctxt)
 {
 #ifndef EPICS_YAJL_VERSION
     yajl_parser_config conf;
     memset(&conf, 0, sizeof(conf));
     conf.allowComments = 1;
     conf.checkUTF8 = 1;
+
+    return yajl_alloc(&jtree_cbs, &conf, NULL, ctxt);
+#else
+    yajl_handle handle = yajl_alloc(&jtree_cbs, NULL, ctxt);
+
+    if(handle)
+        yajl_config(handle, yajl_allow_comments, 1);
+    return handle;
 #endif
+}
 
+template<typename Feed>
+void parse_into(const Feed& feed, pvd::PVField& dest, pvd::BitSet *assigned)
+{
     // we won't create refs to 'dest' which presist beyond this call.
     // however, it is convienent to treat 'dest' in the same manner as
     // any union/structureArray memebers it may contain.
-    PVFieldPtr fakedest(&dest, noop());
+    pvd::PVFieldPtr fakedest(&dest, noop());
 
     context ctxt(fakedest, assigned);
 
+    handler handle(jtree_alloc(&ctxt));
+
+    if(!feed(handle))
+        throw std::runtime_error(ctxt.msg);
+
+    if(!ctxt.stack.empty())
+        throw std::logic_error("field stack not empty");
+    assert(fakedest.use_count()==1);
+}
+
+struct stream_feed {
+    std::istream& strm;
+    explicit stream_feed(std::istream& strm) :strm(strm) {}
+    bool operator()(yajl_handle handle) const {
+        return pvd::yajl_parse_helper(strm, handle);
+    }
+};
+
+struct buffer_feed {
+    const char *buf;
+    size_t len;
+    buffer_feed(const char *buf, size_t len) :buf(buf), len(len) {}
+    bool operator()(yajl_handle handle) const {
+        return pvd::yajl_parse_helper(buf, len, handle);
+    }
+};
+
+} // namespace
+
+namespace epics{namespace pvData{
+
+epicsShareFunc
+void parseJSON(std::istream& strm,
+               PVField& dest,
+               BitSet *assigned)
+{
+    parse_into(stream_feed(strm), dest, assigned);
+}
+
+epicsShareFunc
+void parseJSON(const char *buf,
+               size_t len,
+               PVField& dest,
+               BitSet *assigned)
+{
+    parse_into(buffer_feed(buf, len), dest, assigned);
+}
+
+}} // namespace epics::pvData
+
+namespace {
+
+/* JSONStructureParser implementation.
+ *
+ * The Structure is flattened into a list of nodes.  Each (parent node, key) pair
+ * is found in an open addressed hash table.  Fields are then located through
+ * the parent PVStructure::getPVFields() by index.
+ * Union and union array fields are handed off to the generic callbacks above.
+ */
+
+// Accumulate the elements of a scalar array
+struct ArraySink {
+    size_t hint; // size of previous array, used to reserve()
+    ArraySink() :hint(0u) {}
+    virtual ~ArraySink() {}
+    virtual void start() =0;
+    virtual void push(pvd::boolean v) =0;
+    virtual void push(pvd::int64 v) =0;
+    virtual void push(double v) =0;
+    virtual void push(const std::string& v) =0;
+    virtual void store(pvd::PVScalarArray *fld) =0;
+};
+
+template<typename T>
+struct TypedArraySink : public ArraySink {
+    pvd::shared_vector<T> buf;
+    virtual ~TypedArraySink() {}
+    virtual void start() {
+        buf.clear();
+        buf.reserve(hint);
+    }
+    virtual void push(pvd::boolean v) { buf.push_back(pvd::castUnsafe<T>(v)); }
+    virtual void push(pvd::int64 v) { buf.push_back(pvd::castUnsafe<T>(v)); }
+    virtual void push(double v) { buf.push_back(pvd::castUnsafe<T>(v)); }
+    virtual void push(const std::string& v) { buf.push_back(pvd::castUnsafe<T>(v)); }
+    virtual void store(pvd::PVScalarArray *fld) {
+        hint = buf.size();
+        static_cast<pvd::PVValueArray<T>*>(fld)->replace(pvd::freeze(buf));
+    }
+};
+
+ArraySink* makeArraySink(pvd::ScalarType stype)
+{
+    switch(stype) {
+#define CASE_STRING
+#define CASE_REAL_INT64
+#define CASE(BASETYPE, PVATYPE, DBFTYPE, PVACODE) case epics::pvData::pv##PVACODE: return new TypedArraySink<PVATYPE>();
+#include <pv/typemap.h>
+#undef CASE
+#undef CASE_REAL_INT64
+#undef CASE_STRING
+    }
+    throw std::logic_error("Invalid ScalarType");
+}
+
+struct cnode {
+    enum kind_t {
+        Scalar,
+        ScalarArray,
+        Structure,
+        StructureArray,
+        Generic, // handled by jtree_* callbacks
+    } kind;
+    size_t index;   // in parent PVStructure::getPVFields()
+    size_t element; // StructureArray: node of element structure
+    pvd::StructureConstPtr elemType; // StructureArray
+    std::tr1::shared_ptr<ArraySink> sink; // ScalarArray
+    std::vector<pvd::PVStructurePtr> elements; // StructureArray
+};
+
+struct centry {
+    size_t parent, child;
+    epicsUInt32 hash;
+    std::string name;
+};
+
+epicsUInt32 keyHash(size_t parent, const char *key, size_t len)
+{
+    // FNV-1a
+    epicsUInt32 hash = 2166136261u ^ epicsUInt32(parent);
+    hash *= 16777619u;
+    for(size_t i=0; i<len; i++) {
+        hash ^= (unsigned char)key[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+} // namespace
+
+namespace epics{namespace pvData{
+
+struct JSONStructureParser::Impl
+{
+    StructureConstPtr type;
+    std::vector<cnode> nodes;
+    std::vector<centry> entries;
+    std::vector<size_t> table; // entry index +1, or 0 if empty
+    size_t mask;
+
+    explicit Impl(const StructureConstPtr& type)
+        :type(type)
+    {
+        if(!type)
+            throw std::invalid_argument("JSONStructureParser requires a Structure");
+        compile(*type);
+
+        size_t nbucket = 16u;
+        while(nbucket < 2u*entries.size())
+            nbucket *= 2u;
+        table.resize(nbucket, 0u);
+        mask = nbucket-1u;
+        for(size_t i=0; i<entries.size(); i++) {
+            size_t b = entries[i].hash & mask;
+            while(table[b])
+                b = (b+1u) & mask;
+            table[b] = i+1u;
+        }
+    }
+
+    // returns node index
+    size_t compile(const Structure& stype)
+    {
+        size_t self = nodes.size();
+        nodes.push_back(cnode());
+        nodes[self].kind = cnode::Structure;
+        nodes[self].index = 0u;
+        nodes[self].element = 0u;
+
+        const StringArray& names = stype.getFieldNames();
+        const FieldConstPtrArray& fields = stype.getFields();
+
+        for(size_t i=0, N=fields.size(); i<N; i++) {
+            size_t child;
+            const Field& fld = *fields[i];
+
+            switch(fld.getType()) {
+            case structure:
+                child = compile(static_cast<const Structure&>(fld));
+                break;
+            case structureArray:
+            {
+                StructureConstPtr etype(static_cast<const StructureArray&>(fld).getStructure());
+                size_t elem = compile(*etype);
+                child = nodes.size();
+                nodes.push_back(cnode());
+                nodes[child].kind = cnode::StructureArray;
+                nodes[child].element = elem;
+                nodes[child].elemType = etype;
+            }
+                break;
+            case scalar:
+                child = nodes.size();
+                nodes.push_back(cnode());
+                nodes[child].kind = cnode::Scalar;
+                nodes[child].element = 0u;
+                break;
+            case scalarArray:
+                child = nodes.size();
+                nodes.push_back(cnode());
+                nodes[child].kind = cnode::ScalarArray;
+                nodes[child].element = 0u;
+                nodes[child].sink.reset(makeArraySink(static_cast<const ScalarArray&>(fld).getElementType()));
+                break;
+            default:
+                child = nodes.size();
+                nodes.push_back(cnode());
+                nodes[child].kind = cnode::Generic;
+                nodes[child].element = 0u;
+                break;
+            }
+            nodes[child].index = i;
+
+            entries.push_back(centry());
+            centry& ent = entries.back();
+            ent.parent = self;
+            ent.child = child;
+            ent.name = names[i];
+            ent.hash = keyHash(self, names[i].c_str(), names[i].size());
+        }
+        return self;
+    }
+
+    // returns node index, or 0 if not found.  (node 0 is the root, which is never a child)
+    size_t lookup(size_t parent, const char *key, size_t len) const
+    {
+        epicsUInt32 hash = keyHash(parent, key, len);
+        for(size_t b = hash & mask; table[b]; b = (b+1u) & mask) {
+            const centry& ent = entries[table[b]-1u];
+            if(ent.hash==hash && ent.parent==parent && ent.name.size()==len
+                    && memcmp(ent.name.c_str(), key, len)==0)
+                return ent.child;
+        }
+        return 0u;
+    }
+};
+
+}} // namespace epics::pvData
+
+namespace {
+
+struct ccontext {
+    typedef pvd::JSONStructureParser::Impl impl_t;
+    impl_t& impl;
+    pvd::BitSet *assigned;
+
+    std::string msg;
+
+    struct frame {
+        pvd::PVField *fld;
+        size_t node;
+        bool open; // have seen start of map/array
+        bool inElem; // within an element of a structure array, so not tracked in 'assigned'
+        pvd::PVStructurePtr elem; // element of structure array
+        frame(pvd::PVField *fld, size_t node, bool inElem =false)
+            :fld(fld), node(node), open(false), inElem(inElem)
+        {}
+    };
+
+    typedef std::vector<frame> stack_t;
+    stack_t stack;
+
+    // while handling a Generic field
+    context generic;
+
+    ccontext(impl_t& impl, pvd::PVStructure& root, pvd::BitSet *assigned)
+        :impl(impl)
+        ,assigned(assigned)
+    {
+        stack.reserve(8u);
+        stack.push_back(frame(&root, 0u));
+    }
+
+    inline cnode& node() { return impl.nodes[stack.back().node]; }
+
+    void mark(const frame& F) {
+        if(assigned && !F.inElem)
+            assigned->set(F.fld->getFieldOffset());
+    }
+
+    template<typename T>
+    void assign(const T& val)
+    {
+        if(stack.empty())
+            throw std::runtime_error("Extra value");
+        frame& back = stack.back();
+        cnode& N = impl.nodes[back.node];
+
+        switch(N.kind) {
+        case cnode::Scalar:
+            static_cast<pvd::PVScalar*>(back.fld)->putFrom(val);
+            mark(back);
+            stack.pop_back();
+            break;
+        case cnode::ScalarArray:
+            if(!back.open)
+                throw std::invalid_argument("Can't assign value to array");
+            N.sink->push(val);
+            break;
+        default:
+            throw std::invalid_argument("Can't assign value");
+        }
+    }
+};
+
+// forward to generic callbacks while handling a union/union array field
+#define CTRY(FWD) ccontext *self = (ccontext*)ctx; \
+    if(!self->generic.stack.empty()) { \
+        if(FWD) return 1; \
+        self->msg = self->generic.msg; \
+        return 0; \
+    } \
+    try
+
+#define CCATCH() catch(std::exception& e) { if(self->msg.empty()) self->msg = e.what(); return 0; }
+
+int cjson_null(void * ctx)
+{
+    CTRY(jtree_null(&self->generic)) {
+        self->msg = "NULL value not permitted";
+        return 0;
+    }CCATCH()
+}
+
+int cjson_boolean(void * ctx, int boolVal)
+{
+    CTRY(jtree_boolean(&self->generic, boolVal)) {
+        self->assign(pvd::boolean(!!boolVal));
+        return 1;
+    }CCATCH()
+}
+
+int cjson_integer(void * ctx, integer_arg integerVal)
+{
+    CTRY(jtree_integer(&self->generic, integerVal)) {
+        self->assign(pvd::int64(integerVal));
+        return 1;
+    }CCATCH()
+}
+
+int cjson_double(void * ctx, double doubleVal)
+{
+    CTRY(jtree_double(&self->generic, doubleVal)) {
+        self->assign(doubleVal);
+        return 1;
+    }CCATCH()
+}
+
+int cjson_string(void * ctx, const unsigned char * stringVal,
+                    size_arg stringLen)
+{
+    CTRY(jtree_string(&self->generic, stringVal, stringLen)) {
+        std::string val((const char*)stringVal, stringLen);
+        self->assign(val);
+        return 1;
+    }CCATCH()
+}
+
+int cjson_start_map(void * ctx)
+{
+    CTRY(jtree_start_map(&self->generic)) {
+        if(self->stack.empty())
+            throw std::runtime_error("Extra value");
+        ccontext::frame& back = self->stack.back();
+        cnode& N = self->node();
+
+        if(N.kind==cnode::Structure && !back.open) {
+            back.open = true;
+
+        } else if(N.kind==cnode::StructureArray && back.open) {
+            // starting new element in structure array
+            pvd::PVStructurePtr elem(pvd::getPVDataCreate()->createPVStructure(N.elemType));
+
+            ccontext::frame eframe(elem.get(), N.element, true);
+            eframe.open = true;
+            eframe.elem.swap(elem);
+            self->stack.push_back(eframe);
+
+        } else {
+            throw std::runtime_error("Can't map (sub)structure");
+        }
+        return 1;
+    }CCATCH()
+}
+
+int cjson_map_key(void * ctx, const unsigned char * key,
+                     size_arg stringLen)
+{
+    CTRY(jtree_map_key(&self->generic, key, stringLen)) {
+        // start_map() ensures we have a structure at the top of the stack
+        ccontext::frame& back = self->stack.back();
+        pvd::PVStructure *fld = static_cast<pvd::PVStructure*>(back.fld);
+
+        size_t child = self->impl.lookup(back.node, (const char*)key, stringLen);
+        if(!child) {
+            std::ostringstream strm;
+            strm<<"At "<<fld->getFullName()<<" : no field '"<<std::string((const char*)key, stringLen)<<"'\n";
+            throw std::runtime_error(strm.str());
+        }
+
+        const cnode& C = self->impl.nodes[child];
+        const pvd::PVFieldPtr& cfld = fld->getPVFields()[C.index];
+
+        if(C.kind==cnode::Generic) {
+            self->generic.stack.push_back(context::frame(cfld, back.inElem ? 0 : self->assigned));
+        } else {
+            self->stack.push_back(ccontext::frame(cfld.get(), child, back.inElem));
+        }
+        return 1;
+    }CCATCH()
+}
+
+int cjson_end_map(void * ctx)
+{
+    CTRY(jtree_end_map(&self->generic)) {
+        assert(!self->stack.empty());
+        assert(self->node().kind==cnode::Structure);
+
+        pvd::PVStructurePtr elem;
+        elem.swap(self->stack.back().elem);
+        self->stack.pop_back();
+
+        if(elem) {
+            // append element to struct array
+            assert(!self->stack.empty() && self->node().kind==cnode::StructureArray);
+            self->node().elements.push_back(elem);
+        }
+
+        return 1;
+    }CCATCH()
+}
+
+int cjson_start_array(void * ctx)
+{
+    CTRY(jtree_start_array(&self->generic)) {
+        if(self->stack.empty())
+            throw std::runtime_error("Extra value");
+        ccontext::frame& back = self->stack.back();
+        cnode& N = self->node();
+
+        if(back.open) {
+            throw std::runtime_error("Can't assign array of arrays");
+
+        } else if(N.kind==cnode::ScalarArray) {
+            N.sink->start();
+
+        } else if(N.kind==cnode::StructureArray) {
+            N.elements.clear();
+
+        } else {
+            throw std::runtime_error("Can't assign array");
+        }
+        back.open = true;
+        return 1;
+    }CCATCH()
+}
+
+int cjson_end_array(void * ctx)
+{
+    CTRY(jtree_end_array(&self->generic)) {
+        assert(!self->stack.empty());
+        ccontext::frame& back = self->stack.back();
+        cnode& N = self->node();
+
+        if(N.kind==cnode::ScalarArray) {
+            N.sink->store(static_cast<pvd::PVScalarArray*>(back.fld));
+
+        } else {
+            assert(N.kind==cnode::StructureArray);
+            pvd::PVStructureArray::svector elems(N.elements.size());
+            std::copy(N.elements.begin(), N.elements.end(), elems.begin());
+            N.elements.clear();
+            static_cast<pvd::PVStructureArray*>(back.fld)->replace(pvd::freeze(elems));
+        }
+
+        self->mark(back);
+        self->stack.pop_back();
+        return 1;
+    }CCATCH()
+}
+
+yajl_callbacks cjson_cbs = {
+    &cjson_null,
+    &cjson_boolean,
+    &cjson_integer,
+    &cjson_double,
+    NULL, // number
+    &cjson_string,
+    &cjson_start_map,
+    &cjson_map_key,
+    &cjson_end_map,
+    &cjson_start_array,
+    &cjson_end_array,
+};
+
+yajl_handle cjson_alloc(ccontext *ctxt)
+{
 #ifndef EPICS_YAJL_VERSION
-    handler handle(yajl_alloc(&jtree_cbs, &conf, NULL, &ctxt));
+    yajl_parser_config conf;
+    memset(&conf, 0, sizeof(conf));
+    conf.allowComments = 1;
+    conf.checkUTF8 = 1;
+
+    return yajl_alloc(&cjson_cbs, &conf, NULL, ctxt);
 #else
-    handler handle(yajl_alloc(&jtree_cbs, NULL, &ctxt));
+    yajl_handle handle = yajl_alloc(&cjson_cbs, NULL, ctxt);
 
-    yajl_config(handle, yajl_allow_comments, 1);
+    if(handle)
+        yajl_config(handle, yajl_allow_comments, 1);
+    return handle;
 #endif
+}
+
+template<typename Feed>
+void parse_compiled(const Feed& feed, pvd::JSONStructureParser::Impl& impl,
+                    pvd::PVStructure& dest, pvd::BitSet *assigned)
+{
+    const pvd::StructureConstPtr& dtype(dest.getStructure());
+    if(dtype!=impl.type && *dtype!=*impl.type)
+        throw std::invalid_argument("JSONStructureParser: destination Structure does not match");
 
+    ccontext ctxt(impl, dest, assigned);
 
-    if(!yajl_parse_helper(strm, handle))
+    handler handle(cjson_alloc(&ctxt));
+
+    if(!feed(handle))
         throw std::runtime_error(ctxt.msg);
 
-    if(!ctxt.stack.empty())
+    if(!ctxt.stack.empty() || !ctxt.generic.stack.empty())
         throw std::logic_error("field stack not empty");
-    assert(fakedest.use_count()==1);
+}
+
+} // namespace
+
+namespace epics{namespace pvData{
+
+JSONStructureParser::JSONStructureParser(const StructureConstPtr& type)
+    :impl(new Impl(type))
+{}
+
+JSONStructureParser::~JSONStructureParser()
+{
+    delete impl;
+}
+
+const StructureConstPtr& JSONStructureParser::getStructure() const
+{
+    return impl->type;
+}
+
+void JSONStructureParser::parse(std::istream& strm,
+                                PVStructure& dest,
+                                BitSet *assigned)
+{
+    parse_compiled(stream_feed(strm), *impl, dest, assigned);
+}
+
+void JSONStructureParser::parse(const char *buf,
+                                size_t len,
+                                PVStructure& dest,
+                                BitSet *assigned)
+{
+    parse_compiled(buffer_feed(buf, len), *impl, dest, assigned);
+}
+
+NDJSONReader::NDJSONReader(std::istream& strm,
+                           const StructureConstPtr& type)
+    :p_strm(strm)
+    ,p_parser(type)
+    ,p_line(0u)
+{}
+
+NDJSONReader::~NDJSONReader() {}
+
+bool NDJSONReader::next(PVStructure& dest, BitSet *assigned)
+{
+    // p_buf is re-used, so memory usage is bounded by the longest line
+    while(std::getline(p_strm, p_buf)) {
+        p_line++;
+
+        if(p_buf.find_first_not_of(" \t\r") == std::string::npos)
+            continue; // skip blank lines
+
+        if(assigned)
+            assigned->clear();
+
+        try {
+            p_parser.parse(p_buf.c_str(), p_buf.size(), dest, assigned);
+        } catch(std::runtime_error& e) {
+            std::ostringstream msg;
+            msg<<"NDJSON line "<<p_line<<" : "<<e.what();
+            throw std::runtime_error(msg.str());
+        }
+        return true;
+    }
+    return false;
 }
 
 }} // namespace epics::pvData
@@ -8,10 +8,12 @@
 #include <istream>
 #include <ostream>
 #include <string>
+#include <vector>
 #include <map>
 
 #include <pv/pvdVersion.h>
 #include <pv/pvData.h>
+#include <pv/bitSet.h>
 
 #ifdef epicsExportSharedSymbols
 #   define pvjson_epicsExportSharedSymbols
@@ -26,6 +28,7 @@
 #endif
 
 #include <shareLib.h>
+#include <pv/noDefaultMethods.h>
 
 namespace epics{namespace pvData{
 
@@ -114,6 +117,225 @@ void parseJSON(std::istream& strm,
     parseJSON(strm, *dest, assigned);
 }
 
+/** Parse JSON text held in memory into a PVStructure
+ *
+ * As parseJSON(std::istream&), but the text is passed to the parser in place
+ * without being copied.
+ *
+ * @param buf Start of JSON text.  Need not be nil terminated.
+ * @param len Length of JSON text in bytes
+ * @since 8.0.8
+ */
+epicsShareFunc
+PVStructure::shared_pointer parseJSON(const char *buf, size_t len);
+
+/** Parse JSON text held in memory and store into the provided PVStructure.
+ *
+ * As parseJSON(std::istream&, PVField&, BitSet*), but the text is passed
+ * to the parser in place without being copied.
+ *
+ * @param buf Start of JSON text.  Need not be nil terminated.
+ * @param len Length of JSON text in bytes
+ * @param dest Store in fields of this structure
+ * @param assigned Which fields of _dest_ were assigned. (Optional)
+ * @throws std::runtime_error on failure.  dest and assigned may be modified.
+ * @since 8.0.8
+ */
+epicsShareFunc
+void parseJSON(const char *buf,
+               size_t len,
+               PVField& dest,
+               BitSet *assigned=0);
+
+/** Read-only view of the contents of a file.
+ *
+ * Memory mapped where supported (Linux and OSX).
+ * Otherwise the file is read into a buffer owned by this object.
+ *
+ @code
+   JSONMappedFile file("settings.json");
+   parseJSON(file, *dest);
+ @endcode
+ * @since 8.0.8
+ */
+class epicsShareClass JSONMappedFile
+{
+    EPICS_NOT_COPYABLE(JSONMappedFile)
+public:
+    //! @throws std::runtime_error if the file can not be opened or read.
+    explicit JSONMappedFile(const std::string& fname);
+    ~JSONMappedFile();
+
+    //! First byte of file contents
+    inline const char* data() const { return p_data; }
+    //! Length of file contents in bytes
+    inline size_t size() const { return p_size; }
+    //! Was the file memory mapped?  (vs. read into a buffer)
+    inline bool mapped() const { return p_mapped; }
+private:
+    const char *p_data;
+    size_t p_size;
+    bool p_mapped;
+    std::vector<char> p_buffer;
+};
+
+//! Parse the contents of a file into a PVStructure
+//! @since 8.0.8
+FORCE_INLINE
+PVStructure::shared_pointer parseJSON(const JSONMappedFile& file)
+{
+    return parseJSON(file.data(), file.size());
+}
+
+//! Parse the contents of a file and store into the provided PVStructure.
+//! @since 8.0.8
+FORCE_INLINE
+void parseJSON(const JSONMappedFile& file,
+               PVField& dest,
+               BitSet *assigned=0)
+{
+    parseJSON(file.data(), file.size(), dest, assigned);
+}
+
+/** Parser specialized for one Structure type.
+ *
+ * Analyses the Structure once so that repeated parsing of messages into
+ * PVStructures of this type can locate fields without string comparisons
+ * or per-field allocations.
+ *
+ * Differs from parseJSON(std::istream&, PVField&, BitSet*) in that
+ * arrays replace the previous contents of a field, instead of being appended to it.
+ *
+ * An instance may be used by only one thread at a time.
+ *
+ @code
+   JSONStructureParser parser(pvs->getStructure());
+   BitSet changed;
+   parser.parse(buf, len, *pvs, &changed);
+ @endcode
+ * @since 8.0.8
+ */
+class epicsShareClass JSONStructureParser
+{
+    EPICS_NOT_COPYABLE(JSONStructureParser)
+public:
+    POINTER_DEFINITIONS(JSONStructureParser);
+
+    //! @throws std::invalid_argument if type is NULL
+    explicit JSONStructureParser(const StructureConstPtr& type);
+    ~JSONStructureParser();
+
+    //! The Structure for which this parser was created
+    const StructureConstPtr& getStructure() const;
+
+    /** Parse JSON and store into the provided PVStructure.
+     *
+     * @param strm Read JSON text from stream
+     * @param dest Store in fields of this structure.  Must have the same type as getStructure().
+     * @param assigned Which fields of _dest_ were assigned. (Optional)
+     * @throws std::invalid_argument if dest has the wrong type.
+     * @throws std::runtime_error on failure.  dest and assigned may be modified.
+     */
+    void parse(std::istream& strm,
+               PVStructure& dest,
+               BitSet *assigned=0);
+    //! As parse(std::istream&, PVStructure&, BitSet*) with text held in memory.
+    void parse(const char *buf,
+               size_t len,
+               PVStructure& dest,
+               BitSet *assigned=0);
+
+    struct Impl;
+private:
+    Impl *impl;
+};
+
+/** Write a sequence of PVStructures as newline delimited JSON (NDJSON).
+ *
+ * Each call to write() emits one line with a single JSON object.
+ * Options other than multiLine and indent are taken from JSONPrintOptions.
+ *
+ @code
+   std::ofstream out("updates.ndjson");
+   NDJSONWriter writer(out);
+   writer.write(*pvs);          // all fields
+   writer.write(*pvs, changed); // only changed fields
+ @endcode
+ * @since 8.0.8
+ */
+class epicsShareClass NDJSONWriter
+{
+    EPICS_NOT_COPYABLE(NDJSONWriter)
+public:
+    POINTER_DEFINITIONS(NDJSONWriter);
+
+    explicit NDJSONWriter(std::ostream& strm,
+                          const JSONPrintOptions& opts = JSONPrintOptions());
+    ~NDJSONWriter();
+
+    /** Write one line with those fields selected by 'changed'.
+     *
+     * 'changed' is interpreted as by printJSON(std::ostream&, const PVStructure&, const BitSet&, const JSONPrintOptions&).
+     * Writes "{}" if no fields are selected.
+     */
+    void write(const PVStructure& val, const BitSet& changed);
+    //! Write one line with all fields
+    void write(const PVStructure& val);
+
+    //! Number of lines written
+    inline size_t count() const { return p_count; }
+private:
+    std::ostream& p_strm;
+    JSONPrintOptions p_opts;
+    BitSet p_mask;
+    size_t p_count;
+};
+
+/** Read a sequence of updates from newline delimited JSON (NDJSON).
+ *
+ * Each line is parsed, as by JSONStructureParser, into a destination PVStructure
+ * which may be re-used for each line.  Blank lines are skipped.
+ * Memory used is bounded by the longest line, not by the length of the stream.
+ *
+ @code
+   std::ifstream in("updates.ndjson");
+   NDJSONReader reader(in, pvs->getStructure());
+   BitSet changed;
+   while(reader.next(*pvs, &changed)) {
+       ...
+   }
+ @endcode
+ * @since 8.0.8
+ */
+class epicsShareClass NDJSONReader
+{
+    EPICS_NOT_COPYABLE(NDJSONReader)
+public:
+    POINTER_DEFINITIONS(NDJSONReader);
+
+    NDJSONReader(std::istream& strm,
+                 const StructureConstPtr& type);
+    ~NDJSONReader();
+
+    /** Parse the next line into dest.
+     *
+     * @param dest Store in fields of this structure.  Must have the type passed to the ctor.
+     * @param assigned Cleared, then set to those fields of _dest_ assigned from this line. (Optional)
+     * @returns false at end of stream.
+     * @throws std::runtime_error if the line can not be parsed.
+     *         The message includes lineNumber().  Reading may continue with the next line.
+     */
+    bool next(PVStructure& dest, BitSet *assigned=0);
+
+    //! Number of the line most recently read.  The first line is 1.
+    inline size_t lineNumber() const { return p_line; }
+private:
+    std::istream& p_strm;
+    JSONStructureParser p_parser;
+    std::string p_buf;
+    size_t p_line;
+};
+
 
 /** Wrapper around yajl_parse()
  *
@@ -131,6 +353,23 @@ epicsShareFunc
 bool yajl_parse_helper(std::istream& src,
                        yajl_handle handle);
 
+/** Wrapper around yajl_parse() for text held in memory
+ *
+ * As yajl_parse_helper(std::istream&, yajl_handle), but the input
+ * is passed to yajl_parse() in place, in large slices.
+ *
+ * @param buf Start of JSON text.  Need not be nil terminated.
+ * @param len Length of JSON text in bytes
+ * @param handle A parser handle previously allocated with yajl_alloc().  Not free'd on success or failure.
+ *
+ * @returns true if parsing completes successfully.  false if parsing cancelled by callback.  throws other errors
+ * @since 8.0.8
+ */
+epicsShareFunc
+bool yajl_parse_helper(const char *buf,
+                       size_t len,
+                       yajl_handle handle);
+
 namespace yajl {
 // undef implies API version 0
 #ifndef EPICS_YAJL_VERSION
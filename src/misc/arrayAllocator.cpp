@@ -0,0 +1,246 @@
+/* arrayAllocator.cpp */
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <stdlib.h>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include <new>
+
+#include <epicsMutex.h>
+#include <epicsThread.h>
+#include <epicsAtomic.h>
+
+#define epicsExportSharedSymbols
+#include <pv/lock.h>
+#include <pv/arrayAllocator.h>
+
+namespace {
+using namespace epics::pvData;
+
+// Four size classes for each power of two.
+#define CLASS_BITS 2u
+#define NCLASSES ((sizeof(size_t)*8u)<<CLASS_BITS)
+
+// Requests larger than this are never pooled
+#define MAX_POOLED (size_t(1u)<<30)
+
+unsigned log2floor(size_t n)
+{
+    unsigned ret = 0u;
+    while(n>>=1u)
+        ret++;
+    return ret;
+}
+
+// Round n up to its size class.  n >= (1<<CLASS_BITS)
+size_t sizeClass(size_t n, unsigned *idx)
+{
+    size_t step = size_t(1u)<<(log2floor(n)-CLASS_BITS);
+    n = (n + step - 1u) & ~(step - 1u);
+    // rounding may carry into the next power of two
+    unsigned p = log2floor(n);
+    *idx = (p<<CLASS_BITS) | unsigned((n>>(p-CLASS_BITS)) & ((1u<<CLASS_BITS)-1u));
+    return n;
+}
+
+// Over-allocate by alignment, and store the pointer to be free()'d just before the aligned storage.
+// alignment is a power of two >= sizeof(void*)
+void* alignedAlloc(size_t nbytes, size_t alignment)
+{
+    const size_t extra = alignment - 1u + sizeof(void*);
+    if(nbytes > ((size_t)-1) - extra)
+        throw std::bad_alloc();
+    void *raw = malloc(nbytes + extra);
+    if(!raw)
+        throw std::bad_alloc();
+    void **ret = (void**)(((size_t)raw + extra) & ~(alignment - 1u));
+    ret[-1] = raw;
+    return ret;
+}
+
+void alignedFree(void *ptr)
+{
+    if(ptr)
+        free(((void**)ptr)[-1]);
+}
+
+size_t checkAlignment(size_t alignment)
+{
+    if(alignment & (alignment-1u))
+        throw std::invalid_argument("alignment must be a power of two");
+    if(alignment && alignment < sizeof(void*))
+        alignment = sizeof(void*);
+    return alignment;
+}
+
+struct allocgbl_t {
+    epicsMutex lock; // guards current
+    ArrayAllocator::shared_pointer current;
+    // never changed after allocgbl_init()
+    ArrayAllocator::shared_pointer dflt;
+    // non-zero while current!=dflt.  (atomic)
+    int installed;
+    allocgbl_t() :installed(0) {}
+} *allocgbl;
+
+void allocgbl_init(void *)
+{
+    try {
+        allocgbl = new allocgbl_t;
+        allocgbl->current = allocgbl->dflt = ArrayAllocator::shared_pointer(new ArrayPool);
+    } catch(std::exception& e) {
+        std::cerr<<"Failed to initialize global array allocator :"<<e.what()<<"\n";
+    }
+}
+
+epicsThreadOnceId allocgbl_once = EPICS_THREAD_ONCE_INIT;
+
+void allocgbl_setup()
+{
+    epicsThreadOnce(&allocgbl_once, &allocgbl_init, 0);
+    if(!allocgbl)
+        throw std::runtime_error("Failed to initialize global array allocator");
+}
+
+} // namespace
+
+namespace epics { namespace pvData {
+
+ArrayAllocator::~ArrayAllocator() {}
+
+ArrayAllocator::shared_pointer ArrayAllocator::current()
+{
+    allocgbl_setup();
+    // without the lock in the common case.  Racing install() may go either way.
+    if(!epics::atomic::get(allocgbl->installed))
+        return allocgbl->dflt;
+    Lock G(allocgbl->lock);
+    return allocgbl->current;
+}
+
+void ArrayAllocator::install(const shared_pointer& alloc)
+{
+    allocgbl_setup();
+    shared_pointer prev;
+    {
+        Lock G(allocgbl->lock);
+        prev = allocgbl->current;
+        allocgbl->current = alloc ? alloc : allocgbl->dflt;
+        epics::atomic::set(allocgbl->installed, allocgbl->current==allocgbl->dflt ? 0 : 1);
+    }
+    // prev released without lock
+}
+
+struct ArrayPool::Impl {
+    mutable epicsMutex lock;
+    const size_t maxRetained, minSize;
+    Stats stats;
+    // free lists, indexed by size class
+    std::vector<void*> lists[NCLASSES];
+
+    Impl(size_t maxRetained, size_t minSize)
+        :maxRetained(maxRetained)
+        ,minSize(minSize < 64u ? 64u : minSize)
+    {}
+
+    bool pooled(size_t nbytes, size_t alignment) const {
+        return nbytes>=minSize && nbytes<=MAX_POOLED && alignment<=ArrayAllocator::CacheLine;
+    }
+};
+
+ArrayPool::ArrayPool(size_t maxRetained, size_t minSize)
+    :impl(new Impl(maxRetained, minSize))
+{}
+
+ArrayPool::~ArrayPool()
+{
+    trim();
+    delete impl;
+}
+
+void* ArrayPool::allocate(size_t nbytes, size_t alignment)
+{
+    alignment = checkAlignment(alignment);
+    if(impl->pooled(nbytes, alignment)) {
+        unsigned idx;
+        nbytes = sizeClass(nbytes, &idx);
+        {
+            Lock G(impl->lock);
+            impl->stats.requests++;
+            std::vector<void*>& list = impl->lists[idx];
+            if(!list.empty()) {
+                void *ret = list.back();
+                list.pop_back();
+                impl->stats.hits++;
+                impl->stats.buffersRetained--;
+                impl->stats.bytesRetained -= nbytes;
+                return ret;
+            }
+        }
+        return alignedAlloc(nbytes, ArrayAllocator::CacheLine);
+
+    } else if(alignment) {
+        return alignedAlloc(nbytes, alignment);
+
+    } else {
+        void *ret = malloc(nbytes ? nbytes : 1u);
+        if(!ret)
+            throw std::bad_alloc();
+        return ret;
+    }
+}
+
+void ArrayPool::deallocate(void *ptr, size_t nbytes, size_t alignment)
+{
+    if(!ptr)
+        return;
+    alignment = checkAlignment(alignment);
+    if(impl->pooled(nbytes, alignment)) {
+        unsigned idx;
+        nbytes = sizeClass(nbytes, &idx);
+        try {
+            Lock G(impl->lock);
+            impl->stats.releases++;
+            if(impl->stats.bytesRetained + nbytes <= impl->maxRetained) {
+                impl->lists[idx].push_back(ptr);
+                impl->stats.buffersRetained++;
+                impl->stats.bytesRetained += nbytes;
+                return;
+            }
+            impl->stats.dropped++;
+        } catch(std::bad_alloc&) {
+            // no room on free list
+        }
+        alignedFree(ptr);
+
+    } else if(alignment) {
+        alignedFree(ptr);
+
+    } else {
+        free(ptr);
+    }
+}
+
+ArrayPool::Stats ArrayPool::stats() const
+{
+    Lock G(impl->lock);
+    return impl->stats;
+}
+
+void ArrayPool::trim()
+{
+    Lock G(impl->lock);
+    for(size_t i=0; i<NCLASSES; i++) {
+        std::vector<void*>& list = impl->lists[i];
+        for(size_t n=0; n<list.size(); n++)
+            alignedFree(list[n]);
+        list.clear();
+    }
+    impl->stats.buffersRetained = 0u;
+    impl->stats.bytesRetained = 0u;
+}
+
+}} // namespace epics::pvData
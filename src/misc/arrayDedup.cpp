@@ -0,0 +1,184 @@
+/* arrayDedup.cpp */
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <map>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string.h>
+
+#include <epicsGuard.h>
+#include <epicsMutex.h>
+#include <epicsThread.h>
+
+#define epicsExportSharedSymbols
+#include <pv/internedString.h>
+#include <pv/arrayDedup.h>
+
+namespace {
+using namespace epics::pvData;
+
+typedef epicsGuard<epicsMutex> Guard;
+
+size_t hashArray(const shared_vector<const void>& value)
+{
+    if(value.original_type()==pvString) {
+        const std::string *S = static_cast<const std::string*>(value.data());
+        size_t H = 0u;
+        for(size_t i=0, N=value.size()/sizeof(std::string); i<N; i++)
+            H = H*31u + InternedString::hashOf(S[i]);
+        return H;
+    } else {
+        return InternedString::hashOf(static_cast<const char*>(value.data()), value.size());
+    }
+}
+
+bool equalArray(const shared_vector<const void>& A, const shared_vector<const void>& B)
+{
+    if(A.original_type()!=B.original_type() || A.size()!=B.size())
+        return false;
+    else if(A.data()==B.data())
+        return true;
+    else if(A.original_type()==pvString) {
+        const std::string *SA = static_cast<const std::string*>(A.data()),
+                          *SB = static_cast<const std::string*>(B.data());
+        for(size_t i=0, N=A.size()/sizeof(std::string); i<N; i++)
+            if(SA[i]!=SB[i])
+                return false;
+        return true;
+    } else {
+        return memcmp(A.data(), B.data(), A.size())==0;
+    }
+}
+
+ArrayDedup *globalDedup;
+
+void globalDedup_init(void *)
+{
+    try {
+        globalDedup = new ArrayDedup;
+    } catch(std::exception& e) {
+        std::cerr<<"Failed to create global ArrayDedup :"<<e.what()<<"\n";
+    }
+}
+
+epicsThreadOnceId globalDedup_once = EPICS_THREAD_ONCE_INIT;
+
+} // namespace
+
+namespace epics { namespace pvData {
+
+struct ArrayDedup::Impl {
+    mutable epicsMutex lock;
+    typedef std::multimap<size_t, shared_vector<const void> > entries_t;
+    entries_t entries;
+    ArrayDedup::Stats stats; // entries and bytesRetained kept current
+    const size_t maxBytes;
+    // prune() before an insert which would pass either of these
+    size_t pruneEntries, pruneBytes;
+
+    explicit Impl(size_t maxBytes) :maxBytes(maxBytes), pruneEntries(0u), pruneBytes(0u) {}
+
+    // Move entries not referenced outside the pool into junk, to be destroyed unlocked
+    size_t prune(std::vector<shared_vector<const void> >& junk)
+    {
+        size_t ret = 0u;
+        for(entries_t::iterator it(entries.begin()), end(entries.end()); it!=end; ) {
+            entries_t::iterator cur(it++);
+            if(cur->second.dataPtr().use_count()==1) {
+                stats.entries--;
+                stats.bytesRetained -= cur->second.size();
+                junk.push_back(cur->second);
+                entries.erase(cur);
+                ret++;
+            }
+        }
+        // amortize the cost of the scan over as many inserts as there are entries remaining
+        pruneEntries = std::max(2u*stats.entries, size_t(64u));
+        pruneBytes = std::max(2u*stats.bytesRetained, size_t(1024u*1024u));
+        return ret;
+    }
+};
+
+ArrayDedup::ArrayDedup(size_t maxBytes)
+    :impl(new Impl(maxBytes))
+{}
+
+ArrayDedup::~ArrayDedup()
+{
+    delete impl;
+}
+
+shared_vector<const void> ArrayDedup::lookup(const shared_vector<const void>& value)
+{
+    // arrays of PVStructure and PVUnion may not be cast, so always have a type
+    if(value.original_type()==(ScalarType)-1)
+        throw std::logic_error("ArrayDedup needs an array of known element type");
+
+    const size_t H = hashArray(value);
+
+    // destroy outside of lock
+    std::vector<shared_vector<const void> > junk;
+    Guard G(impl->lock);
+    impl->stats.lookups++;
+
+    std::pair<Impl::entries_t::iterator, Impl::entries_t::iterator> itp(impl->entries.equal_range(H));
+    for(; itp.first!=itp.second; ++itp.first) {
+        if(equalArray(itp.first->second, value)) {
+            if(itp.first->second.dataPtr()!=value.dataPtr()) {
+                impl->stats.hits++;
+                impl->stats.bytesSaved += value.size();
+            }
+            return itp.first->second;
+        }
+    }
+
+    const size_t nbytes = impl->stats.bytesRetained + value.size();
+    if(impl->stats.entries>=impl->pruneEntries || nbytes>impl->pruneBytes || nbytes>impl->maxBytes)
+        impl->prune(junk);
+    if(impl->stats.bytesRetained + value.size() > impl->maxBytes)
+        return value; // not retained
+
+    impl->entries.insert(std::make_pair(H, value));
+    impl->stats.entries++;
+    impl->stats.bytesRetained += value.size();
+    return value;
+}
+
+ArrayDedup::Stats ArrayDedup::stats() const
+{
+    Guard G(impl->lock);
+    return impl->stats;
+}
+
+size_t ArrayDedup::prune()
+{
+    // destroy outside of lock
+    std::vector<shared_vector<const void> > junk;
+    Guard G(impl->lock);
+    return impl->prune(junk);
+}
+
+void ArrayDedup::clear()
+{
+    Impl::entries_t junk;
+    {
+        Guard G(impl->lock);
+        junk.swap(impl->entries);
+        impl->stats.entries = 0u;
+        impl->stats.bytesRetained = 0u;
+    }
+}
+
+ArrayDedup& ArrayDedup::global()
+{
+    epicsThreadOnce(&globalDedup_once, &globalDedup_init, 0);
+    if(!globalDedup)
+        throw std::runtime_error("Failed to create global ArrayDedup");
+    return *globalDedup;
+}
+
+}} // namespace epics::pvData
@@ -15,10 +15,21 @@
 
 #include <memory>
 #include <vector>
+#include <algorithm>
 #include <epicsThread.h>
 #include <epicsMutex.h>
 #include <epicsEvent.h>
 
+// Build with PVD_EVENT_NO_FUTEX defined to use epicsEvent on Linux also
+#if defined(__linux__) && !defined(PVD_EVENT_NO_FUTEX)
+#  define PVD_EVENT_FUTEX
+#  include <errno.h>
+#  include <time.h>
+#  include <unistd.h>
+#  include <sys/syscall.h>
+#  include <linux/futex.h>
+#endif
+
 #define epicsExportSharedSymbols
 #include <pv/noDefaultMethods.h>
 #include <pv/pvType.h>
@@ -27,45 +38,197 @@
 
 using std::string;
 
+namespace {
+#ifdef PVD_EVENT_FUTEX
+enum { Empty=0, Full=1, Waiters=2 };
+
+// bounds of the adaptive spin in wait()
+const unsigned minSpin = 16u, maxSpin = 4096u, initSpin = 128u;
+
+long futex_wait(int *addr, int val, const struct timespec *timeout)
+{
+    return syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, timeout, NULL, 0);
+}
+
+void futex_wake(int *addr)
+{
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+inline void cpu_relax()
+{
+#if defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+// Spinning can only help if the signaling thread runs concurrently
+bool spinUseful()
+{
+    static const bool multi = epicsThreadGetCPUs()>1;
+    return multi;
+}
+
+// Full -> 'to'
+inline bool tryTake(int *state, int to)
+{
+    int expect = Full;
+    return __atomic_compare_exchange_n(state, &expect, to, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+// Spin for up to *spin iterations.  Adjust *spin toward twice the
+// number of iterations needed when successful, and decay when not.
+bool spinTake(int *state, unsigned *spin)
+{
+    const unsigned limit = __atomic_load_n(spin, __ATOMIC_RELAXED);
+    unsigned next;
+    bool ok = false;
+    unsigned n;
+    for(n=0u; n<limit; n++) {
+        cpu_relax();
+        if(__atomic_load_n(state, __ATOMIC_RELAXED)==Full && tryTake(state, Empty)) {
+            ok = true;
+            break;
+        }
+    }
+    if(ok)
+        next = 2u*n > limit ? limit + (2u*n - limit)/8u + 1u : limit - (limit - 2u*n)/8u;
+    else
+        next = limit - limit/8u;
+    next = std::max(minSpin, std::min(maxSpin, next));
+    if(next!=limit)
+        __atomic_store_n(spin, next, __ATOMIC_RELAXED);
+    return ok;
+}
+
+// timeout<0 waits forever
+bool futexWait(int *state, unsigned *spin, double timeout)
+{
+    if(tryTake(state, Empty))
+        return true;
+    if(timeout!=0.0 && spinUseful() && spinTake(state, spin))
+        return true;
+
+    struct timespec deadline;
+    if(timeout>0.0) {
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        time_t whole = time_t(timeout);
+        deadline.tv_sec += whole;
+        deadline.tv_nsec += long((timeout-whole)*1e9);
+        if(deadline.tv_nsec>=1000000000) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+    }
+
+    // Once this waiter has marked the state as Waiters, other waiters may also be blocked.
+    // So it must leave the state as Waiters when taking the signal, to ensure that the next
+    // signal() wakes one of them.
+    bool marked = false;
+    while(true) {
+        int cur = __atomic_load_n(state, __ATOMIC_RELAXED);
+        if(cur==Full) {
+            if(tryTake(state, marked ? Waiters : Empty))
+                return true;
+            continue;
+        } else if(cur==Empty) {
+            int expect = Empty;
+            if(!__atomic_compare_exchange_n(state, &expect, Waiters, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                continue;
+        }
+        marked = true;
+
+        struct timespec rel, *prel = NULL;
+        if(timeout==0.0) {
+            return false;
+        } else if(timeout>0.0) {
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            rel.tv_sec = deadline.tv_sec - now.tv_sec;
+            rel.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+            if(rel.tv_nsec<0) {
+                rel.tv_sec--;
+                rel.tv_nsec += 1000000000;
+            }
+            if(rel.tv_sec<0)
+                return false;
+            prel = &rel;
+        }
+        // returns early on signal(), EAGAIN if state has already changed, or EINTR
+        (void)futex_wait(state, Waiters, prel);
+    }
+}
+#endif
+} // namespace
+
 namespace epics { namespace pvData {
 
 
 Event::~Event() {
-    epicsEventDestroy(id);
+    if(id)
+        epicsEventDestroy(id);
     id = 0;
 }
 
 
 Event::Event(bool full)
-: id(epicsEventCreate(full?epicsEventFull : epicsEventEmpty))
-{
-}
+#ifdef PVD_EVENT_FUTEX
+    :id(0)
+    ,state(full ? Full : Empty)
+    ,spin(initSpin)
+{}
+#else
+    :id(epicsEventCreate(full?epicsEventFull : epicsEventEmpty))
+    ,state(0)
+    ,spin(0u)
+{}
+#endif
 
 void Event::signal()
 {
+#ifdef PVD_EVENT_FUTEX
+    // no system call unless a waiter may be blocked
+    if(__atomic_exchange_n(&state, int(Full), __ATOMIC_RELEASE)==Waiters)
+        futex_wake(&state);
+#else
     if(id==0) throw std::logic_error(string("event was deleted"));
     epicsEventSignal(id);
+#endif
 }
 
 bool Event::wait ()
 {
+#ifdef PVD_EVENT_FUTEX
+    return futexWait(&state, &spin, -1.0);
+#else
     if(id==0) throw std::logic_error(string("event was deleted"));
     epicsEventWaitStatus status = epicsEventWait(id);
     return status==epicsEventWaitOK ? true : false;
+#endif
 }
 
 bool Event::wait ( double timeOut )
 {
+#ifdef PVD_EVENT_FUTEX
+    return futexWait(&state, &spin, timeOut<0.0 ? 0.0 : timeOut);
+#else
     if(id==0) throw std::logic_error(string("event was deleted"));
     epicsEventWaitStatus status = epicsEventWaitWithTimeout(id,timeOut);
     return status==epicsEventWaitOK ? true : false;
+#endif
 }
 
 bool Event::tryWait ()
 {
+#ifdef PVD_EVENT_FUTEX
+    return tryTake(&state, Empty);
+#else
     if(id==0) throw std::logic_error(string("event was deleted"));
     epicsEventWaitStatus status = epicsEventTryWait(id);
     return status==epicsEventWaitOK ? true : false;
+#endif
 }
 
 }}
@@ -0,0 +1,19 @@
+/* exactPow10.h */
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+/* Internal to pvData, and not installed.
+ * Shared by number parsing (parseToPOD.cpp) and printing (typeCast.cpp).
+ */
+#ifndef EXACTPOW10_H
+#define EXACTPOW10_H
+
+namespace epics { namespace pvData { namespace detail {
+
+// powers of 10 which are exactly representable, 1e0 through 1e22
+extern const double exactPow10[23];
+
+}}} // namespace epics::pvData::detail
+
+#endif // EXACTPOW10_H
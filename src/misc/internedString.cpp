@@ -0,0 +1,164 @@
+/* internedString.cpp */
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <map>
+#include <iostream>
+#include <stdexcept>
+#include <string.h>
+
+#include <epicsGuard.h>
+#include <epicsMutex.h>
+#include <epicsThread.h>
+#include <epicsAtomic.h>
+#include <epicsTypes.h>
+
+#define epicsExportSharedSymbols
+#include <pv/internedString.h>
+
+namespace {
+using namespace epics::pvData;
+
+typedef epicsGuard<epicsMutex> Guard;
+
+struct internedgbl_t {
+    epicsMutex lock;
+    // keyed by hash, like the FieldCreate cache
+    typedef std::multimap<size_t, InternedString::Entry*> table_t;
+    table_t table;
+} *internedgbl;
+
+void internedgbl_init(void *)
+{
+    try {
+        internedgbl = new internedgbl_t;
+    } catch(std::exception& e) {
+        std::cerr<<"Failed to initialize global interned string table :"<<e.what()<<"\n";
+    }
+}
+
+epicsThreadOnceId internedgbl_once = EPICS_THREAD_ONCE_INIT;
+
+void internedgbl_setup()
+{
+    epicsThreadOnce(&internedgbl_once, &internedgbl_init, 0);
+    if(!internedgbl)
+        throw std::runtime_error("Failed to initialize global interned string table");
+}
+
+} // namespace
+
+namespace epics { namespace pvData {
+
+size_t InternedString::hashOf(const char *s, size_t len)
+{
+    // 32-bit FNV-1a
+    epicsUInt32 H = 2166136261u;
+    for(size_t i=0; i<len; i++) {
+        H ^= (unsigned char)s[i];
+        H *= 16777619u;
+    }
+    return H;
+}
+
+const std::string& InternedString::empty_str()
+{
+    static const std::string empty;
+    return empty;
+}
+
+InternedString::Entry* InternedString::lookup(const char *s, size_t len)
+{
+    if(len==0u)
+        return 0;
+
+    size_t H = hashOf(s, len);
+
+    internedgbl_setup();
+    Guard G(internedgbl->lock);
+
+    std::pair<internedgbl_t::table_t::iterator, internedgbl_t::table_t::iterator> itp(internedgbl->table.equal_range(H));
+    for(; itp.first!=itp.second; ++itp.first) {
+        Entry *E = itp.first->second;
+        if(E->value.size()==len && memcmp(E->value.c_str(), s, len)==0) {
+            // count may only reach zero while locked, so E is not being free'd
+            epics::atomic::increment(E->refs);
+            return E;
+        }
+    }
+
+    Entry *E = new Entry(std::string(s, len), H);
+    try {
+        internedgbl->table.insert(std::make_pair(H, E));
+    } catch(...) {
+        delete E;
+        throw;
+    }
+    return E;
+}
+
+void InternedString::release(Entry *E)
+{
+    if(!E) return;
+
+    // Drop a reference which is not the last without locking
+    for(size_t cur = epics::atomic::get(E->refs); cur>1u; ) {
+        size_t prev = epics::atomic::compareAndSwap(E->refs, cur, cur-1u);
+        if(prev==cur)
+            return;
+        cur = prev;
+    }
+
+    // Possibly the last reference.  lookup() may add one while we wait for the lock.
+    Guard G(internedgbl->lock);
+    if(epics::atomic::decrement(E->refs)!=0)
+        return;
+
+    std::pair<internedgbl_t::table_t::iterator, internedgbl_t::table_t::iterator> itp(internedgbl->table.equal_range(E->hash));
+    for(; itp.first!=itp.second; ++itp.first) {
+        if(itp.first->second==E) {
+            internedgbl->table.erase(itp.first);
+            break;
+        }
+    }
+    delete E;
+}
+
+InternedString::InternedString(const std::string& s)
+    :entry(lookup(s.c_str(), s.size()))
+{}
+
+InternedString::InternedString(const char *s)
+    :entry(lookup(s, s ? strlen(s) : 0u))
+{}
+
+InternedString::InternedString(const InternedString& o)
+    :entry(o.entry)
+{
+    if(entry)
+        epics::atomic::increment(entry->refs);
+}
+
+InternedString::~InternedString()
+{
+    release(entry);
+}
+
+InternedString& InternedString::operator=(const InternedString& o)
+{
+    if(entry!=o.entry) {
+        InternedString temp(o);
+        swap(temp);
+    }
+    return *this;
+}
+
+size_t InternedString::count()
+{
+    internedgbl_setup();
+    Guard G(internedgbl->lock);
+    return internedgbl->table.size();
+}
+
+}} // namespace epics::pvData
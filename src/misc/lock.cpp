@@ -0,0 +1,224 @@
+/* lock.cpp */
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <iostream>
+#include <iomanip>
+#include <stdexcept>
+
+#include <epicsGuard.h>
+#include <epicsMutex.h>
+#include <epicsThread.h>
+#include <epicsAtomic.h>
+#include <epicsTime.h>
+
+#define epicsExportSharedSymbols
+#include <pv/lock.h>
+
+namespace epics { namespace pvData {
+namespace detail {
+
+int mutexStatsEnabled;
+
+struct MutexCounters {
+    // atomic
+    size_t acquired, contended;
+    size_t wait[MutexSnapshot::Stats::NBuckets];
+    size_t hold[MutexSnapshot::Stats::NBuckets];
+    MutexCounters() :acquired(0u), contended(0u) {
+        for(unsigned i=0; i<MutexSnapshot::Stats::NBuckets; i++)
+            wait[i] = hold[i] = 0u;
+    }
+};
+
+} // namespace detail
+}} // namespace epics::pvData
+
+namespace {
+using namespace epics::pvData;
+
+typedef epicsGuard<epicsMutex> Guard;
+
+struct mutexgbl_t {
+    epicsMutex lock;
+    // never free'd, as counts outlive the TrackedMutex
+    typedef std::map<std::string, detail::MutexCounters*> counters_t;
+    counters_t counters;
+} *mutexgbl;
+
+void mutexgbl_init(void *)
+{
+    try {
+        mutexgbl = new mutexgbl_t;
+    } catch(std::exception& e) {
+        std::cerr<<"Failed to initialize global mutex statistics registry :"<<e.what()<<"\n";
+    }
+}
+
+epicsThreadOnceId mutexgbl_once = EPICS_THREAD_ONCE_INIT;
+
+void mutexgbl_setup()
+{
+    epicsThreadOnce(&mutexgbl_once, &mutexgbl_init, 0);
+    if(!mutexgbl)
+        throw std::runtime_error("Failed to initialize global mutex statistics registry");
+}
+
+void addTime(size_t *hist, double t)
+{
+    unsigned i=0;
+    for(double limit=1e-6; i<MutexSnapshot::Stats::NBuckets-1u && t>=limit; i++, limit*=10.0) {}
+    epics::atomic::increment(hist[i]);
+}
+
+} // namespace
+
+namespace epics { namespace pvData {
+
+TrackedMutex::TrackedMutex(const char *name)
+    :counters(0)
+    ,depth(0u)
+    ,timing(false)
+{
+    mutexgbl_setup();
+    Guard G(mutexgbl->lock);
+    detail::MutexCounters *& C = mutexgbl->counters[name];
+    if(!C)
+        C = new detail::MutexCounters;
+    counters = C;
+}
+
+TrackedMutex::~TrackedMutex() {}
+
+void TrackedMutex::lockTracked()
+{
+    if(Mutex::tryLock()) {
+        if(depth++==0u)
+            acquired(false, 0.0);
+    } else {
+        epicsTime before(epicsTime::getCurrent());
+        Mutex::lock();
+        // can't be recursive, as the owner would not wait
+        depth++;
+        acquired(true, epicsTime::getCurrent() - before);
+    }
+}
+
+void TrackedMutex::acquired(bool contended, double wait)
+{
+    epics::atomic::increment(counters->acquired);
+    if(contended) {
+        epics::atomic::increment(counters->contended);
+        addTime(counters->wait, wait);
+    }
+    timing = true;
+    start = epicsTime::getCurrent();
+}
+
+void TrackedMutex::unlockTracked()
+{
+    addTime(counters->hold, epicsTime::getCurrent() - start);
+    timing = false;
+    Mutex::unlock();
+}
+
+void enableMutexStats(bool enable)
+{
+    epics::atomic::set(detail::mutexStatsEnabled, enable ? 1 : 0);
+}
+
+MutexSnapshot::Stats::Stats()
+    :acquired(0u)
+    ,contended(0u)
+{
+    for(unsigned i=0; i<NBuckets; i++)
+        wait[i] = hold[i] = 0u;
+}
+
+const char* MutexSnapshot::Stats::bucketName(unsigned i)
+{
+    static const char * const names[NBuckets] = {"<1us", "<10us", "<100us", "<1ms", "<10ms", "<100ms", "<1s", ">=1s"};
+    return i<NBuckets ? names[i] : "";
+}
+
+const MutexSnapshot::Stats&
+MutexSnapshot::operator[](const std::string& name) const
+{
+    static const Stats zero;
+
+    stats_map_t::const_iterator it(stats.find(name));
+    return it==stats.end() ? zero : it->second;
+}
+
+void MutexSnapshot::update()
+{
+    mutexgbl_t::counters_t counters;
+    {
+        mutexgbl_setup();
+        Guard G(mutexgbl->lock);
+        counters = mutexgbl->counters; // copy
+    }
+
+    stats.clear();
+
+    for(mutexgbl_t::counters_t::const_iterator it=counters.begin(), end=counters.end();
+        it!=end; ++it)
+    {
+        const detail::MutexCounters& C = *it->second;
+        Stats& S = stats[it->first];
+        S.acquired = epics::atomic::get(C.acquired);
+        S.contended = epics::atomic::get(C.contended);
+        for(unsigned i=0; i<Stats::NBuckets; i++) {
+            S.wait[i] = epics::atomic::get(C.wait[i]);
+            S.hold[i] = epics::atomic::get(C.hold[i]);
+        }
+    }
+}
+
+MutexSnapshot MutexSnapshot::operator-(const MutexSnapshot& rhs) const
+{
+    MutexSnapshot ret;
+
+    // names are never removed, so rhs has no names missing from lhs,
+    // unless snapshots are compared out of order.
+    for(stats_map_t::const_iterator it=stats.begin(), end=stats.end(); it!=end; ++it)
+    {
+        const Stats& L = it->second;
+        const Stats& R = rhs[it->first];
+        Stats& D = ret.stats[it->first];
+        D.acquired = L.acquired - R.acquired;
+        D.contended = L.contended - R.contended;
+        for(unsigned i=0; i<Stats::NBuckets; i++) {
+            D.wait[i] = L.wait[i] - R.wait[i];
+            D.hold[i] = L.hold[i] - R.hold[i];
+        }
+    }
+
+    return ret;
+}
+
+std::ostream& operator<<(std::ostream& strm, const MutexSnapshot& snap)
+{
+    for(MutexSnapshot::const_iterator it = snap.begin(), end = snap.end(); it!=end; ++it)
+    {
+        const MutexSnapshot::Stats& S = it->second;
+        if(S.acquired==0u) continue;
+        std::ios_base::fmtflags flags(strm.flags());
+        std::streamsize prec(strm.precision());
+        strm<<it->first<<":\t"<<S.acquired<<" acquired, "<<S.contended<<" contended ("
+            <<std::fixed<<std::setprecision(1)<<S.contention()*100.0<<"%)\n";
+        strm.flags(flags);
+        strm.precision(prec);
+        strm<<"  wait";
+        for(unsigned i=0; i<MutexSnapshot::Stats::NBuckets; i++)
+            strm<<" "<<MutexSnapshot::Stats::bucketName(i)<<":"<<S.wait[i];
+        strm<<"\n  hold";
+        for(unsigned i=0; i<MutexSnapshot::Stats::NBuckets; i++)
+            strm<<" "<<MutexSnapshot::Stats::bucketName(i)<<":"<<S.hold[i];
+        strm<<"\n";
+    }
+    return strm;
+}
+
+}} // namespace epics::pvData
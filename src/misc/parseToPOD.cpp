@@ -7,6 +7,9 @@
 #include <errno.h>
 #include <float.h>
 #include <limits.h>
+#include <math.h>
+
+#include <limits>
 
 #include <epicsVersion.h>
 
@@ -17,8 +20,10 @@
 
 #define epicsExportSharedSymbols
 #include "pv/typeCast.h"
+#include "exactPow10.h"
 
 using std::string;
+using epics::pvData::detail::exactPow10;
 
 // need to use "long long" when sizeof(int)==sizeof(long)
 #if (ULONG_MAX == 0xfffffffful) || defined(_WIN32) || defined(__rtems__) || defined(__APPLE__)
@@ -105,8 +110,169 @@ void handleParseError(int err)
     }
 }
 
+/* Fast paths for plain base 10 numbers, with optional sign and surrounding white space.
+ * These do not depend on locale.  Anything else (hex, octal, inf/nan, out of range,
+ * errors) is left to the epicsParse*() functions, which give the same result,
+ * or the same error.
+ */
+namespace {
+
+using epics::pvData::uint64;
+
+inline bool isSpaceC(char c)
+{
+    return c==' ' || c=='\t' || c=='\n' || c=='\v' || c=='\f' || c=='\r';
+}
+
+inline bool isDigitC(char c)
+{
+    return c>='0' && c<='9';
+}
+
+bool fastParseDecimal(const char *in, bool& neg, uint64& mag)
+{
+    while(isSpaceC(*in))
+        in++;
+
+    neg = *in=='-';
+    if(*in=='-' || *in=='+')
+        in++;
+
+    if(!isDigitC(*in) || (in[0]=='0' && isDigitC(in[1])))
+        return false; // no digits, or octal
+
+    mag = 0u;
+    for(unsigned ndigits=0; isDigitC(*in); in++, ndigits++) {
+        if(ndigits>=19u)
+            return false; // may overflow uint64
+        mag = mag*10u + unsigned(*in-'0');
+    }
+
+    while(isSpaceC(*in))
+        in++;
+    return *in=='\0';
+}
+
+template<typename T>
+bool fastParseSigned(const char *in, T *out)
+{
+    bool neg;
+    uint64 mag;
+    if(!fastParseDecimal(in, neg, mag))
+        return false;
+    if(neg ? mag > uint64(std::numeric_limits<T>::max())+1u
+           : mag > uint64(std::numeric_limits<T>::max()))
+        return false;
+    *out = neg ? T(epics::pvData::int64(0u-mag)) : T(mag);
+    return true;
+}
+
+template<typename T>
+bool fastParseUnsigned(const char *in, T *out)
+{
+    bool neg;
+    uint64 mag;
+    // strtoul() of a negative number has odd rules.  Leave to slow path.
+    if(!fastParseDecimal(in, neg, mag) || neg || mag > uint64(std::numeric_limits<T>::max()))
+        return false;
+    *out = T(mag);
+    return true;
+}
+
+// Exact results require that double arithmetic is not done with extended precision
+#if (defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD==0) || (!defined(FLT_EVAL_METHOD) && defined(__FLT_EVAL_METHOD__) && __FLT_EVAL_METHOD__==0)
+#  define FAST_PARSE_DOUBLE
+#endif
+
+/* When both mantissa and power of 10 are exactly representable,
+ * a single multiply or divide gives a correctly rounded result.
+ * (Clinger's fast path)
+ */
+bool fastParseDouble(const char *in, double *out)
+{
+#ifdef FAST_PARSE_DOUBLE
+    while(isSpaceC(*in))
+        in++;
+
+    const bool neg = *in=='-';
+    if(*in=='-' || *in=='+')
+        in++;
+
+    uint64 mant = 0u;
+    int exp10 = 0;
+    unsigned nsig = 0u;
+    bool digits = false;
+
+    for(; isDigitC(*in); in++) {
+        digits = true;
+        if(nsig || *in!='0') {
+            if(++nsig>19u)
+                return false;
+            mant = mant*10u + unsigned(*in-'0');
+        }
+    }
+    if(*in=='.') {
+        for(in++; isDigitC(*in); in++) {
+            digits = true;
+            if(nsig || *in!='0') {
+                if(++nsig>19u)
+                    return false;
+                mant = mant*10u + unsigned(*in-'0');
+            }
+            exp10--;
+        }
+    }
+    if(!digits)
+        return false;
+
+    if(*in=='e' || *in=='E') {
+        in++;
+        const bool eneg = *in=='-';
+        if(*in=='-' || *in=='+')
+            in++;
+        if(!isDigitC(*in))
+            return false;
+        int exp = 0;
+        for(; isDigitC(*in); in++) {
+            if(exp>1000)
+                return false;
+            exp = exp*10 + (*in-'0');
+        }
+        exp10 += eneg ? -exp : exp;
+    }
+
+    while(isSpaceC(*in))
+        in++;
+    if(*in!='\0')
+        return false;
+
+    double value;
+    if(mant==0u) {
+        value = 0.0;
+    } else if(mant > (uint64(1u)<<53) || exp10 < -22 || exp10 > 22) {
+        return false;
+    } else if(exp10<0) {
+        value = double(mant) / exactPow10[-exp10];
+    } else {
+        value = double(mant) * exactPow10[exp10];
+    }
+    *out = neg ? -value : value;
+    return true;
+#else
+    return false;
+#endif
+}
+
+} // namespace
+
 namespace epics { namespace pvData { namespace detail {
 
+const double exactPow10[23] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20,
+    1e21, 1e22,
+};
+
 void parseToPOD(const char* in, boolean *out)
 {
     if(epicsStrCaseCmp(in,"true")==0)
@@ -117,22 +283,24 @@ void parseToPOD(const char* in, boolean *out)
         throw std::runtime_error("parseToPOD: string no match true/false");
 }
 
-#define INTFN(T, S) \
+#define INTFN(T, S, FAST) \
 void parseToPOD(const char* in, T *out) { \
+    if(FAST(in, out)) return; \
     epics ## S temp; \
     int err = epicsParse ## S (in, &temp, 0, NULL); \
     if(err)   handleParseError(err); \
     else      *out = temp; \
 }
 
-INTFN(int8, Int8);
-INTFN(uint8, UInt8);
-INTFN(int16_t, Int16);
-INTFN(uint16_t, UInt16);
-INTFN(int32_t, Int32);
-INTFN(uint32_t, UInt32);
+INTFN(int8, Int8, fastParseSigned);
+INTFN(uint8, UInt8, fastParseUnsigned);
+INTFN(int16_t, Int16, fastParseSigned);
+INTFN(uint16_t, UInt16, fastParseUnsigned);
+INTFN(int32_t, Int32, fastParseSigned);
+INTFN(uint32_t, UInt32, fastParseUnsigned);
 
 void parseToPOD(const char* in, int64_t *out) {
+    if(fastParseSigned(in, out)) return;
 #ifdef NEED_LONGLONG
     int err = epicsParseLongLong(in, out, 0, NULL);
 #else
@@ -142,6 +310,7 @@ void parseToPOD(const char* in, int64_t *out) {
 }
 
 void parseToPOD(const char* in, uint64_t *out) {
+    if(fastParseUnsigned(in, out)) return;
 #ifdef NEED_LONGLONG
     int err = epicsParseULongLong(in, out, 0, NULL);
 #else
@@ -151,11 +320,20 @@ void parseToPOD(const char* in, uint64_t *out) {
 }
 
 void parseToPOD(const char* in, float *out) {
+    double temp;
+    if(fastParseDouble(in, &temp)) {
+        double mag = fabs(temp);
+        if(mag==0.0 || (mag>FLT_MIN && mag<FLT_MAX)) {
+            *out = float(temp);
+            return;
+        }
+    }
     int err = epicsParseFloat(in, out, NULL);
     if(err)   handleParseError(err);
 }
 
 void parseToPOD(const char* in, double *out) {
+    if(fastParseDouble(in, out)) return;
     int err = epicsParseDouble(in, out, NULL);
     if(err)   handleParseError(err);
 #if defined(vxWorks)
@@ -0,0 +1,207 @@
+/* arrayAllocator.h */
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#ifndef ARRAYALLOCATOR_H
+#define ARRAYALLOCATOR_H
+
+#include <stddef.h>
+
+#include <pv/noDefaultMethods.h>
+#include <pv/sharedPtr.h>
+#include <pv/sharedVector.h>
+
+#include <shareLib.h>
+
+namespace epics { namespace pvData {
+
+/** @brief Source of storage for large arrays of POD elements.
+ *
+ * Used by allocate_shared_vector(), and so by PVScalarArray when
+ * an array buffer must be (re)allocated.
+ *
+ * The allocator which was current when a buffer was allocated
+ * is kept alive until that buffer is released, so install()
+ * may be called at any time.
+ *
+ * @since 8.0.8
+ */
+class epicsShareClass ArrayAllocator
+{
+public:
+    POINTER_DEFINITIONS(ArrayAllocator);
+
+    virtual ~ArrayAllocator();
+
+    //! Alignment of a cache line, and of the widest SIMD registers in common use.
+    enum { CacheLine = 64 };
+
+    /** Return storage for at least nbytes.
+     *
+     * @param nbytes Size of request in bytes
+     * @param alignment Zero, for storage suitably aligned for any POD type.
+     *        Otherwise a power of two, eg. CacheLine.
+     * @throws std::bad_alloc
+     * @throws std::invalid_argument if alignment is not zero or a power of two
+     */
+    virtual void* allocate(size_t nbytes, size_t alignment) =0;
+    //! Release storage previously returned by allocate(nbytes, alignment)
+    virtual void deallocate(void *ptr, size_t nbytes, size_t alignment) =0;
+
+    //! The allocator currently used by allocate_shared_vector().  Never NULL.
+    static shared_pointer current();
+    //! Replace the current allocator.  NULL restores the default ArrayPool.
+    static void install(const shared_pointer& alloc);
+};
+
+/** @brief Size-classed pool of large buffers.
+ *
+ * Requests of at least minSize bytes are rounded up to one of four size classes
+ * per power of two.  Released buffers are kept on per-class free lists,
+ * up to a total of maxRetained bytes, for re-use by later requests of the same class.
+ * Smaller (or very large) requests go directly to the system allocator.
+ * Pooled buffers are aligned to ArrayAllocator::CacheLine, so requests for
+ * any alignment up to CacheLine share the same free lists.
+ *
+ * This avoids repeatedly returning large buffers to the OS and then faulting in
+ * new pages when array fields of similar size are updated at a high rate.
+ *
+ * The default allocator is an ArrayPool with minSize=64KB and maxRetained=128MB.
+ *
+ * @since 8.0.8
+ */
+class epicsShareClass ArrayPool : public ArrayAllocator
+{
+    EPICS_NOT_COPYABLE(ArrayPool)
+public:
+    POINTER_DEFINITIONS(ArrayPool);
+
+    //! Usage counters
+    struct Stats {
+        size_t requests; //!< allocate() calls for sizes which may be pooled
+        size_t hits;     //!< requests satisfied from a free list
+        size_t releases; //!< deallocate() calls for sizes which may be pooled
+        size_t dropped;  //!< releases freed because maxRetained would be exceeded
+        size_t buffersRetained; //!< buffers currently on free lists
+        size_t bytesRetained;   //!< bytes currently on free lists
+        Stats() :requests(0u), hits(0u), releases(0u), dropped(0u), buffersRetained(0u), bytesRetained(0u) {}
+        //! Fraction of requests satisfied from a free list.  [0, 1]
+        double hitRate() const { return requests ? double(hits)/requests : 0.0; }
+    };
+
+    explicit ArrayPool(size_t maxRetained = 128u*1024u*1024u,
+                       size_t minSize = 64u*1024u);
+    virtual ~ArrayPool();
+
+    virtual void* allocate(size_t nbytes, size_t alignment) OVERRIDE FINAL;
+    virtual void deallocate(void *ptr, size_t nbytes, size_t alignment) OVERRIDE FINAL;
+
+    //! Snapshot of usage counters
+    Stats stats() const;
+    //! Free all retained buffers
+    void trim();
+
+    struct Impl;
+private:
+    Impl *impl;
+};
+
+namespace detail {
+    struct allocator_array_deleter {
+        ArrayAllocator::shared_pointer alloc;
+        size_t nbytes, alignment;
+        allocator_array_deleter(const ArrayAllocator::shared_pointer& alloc, size_t nbytes, size_t alignment)
+            :alloc(alloc), nbytes(nbytes), alignment(alignment) {}
+        template<typename A>
+        void operator()(A *ptr) { alloc->deallocate((void*)ptr, nbytes, alignment); }
+    };
+
+    template<typename E>
+    struct array_allocate {
+        static shared_vector<E> op(size_t count, size_t alignment) {
+            typedef typename meta::strip_const<E>::type _E_non_const;
+            if(count==0u)
+                return shared_vector<E>();
+            else if(count > ((size_t)-1)/sizeof(E))
+                throw std::bad_alloc();
+            const size_t nbytes = count*sizeof(E);
+            ArrayAllocator::shared_pointer alloc(ArrayAllocator::current());
+            _E_non_const *raw = static_cast<_E_non_const*>(alloc->allocate(nbytes, alignment));
+            try {
+                return shared_vector<E>(raw, allocator_array_deleter(alloc, nbytes, alignment), 0u, count);
+            } catch(...) {
+                alloc->deallocate(raw, nbytes, alignment);
+                throw;
+            }
+        }
+    };
+    // strings need construction.  Use new[]
+    template<>
+    struct array_allocate<std::string> {
+        static shared_vector<std::string> op(size_t count, size_t) {
+            return shared_vector<std::string>(count);
+        }
+    };
+    template<>
+    struct array_allocate<const std::string> {
+        static shared_vector<const std::string> op(size_t count, size_t) {
+            return shared_vector<const std::string>(count);
+        }
+    };
+}
+
+/** @brief Allocate a vector of count elements from ArrayAllocator::current()
+ *
+ * E must be a POD type, as no constructors or destructors are run,
+ * or std::string, which is allocated with new[] and ignores alignment.
+ * POD element values are not initialized.
+ *
+ * @param count Number of elements
+ * @param alignment Passed to ArrayAllocator::allocate().  Zero, or a power of two.
+ * @throws std::bad_alloc if requested allocation can not be made
+ * @since 8.0.8
+ */
+template<typename E>
+inline shared_vector<E> allocate_shared_vector(size_t count, size_t alignment=0u)
+{
+    return detail::array_allocate<E>::op(count, alignment);
+}
+
+/** @brief Grow or shrink a vector whose contents will then be completely overwritten.
+ *
+ * Unlike shared_vector::resize(), existing elements are never copied.
+ * If vect uniquely owns a buffer with capacity for count elements, and which meets
+ * the requested alignment, then that buffer is re-used.
+ * Otherwise vect releases its reference and a new buffer is taken
+ * from allocate_shared_vector().
+ *
+ * After return vect.unique() and vect.size()==count, with element values unspecified.
+ *
+ @code
+   shared_vector<double> frame;
+   ...
+   resize_for_overwrite(frame, nelem, ArrayAllocator::CacheLine);
+   memcpy(frame.data(), src, nelem*sizeof(double));
+ @endcode
+ *
+ * @param vect Vector to be resized
+ * @param count New size
+ * @param alignment As allocate_shared_vector()
+ * @since 8.0.8
+ */
+template<typename E>
+void resize_for_overwrite(shared_vector<E>& vect, size_t count, size_t alignment=0u)
+{
+    if(vect.unique() && count<=vect.capacity()
+            && (alignment<=1u || ((size_t)vect.data() & (alignment-1u))==0u)) {
+        vect.resize(count);
+    } else {
+        vect.clear();
+        vect = allocate_shared_vector<E>(count, alignment);
+    }
+}
+
+}} // namespace epics::pvData
+
+#endif // ARRAYALLOCATOR_H
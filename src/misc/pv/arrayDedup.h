@@ -0,0 +1,97 @@
+/* arrayDedup.h */
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#ifndef ARRAYDEDUP_H
+#define ARRAYDEDUP_H
+
+#include <stddef.h>
+
+#include <pv/noDefaultMethods.h>
+#include <pv/sharedPtr.h>
+#include <pv/sharedVector.h>
+
+#include <shareLib.h>
+
+namespace epics { namespace pvData {
+
+/** @brief Content addressed pool of frozen arrays.
+ *
+ * dedup() returns a previously added vector with equal contents, if any,
+ * so that many fields with equal values, eg. enum choices or display limits,
+ * may share one buffer.  Otherwise the vector is added to the pool and returned.
+ *
+ * Comparison is by element type and value.  Floating point values are compared bitwise,
+ * so 0.0 and -0.0 are distinct, and NaNs with equal bits are equal.
+ *
+ * The pool holds a reference to each buffer it contains.  prune() releases
+ * buffers which are no longer used elsewhere.  This is also done as buffers
+ * are added, each time the number or size of those retained has doubled,
+ * so released buffers do not accumulate.  A buffer is not added if the total
+ * size of those retained would then exceed a limit.
+ *
+ @code
+   shared_vector<std::string> choices(2);
+   choices[0] = "Off";
+   choices[1] = "On";
+   pvChoices->replace(ArrayDedup::global().dedup(freeze(choices)));
+ @endcode
+ *
+ * See also PVStructure::deduplicate()
+ *
+ * @since 8.0.8
+ */
+class epicsShareClass ArrayDedup
+{
+    EPICS_NOT_COPYABLE(ArrayDedup)
+public:
+    POINTER_DEFINITIONS(ArrayDedup);
+
+    //! Usage counters
+    struct Stats {
+        size_t lookups;  //!< dedup() calls with a non-empty vector
+        size_t hits;     //!< lookups which found an existing buffer
+        size_t bytesSaved;    //!< Cumulative bytes of element storage in vectors replaced by hits
+        size_t entries;       //!< buffers currently in the pool
+        size_t bytesRetained; //!< bytes of element storage currently in the pool
+        Stats() :lookups(0u), hits(0u), bytesSaved(0u), entries(0u), bytesRetained(0u) {}
+        //! Fraction of lookups which found an existing buffer.  [0, 1]
+        double hitRate() const { return lookups ? double(hits)/lookups : 0.0; }
+    };
+
+    /** An empty pool
+     *
+     * @param maxBytes Limit on the bytes of element storage retained.
+     */
+    explicit ArrayDedup(size_t maxBytes = 64u*1024u*1024u);
+    ~ArrayDedup();
+
+    //! Return a vector with contents equal to value.  Either value, or one previously added.
+    template<typename E>
+    shared_vector<const E> dedup(const shared_vector<const E>& value)
+    {
+        if(value.empty())
+            return value;
+        return static_shared_vector_cast<const E>(lookup(static_shared_vector_cast<const void>(value)));
+    }
+
+    //! Snapshot of usage counters
+    Stats stats() const;
+    //! Release buffers not referenced outside the pool.  Returns the number released.
+    size_t prune();
+    //! Release all buffers
+    void clear();
+
+    //! A pool created on first use, used by default by PVStructure::deduplicate()
+    static ArrayDedup& global();
+
+    struct Impl;
+private:
+    Impl *impl;
+    shared_vector<const void> lookup(const shared_vector<const void>& value);
+};
+
+}} // namespace epics::pvData
+
+#endif // ARRAYDEDUP_H
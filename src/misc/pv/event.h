@@ -25,8 +25,14 @@ class Event;
 typedef std::tr1::shared_ptr<Event> EventPtr;
 
 /**
- * @brief C++ wrapper for epicsEvent from EPICS base.
+ * @brief Binary semaphore, with the semantics of epicsEvent from EPICS base.
  *
+ * On Linux (since 8.0.8) this is implemented directly with a futex.
+ * signal() makes no system call unless a waiter is blocked,
+ * and wait() first spins briefly, adapting the spin length to how often
+ * a signal() has recently arrived while spinning.
+ * Elsewhere, or when built with PVD_EVENT_FUTEX=NO in configure/CONFIG_SITE,
+ * a wrapper around epicsEvent.
  */
 class epicsShareClass Event {
 public:
@@ -61,7 +67,12 @@ public:
      */
     bool tryWait (); /* false if empty */
 private:
+    // NULL when futex is used
     epicsEventId id;
+    // futex word.  0 - empty, 1 - full, 2 - empty, and waiter(s) may be blocked
+    int state;
+    // current spin limit in wait()
+    unsigned spin;
 };
 
 }}
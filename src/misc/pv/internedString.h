@@ -0,0 +1,97 @@
+/* internedString.h */
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#ifndef INTERNEDSTRING_H
+#define INTERNEDSTRING_H
+
+#include <stddef.h>
+#include <string>
+#include <ostream>
+
+#include <shareLib.h>
+
+namespace epics { namespace pvData {
+
+/** @brief An immutable string shared by all equal instances in the process.
+ *
+ * All InternedStrings with equal contents refer to the same storage,
+ * so copy is a reference count increment, and comparison for equality
+ * is a pointer comparison.  The hash of the contents is computed once.
+ * Storage is free'd when the last reference is released.
+ *
+ * Construction from a std::string looks up a process-wide table under a lock,
+ * so intern strings which will be copied and compared many times.
+ * eg. field names and IDs, which FieldCreate interns.
+ *
+ @code
+   InternedString a("value"), b(std::string("value"));
+   assert(a==b && a.str()=="value");
+ @endcode
+ *
+ * @since 8.0.8
+ */
+class epicsShareClass InternedString
+{
+public:
+    struct Entry {
+        const std::string value;
+        const size_t hash;
+        size_t refs; // atomic
+        Entry(const std::string& value, size_t hash) :value(value), hash(hash), refs(1u) {}
+    };
+
+    //! The empty string
+    InternedString() :entry(0) {}
+    explicit InternedString(const std::string& s);
+    explicit InternedString(const char *s);
+    InternedString(const InternedString& o);
+    ~InternedString();
+    InternedString& operator=(const InternedString& o);
+
+    void swap(InternedString& o) {
+        Entry *temp = entry;
+        entry = o.entry;
+        o.entry = temp;
+    }
+
+    const std::string& str() const { return entry ? entry->value : empty_str(); }
+    const char* c_str() const { return str().c_str(); }
+    size_t size() const { return entry ? entry->value.size() : 0u; }
+    bool empty() const { return !entry; }
+
+    //! Equal to hashOf(str())
+    size_t hash() const { return entry ? entry->hash : hashOf(0, 0u); }
+
+    //! Hash function used by InternedString.
+    //! Compare with hash() before comparing contents with str().
+    static size_t hashOf(const std::string& s) { return hashOf(s.c_str(), s.size()); }
+    static size_t hashOf(const char *s, size_t len);
+
+    //! Number of distinct strings currently interned
+    static size_t count();
+
+    bool operator==(const InternedString& o) const { return entry==o.entry; }
+    bool operator!=(const InternedString& o) const { return entry!=o.entry; }
+
+private:
+    Entry *entry;
+    static const std::string& empty_str();
+    static Entry* lookup(const char *s, size_t len);
+    static void release(Entry *e);
+};
+
+inline bool operator==(const InternedString& a, const std::string& b) { return a.str()==b; }
+inline bool operator==(const std::string& a, const InternedString& b) { return a==b.str(); }
+inline bool operator!=(const InternedString& a, const std::string& b) { return a.str()!=b; }
+inline bool operator!=(const std::string& a, const InternedString& b) { return a!=b.str(); }
+
+inline std::ostream& operator<<(std::ostream& strm, const InternedString& s)
+{
+    return strm<<s.str();
+}
+
+}} // namespace epics::pvData
+
+#endif // INTERNEDSTRING_H
@@ -10,8 +10,13 @@
 #define LOCK_H
 
 #include <stdexcept>
+#include <map>
+#include <string>
+#include <ostream>
 
 #include <epicsMutex.h>
+#include <epicsAtomic.h>
+#include <epicsTime.h>
 #include <shareLib.h>
 
 #include <pv/noDefaultMethods.h>
@@ -27,6 +32,143 @@ namespace epics { namespace pvData {
 
 typedef epicsMutex Mutex;
 
+namespace detail {
+struct MutexCounters;
+epicsShareExtern int mutexStatsEnabled;
+}
+
+/** @brief A Mutex which can record usage statistics under a name
+ *
+ * Collection is off by default, and is switched on for all TrackedMutex
+ * with enableMutexStats().  When off, the cost over a plain Mutex
+ * is one atomic read and one branch per lock().
+ *
+ * When on, each outermost lock() (or successful tryLock()) counts one acquisition.
+ * Acquisitions which had to wait are counted as contended, and the wait time
+ * is added to a histogram.  The time from acquisition to the matching unlock()
+ * is added to a histogram of hold times.
+ * Counts are accumulated per name, so all instances of eg. Timer share one entry.
+ * Read the counts with MutexSnapshot.
+ *
+ * Statistics are only collected when locked with TrackedMutex::lock(),
+ * Lock, or epicsGuard<TrackedMutex>.  Not through a Mutex& reference.
+ *
+ * @since 8.0.8
+ */
+class epicsShareClass TrackedMutex : public Mutex
+{
+    EPICS_NOT_COPYABLE(TrackedMutex)
+public:
+    //! @param name Statistics are accumulated with those of other TrackedMutex of the same name
+    explicit TrackedMutex(const char *name);
+    ~TrackedMutex();
+
+    void lock()
+    {
+        if(::epics::atomic::get(detail::mutexStatsEnabled)) {
+            lockTracked();
+        } else {
+            Mutex::lock();
+            depth++;
+        }
+    }
+    void unlock()
+    {
+        if(depth && --depth==0u && timing)
+            unlockTracked();
+        else
+            Mutex::unlock();
+    }
+    bool tryLock()
+    {
+        if(!Mutex::tryLock())
+            return false;
+        if(depth++==0u && ::epics::atomic::get(detail::mutexStatsEnabled))
+            acquired(false, 0.0);
+        return true;
+    }
+
+private:
+    detail::MutexCounters *counters;
+    // recursion depth, and start of hold time when timing.  Guarded by this mutex
+    unsigned depth;
+    bool timing;
+    epicsTime start;
+
+    void lockTracked();
+    void unlockTracked();
+    void acquired(bool contended, double wait);
+};
+
+/** Switch collection of TrackedMutex statistics on or off for all instances.
+ * Counts collected previously are kept.
+ * @since 8.0.8
+ */
+epicsShareFunc void enableMutexStats(bool enable);
+
+/** @brief A snapshot of the statistics of all TrackedMutex names
+ *
+ @code
+   enableMutexStats(true);
+   MutexSnapshot before, after;
+   before.update();
+   ...
+   after.update();
+   std::cout<<(after-before);
+ @endcode
+ *
+ * @since 8.0.8
+ */
+class epicsShareClass MutexSnapshot
+{
+public:
+    //! Counts for one name
+    struct Stats {
+        //! Histogram buckets, decades from <1us to >=1s
+        enum { NBuckets = 8 };
+        size_t acquired;  //!< outermost lock() or successful tryLock()
+        size_t contended; //!< acquisitions which had to wait
+        size_t wait[NBuckets]; //!< histogram of wait times of contended acquisitions
+        size_t hold[NBuckets]; //!< histogram of times from acquisition to release
+        Stats();
+        //! Fraction of acquisitions which had to wait.  [0, 1]
+        double contention() const { return acquired ? double(contended)/acquired : 0.0; }
+        //! Label of a histogram bucket.  eg. "<10us"
+        static const char* bucketName(unsigned i);
+    };
+
+private:
+    typedef std::map<std::string, Stats> stats_map_t;
+    stats_map_t stats;
+public:
+    typedef stats_map_t::const_iterator iterator;
+    typedef stats_map_t::const_iterator const_iterator;
+
+    /** Fetch the counts of all names.
+     *
+     * This involves many atomic reads, not a single operation.
+     */
+    void update();
+
+    const Stats& operator[](const std::string& name) const;
+
+    iterator begin() const { return stats.begin(); }
+    iterator end() const { return stats.end(); }
+    size_t size() const { return stats.size(); }
+
+    inline void swap(MutexSnapshot& o)
+    {
+        stats.swap(o.stats);
+    }
+
+    //! Compute the difference of counts lhs - rhs
+    MutexSnapshot operator-(const MutexSnapshot& rhs) const;
+};
+
+//! Print counts and histograms of all names with non-zero acquisitions
+epicsShareFunc
+std::ostream& operator<<(std::ostream& strm, const MutexSnapshot& snap);
+
 /**
  * @brief A lock for multithreading
  *
@@ -41,8 +183,16 @@ public:
      * @param m The mutex for the facility being locked.
      */
     explicit Lock(Mutex &m)
-    : mutexPtr(m), locked(true)
+    : mutexPtr(m), tracked(0), locked(true)
     { mutexPtr.lock();}
+    /**
+     * Constructor
+     * @param m The mutex for the facility being locked.
+     * @since 8.0.8
+     */
+    explicit Lock(TrackedMutex &m)
+    : mutexPtr(m), tracked(&m), locked(true)
+    { tracked->lock();}
     /**
      * Destructor
      * Note that destructor does an automatic unlock.
@@ -56,7 +206,10 @@ public:
     {
         if(!locked) 
         {
-            mutexPtr.lock();
+            if(tracked)
+                tracked->lock();
+            else
+                mutexPtr.lock();
             locked = true;
         }
     }
@@ -67,7 +220,10 @@ public:
     {
         if(locked)
         {
-            mutexPtr.unlock();
+            if(tracked)
+                tracked->unlock();
+            else
+                mutexPtr.unlock();
             locked=false;
         }
     }
@@ -78,7 +234,7 @@ public:
     bool tryLock()
     {
          if(locked) return true;
-         if(mutexPtr.tryLock()) {
+         if(tracked ? tracked->tryLock() : mutexPtr.tryLock()) {
              locked = true;
              return true;
          }
@@ -91,6 +247,7 @@ public:
     bool ownsLock() const{return locked;}
 private:
     Mutex &mutexPtr;
+    TrackedMutex *tracked;
     bool locked;
 };
 
@@ -47,14 +47,76 @@
 
 #include <epicsVersion.h>
 #include <epicsAtomic.h>
+#include <epicsThread.h>
 
-#define REFTRACE_INCREMENT(counter) ::epics::atomic::increment(counter)
-#define REFTRACE_DECREMENT(counter) ::epics::atomic::decrement(counter)
+#define REFTRACE_INCREMENT(counter) ::epics::refIncrement(counter)
+#define REFTRACE_DECREMENT(counter) ::epics::refDecrement(counter)
 
 #include <shareLib.h>
 
 namespace epics {
 
+/** @brief An instance counter split into shards, to avoid contention between threads.
+ *
+ * Each thread increments or decrements one of several shards, each on its own cache line,
+ * chosen by a hash of the thread ID.  So threads which construct and destroy
+ * many objects at once seldom touch the same cache line.
+ * Reading sums all shards, and is much more expensive than an update.
+ *
+ * Use instead of size_t for counters which are updated very frequently.
+ * Must have static storage duration, which is zero initialized before any constructor runs.
+ *
+ @code
+   // my header.h
+   struct MyClass {
+      static epics::RefCounter num_instances;
+      ...
+   };
+   // my src.cpp
+   epics::RefCounter MyClass::num_instances;
+   // REFTRACE_INCREMENT(), REFTRACE_DECREMENT(), and registerRefCounter() as for size_t
+ @endcode
+ *
+ * @since 8.0.8
+ */
+class epicsShareClass RefCounter
+{
+public:
+    enum { NShards = 16 };
+
+    inline void increment() { ::epics::atomic::increment(shards[shard()].value); }
+    inline void decrement() { ::epics::atomic::decrement(shards[shard()].value); }
+    //! Sum of all shards.  Not a single atomic operation.
+    size_t get() const;
+
+private:
+    struct Shard {
+        size_t value;
+        char pad[64u - sizeof(size_t)];
+    }
+#ifdef __GNUC__
+    __attribute__((aligned(64)))
+#endif
+    ;
+    Shard shards[NShards];
+
+    static inline unsigned shard()
+    {
+        // thread IDs are often pointers to aligned allocations.  fold all bits into the lowest four
+        size_t id = (size_t)epicsThreadGetIdSelf();
+        id ^= id>>(sizeof(size_t)*4u);
+        id ^= id>>16u;
+        id ^= id>>8u;
+        id ^= id>>4u;
+        return unsigned(id) & (NShards-1u);
+    }
+};
+
+inline void refIncrement(size_t& counter) { ::epics::atomic::increment(counter); }
+inline void refDecrement(size_t& counter) { ::epics::atomic::decrement(counter); }
+inline void refIncrement(RefCounter& counter) { counter.increment(); }
+inline void refDecrement(RefCounter& counter) { counter.decrement(); }
+
 //! Register new global reference counter
 epicsShareFunc
 void registerRefCounter(const char *name, const size_t* counter);
@@ -63,6 +125,14 @@ void registerRefCounter(const char *name, const size_t* counter);
 epicsShareFunc
 void unregisterRefCounter(const char *name, const size_t* counter);
 
+//! Register new global sharded reference counter.  @since 8.0.8
+epicsShareFunc
+void registerRefCounter(const char *name, const RefCounter* counter);
+
+//! Remove registration of global sharded reference counter.  @since 8.0.8
+epicsShareFunc
+void unregisterRefCounter(const char *name, const RefCounter* counter);
+
 //! Fetch current value of single reference counter
 epicsShareFunc
 size_t readRefCounter(const char *name);
@@ -91,6 +161,7 @@ public:
     /** Fetch values of all reference counters.
      *
      * This involves many atomic reads, not a single operation.
+     * Shards of each RefCounter are summed here.
      */
     void update();
 
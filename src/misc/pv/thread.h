@@ -12,6 +12,7 @@
 #include <memory>
 #include <sstream>
 #include <stdexcept>
+#include <vector>
 
 #if __cplusplus>=201103L
 #include <functional>
@@ -65,6 +66,19 @@ struct MethRunner : public epicsThreadRunable
 class epicsShareClass Thread : public epicsThread {
     EPICS_NOT_COPYABLE(Thread)
 public:
+    /** @brief Scheduling policy of a new Thread
+     *
+     * Applied on Linux only.  Elsewhere, ignored.
+     *
+     * @since 8.0.8
+     */
+    enum SchedPolicy {
+        SchedDefault, //!< As chosen by epicsThread
+        SchedOther,   //!< SCHED_OTHER, normal time sharing
+        SchedFIFO,    //!< SCHED_FIFO, real-time
+        SchedRR       //!< SCHED_RR, real-time with time slices
+    };
+
     /** @brief Holds all the configuration necessary to launch a @class Thread
      *
      * The defaults may be used except for the runnable, which must be given
@@ -78,6 +92,8 @@ public:
      *  stack size: epicsThreadStackSmall
      *  auto start: true
      *  runner: nil (must be set explictly)
+     *  affinity: any CPU
+     *  policy: SchedDefault
      *
      @code
         stuct bar { void meth(); ... } X;
@@ -90,6 +106,13 @@ public:
         Thread foo(Thread::Config(&X, &bar::meth)
                     .prio(epicsThreadPriorityHigh)
                     <<"example"<<1);
+
+        // pinned to CPUs 2 and 3, with real-time scheduling
+        Thread foo(Thread::Config(&X, &bar::meth)
+                    .prio(epicsThreadPriorityHigh)
+                    .affinity(2).affinity(3)
+                    .policy(Thread::SchedFIFO)
+                    <<"example"<<2);
      @endcode
      */
     class epicsShareClass Config
@@ -97,10 +120,13 @@ public:
         unsigned int p_prio, p_stack;
         std::ostringstream p_strm;
         bool p_autostart;
+        std::vector<unsigned> p_cpus;
+        SchedPolicy p_policy;
         Runnable *p_runner;
         typedef epics::auto_ptr<Runnable> p_owned_runner_t;
         p_owned_runner_t p_owned_runner;
         friend class Thread;
+        friend class ThreadPool;
         Runnable& x_getrunner();
         void x_setdefault();
 
@@ -118,6 +144,19 @@ public:
         Config& prio(unsigned int p);
         Config& stack(epicsThreadStackSizeClass s);
         Config& autostart(bool a);
+        /** Add CPU number cpu to the set on which the thread may run.
+         * Default is any CPU.  Applied by the new thread before run().
+         * Linux only.  A failure to apply is reported, but the thread runs anyway.
+         * @since 8.0.8
+         */
+        Config& affinity(unsigned cpu);
+        /** Scheduling policy.  With SchedFIFO or SchedRR, prio() is mapped onto
+         * the range of real-time priorities.  Applied by the new thread before run().
+         * Linux only.  A failure to apply (eg. lack of privilege) is reported,
+         * but the thread runs anyway.
+         * @since 8.0.8
+         */
+        Config& policy(SchedPolicy p);
 
         //! Thread will execute Runnable::run()
         Config& run(Runnable* r);
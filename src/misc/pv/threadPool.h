@@ -0,0 +1,152 @@
+/* threadPool.h */
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <stddef.h>
+#include <string>
+
+#if __cplusplus>=201103L
+#include <functional>
+#endif
+
+#include <shareLib.h>
+
+#include <pv/noDefaultMethods.h>
+#include <pv/sharedPtr.h>
+#include <pv/thread.h>
+
+namespace epics { namespace pvData {
+
+/** @brief A fixed set of worker threads which run short tasks.
+ *
+ * Each worker has its own queue of tasks.  A worker runs the most recently
+ * queued task from its own queue, and when this is empty, steals the oldest task
+ * from the queue of another worker.  Tasks submitted by a worker are
+ * added to its own queue.  Tasks submitted by other threads are distributed round-robin.
+ *
+ * parallel_for() divides a range of indices between the workers and the calling thread.
+ *
+ @code
+   Thread::Config conf;
+   conf.prio(epicsThreadPriorityMedium)
+       <<"decode";
+   ThreadPool pool(conf, 4u); // threads "decode-1" through "decode-4"
+
+   ThreadPool::Future done(pool.submit(&myfn, &myarg));
+   ...
+   done.wait(); // re-throws any exception from myfn()
+ @endcode
+ *
+ * @since 8.0.8
+ */
+class epicsShareClass ThreadPool
+{
+    EPICS_NOT_COPYABLE(ThreadPool)
+public:
+    POINTER_DEFINITIONS(ThreadPool);
+
+    /** @brief Completion of a task queued by submit()
+     *
+     * Copies refer to the same task.  A default constructed Future is not valid().
+     */
+    class epicsShareClass Future
+    {
+    public:
+        Future();
+        ~Future();
+        //! Refers to a task
+        bool valid() const { return !!state; }
+        //! Has the task run, or failed?  True if not valid()
+        bool done() const;
+        /** Block until the task has run.
+         *
+         * When called from a worker of the same pool, other queued tasks
+         * are run while waiting.  Returns immediately if not valid().
+         *
+         * @throws std::runtime_error with the message of any exception thrown by the task
+         */
+        void wait() const;
+
+        struct State;
+    private:
+        std::tr1::shared_ptr<State> state;
+        friend class ThreadPool;
+    };
+
+    /** Start worker threads.
+     *
+     * @param conf Name, priority, stack size, CPU affinity, and scheduling policy of the workers.
+     *        Each worker thread name has "-N" appended.  Any runner is ignored.
+     * @param nworkers Number of worker threads.  Zero for one per CPU.
+     */
+    explicit ThreadPool(Thread::Config& conf, unsigned nworkers=0u);
+    //! Runs any queued tasks, then stops the workers.  Must not be called by a worker.
+    ~ThreadPool();
+
+    //! Number of worker threads
+    unsigned size() const;
+
+    //! Queue a call to (*fn)(arg)
+    Future submit(void (*fn)(void*), void *arg);
+    //! Queue a call to r->run().  r must remain valid until the task completes.
+    Future submit(Runnable *r);
+#if __cplusplus>=201103L
+    //! Queue a call to fn()
+    Future submit(std::function<void()>&& fn);
+#endif
+
+    //! Called by parallel_for() with a sub-range [first, last)
+    typedef void (*range_fn)(void *arg, size_t first, size_t last);
+
+    /** Call (*fn)(arg, first, last) for consecutive sub-ranges which together cover [begin, end)
+     *
+     * Sub-ranges have grain indices, except the last which may be shorter.
+     * Sub-ranges are handed out to workers, and to the calling thread,
+     * as each becomes free.  Returns when all sub-ranges have been processed.
+     * May be called from a worker, including from within another parallel_for().
+     *
+     * @throws std::runtime_error if fn throws.  Sub-ranges not yet started are skipped.
+     */
+    void parallel_for(size_t begin, size_t end, size_t grain, range_fn fn, void *arg);
+#if __cplusplus>=201103L
+    //! Call fn(first, last) for consecutive sub-ranges which together cover [begin, end)
+    void parallel_for(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)>& fn)
+    {
+        parallel_for(begin, end, grain, &call_range, const_cast<void*>(static_cast<const void*>(&fn)));
+    }
+#endif
+
+    /** A pool with one worker per CPU, whose workers run at the priority of the calling thread.
+     *
+     * Equivalent to global(epicsThreadGetPrioritySelf()).
+     * Used to split large array conversions, so that helpers run at the priority of the caller.
+     */
+    static ThreadPool& global();
+    /** A pool with one worker per CPU, created on first use for each priority.
+     *
+     * Workers are named "PVDPool<priority>-N".
+     * All global pools are stopped by epicsExit(), after which global() throws.
+     */
+    static ThreadPool& global(unsigned priority);
+
+    struct Impl;
+    struct Worker;
+    struct Job;
+private:
+    Impl *impl;
+    Future queue(Job *job);
+#if __cplusplus>=201103L
+    static void call_range(void *arg, size_t first, size_t last)
+    {
+        (*static_cast<const std::function<void(size_t, size_t)>*>(arg))(first, last);
+    }
+#endif
+};
+
+}} // namespace epics::pvData
+
+#endif // THREADPOOL_H
@@ -10,6 +10,9 @@
 #define TIMER_H
 #include <memory>
 #include <list>
+#include <vector>
+#include <deque>
+#include <ostream>
 
 #include <stddef.h>
 #include <stdlib.h>
@@ -59,9 +62,17 @@ public:
 private:
     epicsTime timeToRun;
     double period;
+    // position in Timer::queue when onList
+    size_t heapIndex;
+    // orders callbacks with equal timeToRun by time of scheduling
+    uint64 sequence;
     bool onList;
     bool cancelled;
     bool processing;
+    // scheduled again while processing, to run at rescheduleTime.
+    // queued when processing completes
+    bool rescheduled;
+    epicsTime rescheduleTime;
     friend class Timer;
     struct IncreasingTime;
 };
@@ -69,6 +80,12 @@ private:
 /**
  * @brief Support for delayed or periodic callback execution.
  *
+ * By default callbacks are run by the timer thread, one at a time.
+ * Optionally, expired callbacks may be handed to a pool of worker threads,
+ * so that one slow callback does not delay others.
+ * In either case, a callback is never run concurrently with itself,
+ * and a periodic callback is re-scheduled only after it returns.
+ * A callback scheduled again while it runs, eg. from callback(), is queued when it returns.
  */
 class epicsShareClass Timer : private Runnable {
 public:
@@ -78,6 +95,13 @@ public:
      * @param priority thread priority
      */
     Timer(std::string threadName, ThreadPriority priority);
+    /** Create a new timer queue with worker threads to run callbacks
+     * @param threadName name for the timer thread.  Workers are named threadName-1, threadName-2, ...
+     * @param priority thread priority of timer and worker threads
+     * @param nworkers number of worker threads.  Zero runs callbacks on the timer thread.
+     * @since 8.0.8
+     */
+    Timer(std::string threadName, ThreadPriority priority, unsigned nworkers);
     virtual ~Timer();
     //! Prevent new callbacks from being scheduled, and cancel pending callbacks
     void close();
@@ -113,23 +137,61 @@ public:
     bool isScheduled(TimerCallbackPtr const &timerCallback) const;
     /**
      * show the elements in the timer queue.
+     * Followed by histograms of callback latency (start time relative to scheduled time)
+     * and duration.
      * @param o The output stream for the output
      */
     void dump(std::ostream& o) const;
 
 private:
     virtual void run();
+    void runWorker();
+    void startWorkers(const std::string& threadName, ThreadPriority priority);
+
+    // call with mutex held, after work->callback() has returned.
+    // returns true if periodic timer phase was reset
+    bool finish(TimerCallbackPtr const &work, double waitfor,
+                const epicsTime& start, const epicsTime& end);
 
     // call with mutex held
     void addElement(TimerCallbackPtr const &timerCallback);
+    // call with mutex held
+    TimerCallbackPtr removeElement(size_t index);
+    // call with mutex held.  restore heap order after queue[index] was changed
+    void siftUp(size_t index);
+    void siftDown(size_t index);
+
+    // binary min-heap ordered by (timeToRun, sequence)
+    typedef std::vector<TimerCallbackPtr> queue_t;
+
+    // counts of times in decades from <10us to >=1s
+    struct Histogram {
+        enum {N=7};
+        size_t counts[N];
+        double max;
+        Histogram();
+        void add(double t);
+        void show(std::ostream& o, const char *name) const;
+    };
 
-    typedef std::list<TimerCallbackPtr> queue_t;
+    // expired callback waiting for a worker
+    struct Dispatch {
+        TimerCallbackPtr work;
+        double waitfor;
+        Dispatch(TimerCallbackPtr const &work, double waitfor) :work(work), waitfor(waitfor) {}
+    };
 
-    mutable Mutex mutex;
+    mutable TrackedMutex mutex;
     queue_t queue;
+    uint64 sequence;
     Event waitForWork;
     bool waiting;
     bool alive;
+    const unsigned nworkers;
+    std::deque<Dispatch> ready;
+    Event readyForWork;
+    std::vector<std::tr1::shared_ptr<Thread> > workers;
+    Histogram latency, duration;
     Thread thread;
 };
 
@@ -96,18 +96,53 @@ namespace detail {
         }
     };
 
-    // print POD to string
-    // when std::string!=FROM
-    template<typename FROM>
-    struct cast_helper<std::string, FROM, typename meta::not_same_type<std::string,FROM>::type> {
-        static std::string op(FROM from) {
+    // printPOD gives the same result as printing to a std::ostream
+    // with the "C" locale, without constructing a std::ostream.
+    epicsShareExtern std::string printPOD(boolean v);
+    epicsShareExtern std::string printPOD(int8 v);
+    epicsShareExtern std::string printPOD(uint8 v);
+    epicsShareExtern std::string printPOD(int16_t v);
+    epicsShareExtern std::string printPOD(uint16_t v);
+    epicsShareExtern std::string printPOD(int32_t v);
+    epicsShareExtern std::string printPOD(uint32_t v);
+    epicsShareExtern std::string printPOD(int64_t v);
+    epicsShareExtern std::string printPOD(uint64_t v);
+    epicsShareExtern std::string printPOD(float v);
+    epicsShareExtern std::string printPOD(double v);
+
+    template<typename T>
+    struct print_helper {
+        static std::string op(T from) {
             std::ostringstream strm;
-            strm << print_convolute<FROM>::op(from);
+            strm << print_convolute<T>::op(from);
             if(strm.fail())
                 throw std::runtime_error("Cast to string failed");
             return strm.str();
         }
     };
+#define PRINT_HELPER(T) template<> struct print_helper<T> { \
+        static FORCE_INLINE std::string op(T from) { return printPOD(from); } }
+    PRINT_HELPER(boolean);
+    PRINT_HELPER(int8);
+    PRINT_HELPER(uint8);
+    PRINT_HELPER(int16_t);
+    PRINT_HELPER(uint16_t);
+    PRINT_HELPER(int32_t);
+    PRINT_HELPER(uint32_t);
+    PRINT_HELPER(int64_t);
+    PRINT_HELPER(uint64_t);
+    PRINT_HELPER(float);
+    PRINT_HELPER(double);
+#undef PRINT_HELPER
+
+    // print POD to string
+    // when std::string!=FROM
+    template<typename FROM>
+    struct cast_helper<std::string, FROM, typename meta::not_same_type<std::string,FROM>::type> {
+        static FORCE_INLINE std::string op(FROM from) {
+            return print_helper<FROM>::op(from);
+        }
+    };
 
     // parse POD from string
     // TO!=std::string
@@ -21,16 +21,27 @@
 #define epicsExportSharedSymbols
 #include <pv/pvdVersion.h>
 #include <pv/sharedPtr.h>
+#include <pv/lock.h>
 #include "pv/reftrack.h"
 
 namespace {
 
 typedef epicsGuard<epicsMutex> Guard;
 typedef epicsGuardRelease<epicsMutex> UnGuard;
+typedef epicsGuard<epics::pvData::TrackedMutex> GblGuard;
 
 struct refgbl_t {
-    epicsMutex lock;
-    typedef std::map<std::string, const size_t*> counters_t;
+    epics::pvData::TrackedMutex lock;
+    refgbl_t() :lock("RefTrack") {}
+    // one of plain or sharded is non-NULL
+    struct counter_t {
+        const size_t *plain;
+        const epics::RefCounter *sharded;
+        counter_t() :plain(0), sharded(0) {}
+        counter_t(const size_t *plain, const epics::RefCounter *sharded) :plain(plain), sharded(sharded) {}
+        size_t read() const { return plain ? epics::atomic::get(*plain) : sharded->get(); }
+    };
+    typedef std::map<std::string, counter_t> counters_t;
     counters_t counters;
 } *refgbl;
 
@@ -56,30 +67,54 @@ void refgbl_setup()
 
 namespace epics {
 
+size_t RefCounter::get() const
+{
+    size_t sum = 0u;
+    for(unsigned i=0; i<NShards; i++)
+        sum += atomic::get(shards[i].value);
+    return sum;
+}
+
 void registerRefCounter(const char *name, const size_t* counter)
 {
     refgbl_setup();
-    Guard G(refgbl->lock);
-    refgbl->counters[name] = counter;
+    GblGuard G(refgbl->lock);
+    refgbl->counters[name] = refgbl_t::counter_t(counter, 0);
 }
 
 void unregisterRefCounter(const char *name, const size_t* counter)
 {
     refgbl_setup();
-    Guard G(refgbl->lock);
+    GblGuard G(refgbl->lock);
+    refgbl_t::counters_t::iterator it(refgbl->counters.find(name));
+    if(it!=refgbl->counters.end() && it->second.plain==counter)
+        refgbl->counters.erase(it);
+}
+
+void registerRefCounter(const char *name, const RefCounter* counter)
+{
+    refgbl_setup();
+    GblGuard G(refgbl->lock);
+    refgbl->counters[name] = refgbl_t::counter_t(0, counter);
+}
+
+void unregisterRefCounter(const char *name, const RefCounter* counter)
+{
+    refgbl_setup();
+    GblGuard G(refgbl->lock);
     refgbl_t::counters_t::iterator it(refgbl->counters.find(name));
-    if(it!=refgbl->counters.end() && it->second==counter)
+    if(it!=refgbl->counters.end() && it->second.sharded==counter)
         refgbl->counters.erase(it);
 }
 
 size_t readRefCounter(const char *name)
 {
     refgbl_setup();
-    Guard G(refgbl->lock);
+    GblGuard G(refgbl->lock);
     refgbl_t::counters_t::iterator it(refgbl->counters.find(name));
     if(it==refgbl->counters.end())
         return 0;
-    return atomic::get(*it->second);
+    return it->second.read();
 }
 
 const RefSnapshot::Count&
@@ -96,7 +131,7 @@ void RefSnapshot::update()
     refgbl_t::counters_t counters;
     {
         refgbl_setup();
-        Guard G(refgbl->lock);
+        GblGuard G(refgbl->lock);
         counters = refgbl->counters; // copy
     }
 
@@ -106,7 +141,7 @@ void RefSnapshot::update()
                                             end=counters.end();
         it!=end; ++it)
     {
-        size_t cnt = atomic::get(*it->second);
+        size_t cnt = it->second.read();
 
         counts[it->first] = Count(cnt, 0);
     }
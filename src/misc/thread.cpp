@@ -4,6 +4,15 @@
  * found in the file LICENSE that is included with the distribution
  */
 
+#include <iostream>
+
+#include <string.h>
+
+#if defined(__linux__)
+#  include <pthread.h>
+#  include <sched.h>
+#endif
+
 #include <epicsThread.h>
 #define epicsExportSharedSymbols
 #include <pv/thread.h>
@@ -37,6 +46,54 @@ struct BindRunner : public epicsThreadRunable
     }
 };
 #endif
+
+// Applies CPU affinity and scheduling policy from within the new thread
+struct SchedRunner : public epicsThreadRunable
+{
+    Runnable *inner;
+    epics::auto_ptr<Runnable> owned;
+    std::vector<unsigned> cpus;
+    Thread::SchedPolicy policy;
+    unsigned prio;
+    SchedRunner(Runnable *inner, const std::vector<unsigned>& cpus, Thread::SchedPolicy policy, unsigned prio)
+        :inner(inner), cpus(cpus), policy(policy), prio(prio)
+    {}
+    virtual ~SchedRunner() {}
+    virtual void run()
+    {
+        apply();
+        inner->run();
+    }
+    void apply()
+    {
+#if defined(__linux__)
+        int err;
+        if(!cpus.empty()) {
+            cpu_set_t mask;
+            CPU_ZERO(&mask);
+            for(size_t i=0; i<cpus.size(); i++) {
+                if(cpus[i] < CPU_SETSIZE)
+                    CPU_SET(cpus[i], &mask);
+            }
+            if((err = pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask))!=0)
+                std::cerr<<"Thread '"<<epicsThreadGetNameSelf()<<"' unable to set CPU affinity : "<<strerror(err)<<"\n";
+        }
+        if(policy!=Thread::SchedDefault) {
+            int pol = policy==Thread::SchedFIFO ? SCHED_FIFO : policy==Thread::SchedRR ? SCHED_RR : SCHED_OTHER;
+            struct sched_param param;
+            memset(&param, 0, sizeof(param));
+            if(pol!=SCHED_OTHER) {
+                int pmin = sched_get_priority_min(pol),
+                    pmax = sched_get_priority_max(pol);
+                unsigned p = prio>epicsThreadPriorityMax ? epicsThreadPriorityMax : prio;
+                param.sched_priority = pmin + int((pmax-pmin)*(p-epicsThreadPriorityMin)/(epicsThreadPriorityMax-epicsThreadPriorityMin));
+            }
+            if((err = pthread_setschedparam(pthread_self(), pol, &param))!=0)
+                std::cerr<<"Thread '"<<epicsThreadGetNameSelf()<<"' unable to set scheduling policy : "<<strerror(err)<<"\n";
+        }
+#endif
+    }
+};
 } // detail
 
 
@@ -44,6 +101,14 @@ Runnable& Thread::Config::x_getrunner()
 {
     if(!this->p_runner)
         throw std::logic_error("Thread::Config missing run()");
+    if(!this->p_cpus.empty() || this->p_policy!=SchedDefault) {
+        // wrap the runner, taking over ownership if necessary
+        detail::SchedRunner *wrap = new detail::SchedRunner(this->p_runner, this->p_cpus, this->p_policy, this->p_prio);
+        p_owned_runner_t owned(wrap);
+        epics::swap(wrap->owned, this->p_owned_runner);
+        epics::swap(this->p_owned_runner, owned);
+        this->p_runner = wrap;
+    }
     return *this->p_runner;
 }
 
@@ -51,6 +116,7 @@ void Thread::Config::x_setdefault()
 {
     this->p_prio = epicsThreadPriorityLow;
     this->p_autostart = true;
+    this->p_policy = SchedDefault;
     this->p_runner = NULL;
     (*this).stack(epicsThreadStackBig);
 }
@@ -79,6 +145,12 @@ Thread::Config& Thread::Config::stack(epicsThreadStackSizeClass s)
 Thread::Config& Thread::Config::autostart(bool a)
 { this->p_autostart = a; return *this; }
 
+Thread::Config& Thread::Config::affinity(unsigned cpu)
+{ this->p_cpus.push_back(cpu); return *this; }
+
+Thread::Config& Thread::Config::policy(SchedPolicy p)
+{ this->p_policy = p; return *this; }
+
 Thread::Config& Thread::Config::run(Runnable* r)
 { this->p_runner = r; return *this; }
 
@@ -0,0 +1,514 @@
+/* threadPool.cpp */
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <map>
+
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+#include <epicsThread.h>
+#include <epicsAtomic.h>
+#include <epicsExit.h>
+
+#define epicsExportSharedSymbols
+#include <pv/event.h>
+#include <pv/threadPool.h>
+
+typedef epicsGuard<epicsMutex> Guard;
+typedef epicsGuardRelease<epicsMutex> UnGuard;
+
+namespace {
+using namespace epics::pvData;
+
+// Worker* of the current thread, if any
+epicsThreadPrivateId workerKey;
+epicsThreadOnceId workerKey_once = EPICS_THREAD_ONCE_INIT;
+
+void workerKey_init(void *)
+{
+    workerKey = epicsThreadPrivateCreate();
+}
+
+void workerKey_setup()
+{
+    epicsThreadOnce(&workerKey_once, &workerKey_init, 0);
+}
+
+ThreadPool::Worker* currentWorker()
+{
+    workerKey_setup();
+    return static_cast<ThreadPool::Worker*>(epicsThreadPrivateGet(workerKey));
+}
+
+// ThreadPool::global() pools, by worker priority
+struct GlobalPools {
+    epicsMutex lock;
+    std::map<unsigned, ThreadPool*> pools;
+    bool closed;
+    GlobalPools() :closed(false) {}
+};
+GlobalPools *globalPools;
+epicsThreadOnceId globalPools_once = EPICS_THREAD_ONCE_INIT;
+
+void globalPools_stop(void *)
+{
+    std::map<unsigned, ThreadPool*> pools;
+    {
+        Guard G(globalPools->lock);
+        globalPools->closed = true;
+        pools.swap(globalPools->pools);
+    }
+    for(std::map<unsigned, ThreadPool*>::iterator it(pools.begin()), end(pools.end()); it!=end; ++it)
+        delete it->second; // joins workers
+}
+
+void globalPools_init(void *)
+{
+    try {
+        globalPools = new GlobalPools;
+        epicsAtExit(&globalPools_stop, 0);
+    } catch(std::exception& e) {
+        std::cerr<<"Failed to create global ThreadPool : "<<e.what()<<"\n";
+    }
+}
+
+} // namespace
+
+namespace epics { namespace pvData {
+
+struct ThreadPool::Future::State {
+    epicsMutex lock;
+    Event wakeup;
+    ThreadPool::Impl * const pool;
+    bool complete;
+    std::string error; // non-empty if task failed
+
+    explicit State(ThreadPool::Impl *pool) :pool(pool), complete(false) {}
+
+    void finish(const std::string& msg) {
+        {
+            Guard G(lock);
+            complete = true;
+            error = msg;
+        }
+        wakeup.signal();
+    }
+};
+
+struct ThreadPool::Job {
+    // NULL for parallel_for() helpers
+    std::tr1::shared_ptr<Future::State> state;
+    virtual ~Job() {}
+    virtual void run() =0;
+};
+
+struct ThreadPool::Worker {
+    ThreadPool::Impl * const pool;
+    const unsigned index;
+    epicsMutex lock;
+    // owner takes from back, thieves from front
+    std::deque<Job*> jobs;
+    Event wakeup;
+    std::tr1::shared_ptr<Thread> thread;
+
+    Worker(ThreadPool::Impl *pool, unsigned index) :pool(pool), index(index) {}
+    ~Worker() {
+        for(size_t i=0; i<jobs.size(); i++)
+            delete jobs[i];
+    }
+
+    void run();
+};
+
+struct ThreadPool::Impl {
+    std::vector<Worker*> workers;
+    // number of queued Jobs.  atomic
+    size_t pending;
+    // number of workers waiting for work.  atomic
+    size_t nidle;
+    // round-robin for submit() by non-workers.  atomic
+    size_t nextWorker;
+
+    // guards idle and running
+    epicsMutex idleLock;
+    std::vector<Worker*> idle;
+    bool running;
+
+    Impl() :pending(0u), nidle(0u), nextWorker(0u), running(true) {}
+
+    void push(Job *job)
+    {
+        Worker *self = currentWorker();
+        Worker *dest = self && self->pool==this ? self
+                     : workers[epics::atomic::increment(nextWorker)%workers.size()];
+        {
+            Guard G(dest->lock);
+            dest->jobs.push_back(job);
+        }
+        // pairs with the check of 'pending' in Worker::run()
+        epics::atomic::increment(pending);
+        if(epics::atomic::get(nidle)) {
+            Worker *waker = 0;
+            {
+                Guard G(idleLock);
+                if(!idle.empty()) {
+                    waker = idle.back();
+                    idle.pop_back();
+                    epics::atomic::decrement(nidle);
+                }
+            }
+            if(waker)
+                waker->wakeup.signal();
+        }
+    }
+
+    // Own queue first, then steal
+    Job* take(Worker *self)
+    {
+        const size_t N = workers.size();
+        const size_t first = self ? self->index : 0u;
+        for(size_t i=0; i<N; i++) {
+            Worker *W = workers[(first+i)%N];
+            Job *job = 0;
+            {
+                Guard G(W->lock);
+                if(W->jobs.empty())
+                    continue;
+                if(W==self) {
+                    job = W->jobs.back();
+                    W->jobs.pop_back();
+                } else {
+                    job = W->jobs.front();
+                    W->jobs.pop_front();
+                }
+            }
+            epics::atomic::decrement(pending);
+            return job;
+        }
+        return 0;
+    }
+
+    // Wait for queued Jobs to complete, then join workers
+    void stop()
+    {
+        {
+            Guard G(idleLock);
+            running = false;
+            for(size_t i=0; i<idle.size(); i++)
+                idle[i]->wakeup.signal();
+            idle.clear();
+        }
+        for(size_t i=0; i<workers.size(); i++)
+            workers[i]->thread.reset(); // joins
+        for(size_t i=0; i<workers.size(); i++)
+            delete workers[i];
+        workers.clear();
+    }
+
+    static void runJob(Job *job)
+    {
+        std::string error;
+        try {
+            job->run();
+        } catch(std::exception& e) {
+            error = e.what();
+            if(error.empty())
+                error = "Unknown exception";
+        } catch(...) {
+            error = "Unknown exception";
+        }
+        if(job->state)
+            job->state->finish(error);
+        delete job;
+    }
+};
+
+void ThreadPool::Worker::run()
+{
+    workerKey_setup();
+    epicsThreadPrivateSet(workerKey, this);
+    while(true) {
+        Job *job = pool->take(this);
+        if(job) {
+            Impl::runJob(job);
+            continue;
+        }
+
+        {
+            Guard G(pool->idleLock);
+            if(!pool->running && epics::atomic::get(pool->pending)==0u)
+                break;
+            // pairs with the check of 'nidle' in Impl::push()
+            epics::atomic::increment(pool->nidle);
+            if(epics::atomic::get(pool->pending)) {
+                epics::atomic::decrement(pool->nidle);
+                continue;
+            }
+            pool->idle.push_back(this);
+        }
+        wakeup.wait();
+    }
+    epicsThreadPrivateSet(workerKey, 0);
+}
+
+namespace {
+struct FuncJob : public ThreadPool::Job {
+    void (*fn)(void*);
+    void *arg;
+    FuncJob(void (*fn)(void*), void *arg) :fn(fn), arg(arg) {}
+    virtual ~FuncJob() {}
+    virtual void run() { (*fn)(arg); }
+};
+
+struct RunnableJob : public ThreadPool::Job {
+    Runnable *runner;
+    explicit RunnableJob(Runnable *runner) :runner(runner) {}
+    virtual ~RunnableJob() {}
+    virtual void run() { runner->run(); }
+};
+
+#if __cplusplus>=201103L
+struct BindJob : public ThreadPool::Job {
+    std::function<void()> fn;
+    explicit BindJob(std::function<void()>&& fn) :fn(std::move(fn)) {}
+    virtual ~BindJob() {}
+    virtual void run() { fn(); }
+};
+#endif
+
+// State of one parallel_for() call, shared with helper Jobs which may
+// only run after the call has returned.
+struct ForState {
+    ThreadPool::range_fn fn;
+    void *arg;
+    size_t begin, end, grain, nchunks;
+    // atomic counters
+    size_t next, ncomplete;
+    int failed;
+    Event alldone;
+    epicsMutex lock;
+    std::string error;
+
+    // Process chunks until none remain
+    void work()
+    {
+        size_t idx;
+        while((idx = epics::atomic::increment(next)-1u) < nchunks) {
+            if(!epics::atomic::get(failed)) {
+                const size_t first = begin + idx*grain;
+                const size_t last = end-first > grain ? first+grain : end;
+                try {
+                    (*fn)(arg, first, last);
+                } catch(std::exception& e) {
+                    fail(e.what());
+                } catch(...) {
+                    fail("Unknown exception");
+                }
+            }
+            if(epics::atomic::increment(ncomplete)==nchunks)
+                alldone.signal();
+        }
+    }
+
+    void fail(const char *msg)
+    {
+        Guard G(lock);
+        if(!failed) {
+            error = msg && msg[0] ? msg : "Unknown exception";
+            epics::atomic::set(failed, 1);
+        }
+    }
+};
+
+struct ForJob : public ThreadPool::Job {
+    std::tr1::shared_ptr<ForState> forstate;
+    explicit ForJob(const std::tr1::shared_ptr<ForState>& forstate) :forstate(forstate) {}
+    virtual ~ForJob() {}
+    virtual void run() { forstate->work(); }
+};
+} // namespace
+
+ThreadPool::Future::Future() {}
+ThreadPool::Future::~Future() {}
+
+bool ThreadPool::Future::done() const
+{
+    if(!state)
+        return true;
+    Guard G(state->lock);
+    return state->complete;
+}
+
+void ThreadPool::Future::wait() const
+{
+    if(!state)
+        return;
+
+    Worker *self = currentWorker();
+    if(self && self->pool!=state->pool)
+        self = 0;
+
+    Guard G(state->lock);
+    while(!state->complete) {
+        UnGuard U(G);
+        // A worker waiting on a task of its own pool runs other tasks
+        // so that the one waited on can not be starved.
+        Job *job = self ? self->pool->take(self) : 0;
+        if(job)
+            Impl::runJob(job);
+        else
+            state->wakeup.wait();
+    }
+    // pass wakeup on to any other waiter
+    state->wakeup.signal();
+    if(!state->error.empty())
+        throw std::runtime_error(state->error);
+}
+
+ThreadPool::ThreadPool(Thread::Config& conf, unsigned nworkers)
+    :impl(new Impl)
+{
+    if(nworkers==0u) {
+        int ncpus = epicsThreadGetCPUs();
+        nworkers = ncpus>0 ? unsigned(ncpus) : 1u;
+    }
+    const std::string name(conf.p_strm.str());
+    try {
+        // all Workers must exist before any may try to steal
+        impl->workers.reserve(nworkers);
+        for(unsigned i=0; i<nworkers; i++)
+            impl->workers.push_back(new Worker(impl, i));
+
+        for(unsigned i=0; i<nworkers; i++) {
+            Worker *W = impl->workers[i];
+            Thread::Config wconf(W, &Worker::run);
+            wconf.prio(conf.p_prio)
+                 .autostart(true)
+                 <<name<<'-'<<(i+1u);
+            wconf.p_stack = conf.p_stack;
+            wconf.p_cpus = conf.p_cpus;
+            wconf.p_policy = conf.p_policy;
+            W->thread.reset(new Thread(wconf));
+        }
+    } catch(...) {
+        impl->stop();
+        delete impl;
+        throw;
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    impl->stop();
+    delete impl;
+}
+
+unsigned ThreadPool::size() const
+{
+    return impl->workers.size();
+}
+
+ThreadPool::Future ThreadPool::queue(Job *job)
+{
+    Future ret;
+    try {
+        ret.state.reset(new Future::State(impl));
+        job->state = ret.state;
+    } catch(...) {
+        delete job;
+        throw;
+    }
+    impl->push(job);
+    return ret;
+}
+
+ThreadPool::Future ThreadPool::submit(void (*fn)(void*), void *arg)
+{
+    return queue(new FuncJob(fn, arg));
+}
+
+ThreadPool::Future ThreadPool::submit(Runnable *r)
+{
+    return queue(new RunnableJob(r));
+}
+
+#if __cplusplus>=201103L
+ThreadPool::Future ThreadPool::submit(std::function<void()>&& fn)
+{
+    return queue(new BindJob(std::move(fn)));
+}
+#endif
+
+void ThreadPool::parallel_for(size_t begin, size_t end, size_t grain, range_fn fn, void *arg)
+{
+    if(end<=begin)
+        return;
+    if(grain==0u)
+        grain = 1u;
+    const size_t nchunks = (end-begin-1u)/grain + 1u;
+    if(nchunks==1u) {
+        (*fn)(arg, begin, end);
+        return;
+    }
+
+    std::tr1::shared_ptr<ForState> S(new ForState);
+    S->fn = fn;
+    S->arg = arg;
+    S->begin = begin;
+    S->end = end;
+    S->grain = grain;
+    S->nchunks = nchunks;
+    S->next = S->ncomplete = 0u;
+    S->failed = 0;
+
+    // the caller is one of the participants
+    const size_t nhelpers = std::min(nchunks-1u, impl->workers.size());
+    for(size_t i=0; i<nhelpers; i++)
+        impl->push(new ForJob(S));
+
+    S->work();
+
+    while(epics::atomic::get(S->ncomplete)<nchunks)
+        S->alldone.wait();
+
+    if(S->failed)
+        throw std::runtime_error(S->error);
+}
+
+ThreadPool& ThreadPool::global()
+{
+    return global(epicsThreadGetPrioritySelf());
+}
+
+ThreadPool& ThreadPool::global(unsigned priority)
+{
+    epicsThreadOnce(&globalPools_once, &globalPools_init, 0);
+    if(!globalPools)
+        throw std::runtime_error("Failed to create global ThreadPool");
+
+    Guard G(globalPools->lock);
+    if(globalPools->closed)
+        throw std::runtime_error("global ThreadPool stopped by epicsExit()");
+    ThreadPool*& pool = globalPools->pools[priority];
+    if(!pool) {
+        try {
+            Thread::Config conf;
+            conf.prio(priority)
+                .stack(epicsThreadStackBig)
+                <<"PVDPool"<<priority;
+            pool = new ThreadPool(conf);
+        } catch(...) {
+            globalPools->pools.erase(priority);
+            throw;
+        }
+    }
+    return *pool;
+}
+
+}} // namespace epics::pvData
@@ -10,6 +10,7 @@
 #include <stdexcept>
 #include <string>
 #include <iostream>
+#include <algorithm>
 
 #include <epicsThread.h>
 #include <epicsGuard.h>
@@ -23,42 +24,162 @@ namespace epics { namespace pvData {
 
 TimerCallback::TimerCallback()
 : period(0.0),
+  heapIndex(0u),
+  sequence(0u),
   onList(false),
   cancelled(false),
-  processing(false)
+  processing(false),
+  rescheduled(false)
 {
 }
 
 Timer::Timer(string threadName,ThreadPriority priority)
-    :waitForWork(false)
+    :mutex("Timer")
+    ,sequence(0u)
+    ,waitForWork(false)
     ,waiting(false)
     ,alive(true)
+    ,nworkers(0u)
+    ,readyForWork(false)
     ,thread(threadName,priority,this)
 {}
 
+Timer::Timer(string threadName, ThreadPriority priority, unsigned nworkers)
+    :mutex("Timer")
+    ,sequence(0u)
+    ,waitForWork(false)
+    ,waiting(false)
+    ,alive(true)
+    ,nworkers(nworkers)
+    ,readyForWork(false)
+    ,thread(threadName,priority,this)
+{
+    try {
+        startWorkers(threadName, priority);
+    } catch(...) {
+        close();
+        throw;
+    }
+}
+
+void Timer::startWorkers(const std::string& threadName, ThreadPriority priority)
+{
+    workers.reserve(nworkers);
+    for(unsigned i=0; i<nworkers; i++) {
+        Thread::Config conf(this, &Timer::runWorker);
+        conf.prio(priority)
+            .stack(epicsThreadStackBig)
+            <<threadName<<"-"<<(i+1u);
+        workers.push_back(std::tr1::shared_ptr<Thread>(new Thread(conf)));
+    }
+}
+
+Timer::Histogram::Histogram()
+    :max(0.0)
+{
+    for(size_t i=0; i<N; i++)
+        counts[i] = 0u;
+}
+
+void Timer::Histogram::add(double t)
+{
+    size_t i=0;
+    for(double limit=1e-5; i<N-1u && t>=limit; i++, limit*=10.0) {}
+    counts[i]++;
+    if(t > max)
+        max = t;
+}
+
+void Timer::Histogram::show(std::ostream& o, const char *name) const
+{
+    static const char * const labels[N] = {"<10us", "<100us", "<1ms", "<10ms", "<100ms", "<1s", ">=1s"};
+    o << name;
+    for(size_t i=0; i<N; i++)
+        o << " " << labels[i] << ":" << counts[i];
+    o << " max " << max << "\n";
+}
+
 struct TimerCallback::IncreasingTime {
-    bool operator()(const TimerCallbackPtr& lhs, const TimerCallbackPtr& rhs) {
+    bool operator()(const TimerCallbackPtr& lhs, const TimerCallbackPtr& rhs) const {
         assert(lhs && rhs);
-        return lhs->timeToRun < rhs->timeToRun;
+        return lhs->timeToRun < rhs->timeToRun
+                || (lhs->timeToRun == rhs->timeToRun && lhs->sequence < rhs->sequence);
     }
 };
 
+// call with mutex held
+void Timer::siftUp(size_t index)
+{
+    TimerCallback::IncreasingTime before;
+    while(index>0u) {
+        size_t parent = (index-1u)/2u;
+        if(!before(queue[index], queue[parent]))
+            break;
+        queue[index].swap(queue[parent]);
+        queue[index]->heapIndex = index;
+        queue[parent]->heapIndex = parent;
+        index = parent;
+    }
+}
+
+// call with mutex held
+void Timer::siftDown(size_t index)
+{
+    TimerCallback::IncreasingTime before;
+    const size_t N = queue.size();
+    while(true) {
+        size_t first = index,
+               left = 2u*index+1u,
+               right = left+1u;
+        if(left<N && before(queue[left], queue[first]))
+            first = left;
+        if(right<N && before(queue[right], queue[first]))
+            first = right;
+        if(first==index)
+            break;
+        queue[index].swap(queue[first]);
+        queue[index]->heapIndex = index;
+        queue[first]->heapIndex = first;
+        index = first;
+    }
+}
+
 // call with mutex held
 void Timer::addElement(TimerCallbackPtr const & timerCallback)
 {
     assert(!timerCallback->onList);
 
-    queue_t temp;
-    temp.push_back(timerCallback);
+    timerCallback->sequence = sequence++;
+    timerCallback->heapIndex = queue.size();
+    queue.push_back(timerCallback);
 
     timerCallback->onList = true;
     timerCallback->cancelled = false;
 
-    // merge sorted lists.
-    // for us effectively insertion sort.
-    queue.merge(temp, TimerCallback::IncreasingTime());
+    siftUp(timerCallback->heapIndex);
 }
 
+// call with mutex held
+TimerCallbackPtr Timer::removeElement(size_t index)
+{
+    TimerCallbackPtr ret;
+    ret.swap(queue[index]);
+    ret->onList = false;
+
+    const size_t last = queue.size()-1u;
+    if(index!=last) {
+        // move last into the hole, which then moves up or down
+        queue[index].swap(queue[last]);
+        queue[index]->heapIndex = index;
+    }
+    queue.pop_back();
+    if(index<queue.size()) {
+        TimerCallback *moved = queue[index].get();
+        siftUp(index);
+        siftDown(moved->heapIndex);
+    }
+    return ret;
+}
 
 bool Timer::cancel(TimerCallbackPtr const &timerCallback)
 {
@@ -66,6 +187,7 @@ bool Timer::cancel(TimerCallbackPtr const &timerCallback)
     /* If we're processing, just set the cancel flag */
     if (timerCallback->processing) {
         timerCallback->cancelled = true;
+        timerCallback->rescheduled = false;
         return true;
     }
     if(!timerCallback->onList) return false;
@@ -73,28 +195,55 @@ bool Timer::cancel(TimerCallbackPtr const &timerCallback)
         timerCallback->onList = false;
         return true;
     }
-    for(queue_t::iterator it(queue.begin()), end(queue.end()); it != end; ++it)
-    {
-        TimerCallbackPtr& cur = *it;
-        if(cur.get() == timerCallback.get()) {
-            cur->onList = false;
-            queue.erase(it); // invalidates cur and it
-            return true;
-        }
-    }
-    throw std::logic_error("Timer::cancel() onList==true, but not found");
+    const size_t index = timerCallback->heapIndex;
+    if(index>=queue.size() || queue[index].get()!=timerCallback.get())
+        throw std::logic_error("Timer::cancel() onList==true, but not found");
+    removeElement(index);
+    return true;
 }
 
 bool Timer::isScheduled(TimerCallbackPtr const &timerCallback) const
 {
     Lock xx(mutex);
-    return timerCallback->onList;
+    return timerCallback->onList || timerCallback->rescheduled;
 }
 
 
+// call with mutex held, after work->callback() has returned.
+bool Timer::finish(TimerCallbackPtr const &work, double waitfor,
+                   const epicsTime& start, const epicsTime& end)
+{
+    bool reset = false;
+
+    work->processing = false;
+
+    latency.add(start - work->timeToRun);
+    duration.add(end - start);
+
+    if(work->rescheduled) {
+        // scheduled again by, or while waiting for, callback().
+        // queued even if !alive, for close() to call timerStopped()
+        work->rescheduled = false;
+        work->timeToRun = work->rescheduleTime;
+        addElement(work);
+
+    } else if(work->period > 0.0 && alive && !work->cancelled) {
+        if(waitfor <= -work->period) {
+            // Periodic timer phase has fallen behind by at least one full period.
+            // Could be due to previous slow jobs, or a system time jump forward.
+            // Reset the phase.
+            work->timeToRun = end;
+            reset = true;
+        }
+        work->timeToRun += work->period;
+        addElement(work);
+    }
+    return reset;
+}
+
 void Timer::run()
 {
-    epicsGuard<epicsMutex> G(mutex);
+    epicsGuard<TrackedMutex> G(mutex);
 
     epicsTime now(epicsTime::getCurrent());
 
@@ -104,7 +253,7 @@ void Timer::run()
         if(queue.empty()) {
             // no jobs, just go to sleep
             waiting = true;
-            epicsGuardRelease<epicsMutex> U(G);
+            epicsGuardRelease<TrackedMutex> U(G);
 
             waitForWork.wait();
             now = epicsTime::getCurrent();
@@ -112,37 +261,35 @@ void Timer::run()
         } else if((waitfor = queue.front()->timeToRun - now) <= 0) {
             // execute first expired job
 
-            TimerCallbackPtr work;
-            work.swap(queue.front());
-            work->onList = false;
+            TimerCallbackPtr work(removeElement(0u));
             work->processing = true;
-            queue.pop_front();
 
+            if(nworkers) {
+                // hand off to a worker
+                ready.push_back(Dispatch(work, waitfor));
+                if(ready.size()==1u)
+                    readyForWork.signal();
+                continue;
+            }
+
+            epicsTime start, end;
             {
-                epicsGuardRelease<epicsMutex> U(G);
+                epicsGuardRelease<TrackedMutex> U(G);
 
+                start = epicsTime::getCurrent();
                 work->callback();
+                end = epicsTime::getCurrent();
             }
 
-            work->processing = false;
-
-            if(work->period > 0.0 && alive && !work->cancelled) {
-                if(waitfor <= -work->period) {
-                    // Periodic timer phase has fallen behind by at least one full period.
-                    // Could be due to previous slow jobs, or a system time jump forward.
-                    // Reset the phase.
-                    work->timeToRun = now = epicsTime::getCurrent();
-                }
-                work->timeToRun += work->period;
-                addElement(work);
-            }
+            if(finish(work, waitfor, start, end))
+                now = end;
 
             // don't update 'now' until all expired jobs run
 
         } else {
             waiting = true;
             // wait for first un-expired
-            epicsGuardRelease<epicsMutex> U(G);
+            epicsGuardRelease<TrackedMutex> U(G);
 
             waitForWork.wait(waitfor);
             now = epicsTime::getCurrent();
@@ -151,6 +298,55 @@ void Timer::run()
     }
 }
 
+void Timer::runWorker()
+{
+    epicsGuard<TrackedMutex> G(mutex);
+
+    while(alive) {
+        if(ready.empty()) {
+            epicsGuardRelease<TrackedMutex> U(G);
+            readyForWork.wait();
+            continue;
+        }
+
+        Dispatch next(ready.front());
+        ready.pop_front();
+        if(!ready.empty())
+            readyForWork.signal(); // wake another worker
+
+        if(next.work->cancelled || next.work->rescheduled) {
+            // cancel()'d, or scheduled again, while waiting for a worker.
+            // not run, but queued again if re-scheduled.
+            next.work->processing = false;
+            next.work->cancelled = false;
+            if(next.work->rescheduled) {
+                next.work->rescheduled = false;
+                next.work->timeToRun = next.work->rescheduleTime;
+                addElement(next.work);
+                if(waiting && queue.front()==next.work)
+                    waitForWork.signal();
+            }
+            continue;
+        }
+
+        epicsTime start, end;
+        {
+            epicsGuardRelease<TrackedMutex> U(G);
+
+            start = epicsTime::getCurrent();
+            next.work->callback();
+            end = epicsTime::getCurrent();
+        }
+
+        finish(next.work, next.waitfor, start, end);
+
+        if(waiting && next.work->onList && queue.front()==next.work)
+            waitForWork.signal(); // timer thread should wait for less time
+    }
+    // wake another worker to notice !alive
+    readyForWork.signal();
+}
+
 Timer::~Timer() {
     close();
 }
@@ -164,12 +360,26 @@ void Timer::close() {
     }
     waitForWork.signal();
     thread.exitWait();
+    readyForWork.signal();
+    for(size_t i=0; i<workers.size(); i++)
+        workers[i]->exitWait();
 
     queue_t temp;
-    temp.swap(queue);
-
-    for(;!temp.empty(); temp.pop_front()) {
-        TimerCallbackPtr& head = temp.front();
+    // expired, but not yet run by a worker
+    for(size_t i=0; i<ready.size(); i++) {
+        ready[i].work->processing = false;
+        ready[i].work->rescheduled = false;
+        if(!ready[i].work->cancelled)
+            temp.push_back(ready[i].work);
+    }
+    ready.clear();
+    temp.insert(temp.end(), queue.begin(), queue.end());
+    queue.clear();
+    // notify in order of expiration
+    std::sort(temp.begin(), temp.end(), TimerCallback::IncreasingTime());
+
+    for(queue_t::iterator it(temp.begin()), end(temp.end()); it != end; ++it) {
+        TimerCallbackPtr& head = *it;
         head->onList = false;
         head->timerStopped();
     }
@@ -192,7 +402,7 @@ void Timer::schedulePeriodic(
     bool wakeup;
     {
         Lock xx(mutex);
-        if(timerCallback->onList) {
+        if(timerCallback->onList || timerCallback->rescheduled) {
             throw std::logic_error(string("already queued"));
         }
 
@@ -202,9 +412,19 @@ void Timer::schedulePeriodic(
             return;
         }
 
-        timerCallback->timeToRun = now + delay;
         timerCallback->period = period;
 
+        if(timerCallback->processing) {
+            // running, or waiting for a worker.  never run concurrently with itself,
+            // so queued by finish(), or runWorker().
+            timerCallback->rescheduleTime = now + delay;
+            timerCallback->cancelled = false;
+            timerCallback->rescheduled = true;
+            return;
+        }
+
+        timerCallback->timeToRun = now + delay;
+
         addElement(timerCallback);
         wakeup = waiting && queue.front()==timerCallback;
     }
@@ -217,11 +437,18 @@ void Timer::dump(std::ostream& o) const
     if(!alive) return;
     epicsTime now(epicsTime::getCurrent());
 
-    for(queue_t::const_iterator it(queue.begin()), end(queue.end()); it!=end; ++it) {
+    queue_t sorted(queue);
+    std::sort(sorted.begin(), sorted.end(), TimerCallback::IncreasingTime());
+
+    for(queue_t::const_iterator it(sorted.begin()), end(sorted.end()); it!=end; ++it) {
         const TimerCallbackPtr& nodeToCall = *it;
         o << "timeToRun " << (nodeToCall->timeToRun - now)
           << " period " << nodeToCall->period << "\n";
     }
+    if(nworkers)
+        o << "workers " << nworkers << " ready " << ready.size() << "\n";
+    latency.show(o, "latency ");
+    duration.show(o, "duration");
 }
 
 std::ostream& operator<<(std::ostream& o, const Timer& timer)
@@ -5,19 +5,34 @@
 /* Author:  Michael Davidsaver */
 #include <algorithm>
 #include <sstream>
+#include <vector>
 
 #include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <float.h>
 
 #include <epicsConvert.h>
+#include <epicsMath.h>
+#include <epicsStdio.h>
+#include <epicsThread.h>
 
 #define epicsExportSharedSymbols
 #include "pv/typeCast.h"
+#include "pv/threadPool.h"
+#include "exactPow10.h"
 
 using epics::pvData::castUnsafe;
 using epics::pvData::ScalarType;
 using epics::pvData::pvString;
+using epics::pvData::detail::exactPow10;
 using std::string;
 
+// Numeric kernels are compiled a second time for AVX2, and selected at runtime.
+#if (defined(__x86_64__) || defined(__i386__)) && ((defined(__GNUC__) && __GNUC__>=5) || defined(__clang__))
+#  define PVD_CAST_AVX2
+#endif
+
 namespace {
 
 static void noconvert()
@@ -31,10 +46,9 @@ static void castVTyped(size_t count, void *draw, const void *sraw)
     TO *dest=(TO*)draw;
     const FROM *src=(FROM*)sraw;
 
-    //std::transform(src, src+count, dest, castUnsafe<TO,FROM>);
-
+    size_t i=0;
     try {
-        for(size_t i=0; i<count; i++) {
+        for(; i<count; i++) {
             dest[i] = castUnsafe<TO,FROM>(src[i]);
         }
     } catch (std::exception& ex) {
@@ -42,7 +56,7 @@ static void castVTyped(size_t count, void *draw, const void *sraw)
         if (count > 1)
         {
             std::ostringstream os;
-            os << "failed to parse element at index " << (src - (FROM*)sraw);
+            os << "failed to parse element at index " << i;
             os << ": " << ex.what();
             throw std::runtime_error(os.str());
         }
@@ -51,6 +65,138 @@ static void castVTyped(size_t count, void *draw, const void *sraw)
     }
 }
 
+typedef void (*kernel_t)(size_t count, void *draw, const void *sraw);
+
+/* Conversions between numeric types can not throw, and are written as
+ * simple loops which the compiler can vectorize.
+ */
+template<typename TO, typename FROM>
+struct castLoop {
+    static FORCE_INLINE void op(size_t count, TO *dest, const FROM *src)
+    {
+        for(size_t i=0; i<count; i++) {
+            dest[i] = castUnsafe<TO,FROM>(src[i]);
+        }
+    }
+};
+
+// epicsConvertDoubleToFloat() clamps, so can not be vectorized.
+// Test blocks of values, and use a plain cast where this gives the same result.
+template<>
+struct castLoop<float, double> {
+    static FORCE_INLINE void op(size_t count, float *dest, const double *src)
+    {
+        while(count) {
+            const size_t n = std::min(count, size_t(64u));
+
+            int inrange = 1;
+            for(size_t i=0; i<n; i++) {
+                const double mag = fabs(src[i]);
+                epics::pvData::uint64 bits;
+                memcpy(&bits, &src[i], sizeof(bits));
+                // non short-circuit to avoid branches.  Only +0.0 is exact.
+                inrange &= (int(mag>FLT_MIN) & int(mag<FLT_MAX)) | int(bits==0u);
+            }
+
+            if(inrange) {
+                for(size_t i=0; i<n; i++) {
+                    dest[i] = float(src[i]);
+                }
+            } else {
+                for(size_t i=0; i<n; i++) {
+                    dest[i] = epicsConvertDoubleToFloat(src[i]);
+                }
+            }
+
+            count -= n;
+            dest += n;
+            src += n;
+        }
+    }
+};
+
+template<typename TO, typename FROM>
+struct castKernel {
+    static void generic(size_t count, void *draw, const void *sraw)
+    {
+        castLoop<TO,FROM>::op(count, (TO*)draw, (const FROM*)sraw);
+    }
+#ifdef PVD_CAST_AVX2
+    __attribute__((target("avx2")))
+    static void avx2(size_t count, void *draw, const void *sraw)
+    {
+        castLoop<TO,FROM>::op(count, (TO*)draw, (const FROM*)sraw);
+    }
+#endif
+};
+
+bool detectAVX2()
+{
+#ifdef PVD_CAST_AVX2
+    // may run before other global ctors
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+const bool have_avx2 = detectAVX2();
+
+// Conversions larger than this (in bytes of source or destination) are split between threads
+const size_t parallel_threshold = 4u<<20;
+const size_t max_parallel = 8u;
+
+// Converts a sub-range of elements
+struct castRange {
+    kernel_t kernel;
+    void *dest;
+    const void *src;
+    size_t destSize, srcSize;
+
+    static void run(void *raw, size_t first, size_t last)
+    {
+        castRange *self = (castRange*)raw;
+        (*self->kernel)(last-first,
+                        (char*)self->dest + first*self->destSize,
+                        (const char*)self->src + first*self->srcSize);
+    }
+};
+
+size_t castParallelism(size_t nbytes)
+{
+    static const size_t ncpus = std::max(1, epicsThreadGetCPUs());
+    return std::min(std::min(ncpus, max_parallel), nbytes/parallel_threshold);
+}
+
+template<typename TO, typename FROM>
+static void castVNumeric(size_t count, void *draw, const void *sraw)
+{
+    kernel_t kernel = &castKernel<TO,FROM>::generic;
+#ifdef PVD_CAST_AVX2
+    if(have_avx2)
+        kernel = &castKernel<TO,FROM>::avx2;
+#endif
+
+    size_t nparts = castParallelism(count*std::max(sizeof(TO), sizeof(FROM)));
+    if(nparts<=1u) {
+        (*kernel)(count, draw, sraw);
+        return;
+    }
+
+    castRange range;
+    range.kernel = kernel;
+    range.dest = draw;
+    range.src = sraw;
+    range.destSize = sizeof(TO);
+    range.srcSize = sizeof(FROM);
+    // whole cache lines in each part
+    size_t grain = std::max((count/nparts) & ~size_t(63u), size_t(64u));
+
+    // caller converts one part, helpers run at the priority of the caller
+    epics::pvData::ThreadPool::global().parallel_for(0u, count, grain, &castRange::run, &range);
+}
+
 template<typename T>
 static void copyV(size_t count, void *draw, const void *sraw)
 {
@@ -65,14 +211,191 @@ static void copyMem(size_t count, void *draw, const void *sraw)
     memcpy(draw, sraw, count*N);
 }
 
+// format integer in base 10.  Returns start of string, which ends at 'end'
+template<typename U>
+char* printDecimal(char *end, U mag, bool neg)
+{
+    char *pos = end;
+    do {
+        *--pos = char('0' + mag%10u);
+        mag /= 10u;
+    } while(mag);
+    if(neg)
+        *--pos = '-';
+    return pos;
+}
+
+template<typename T, typename U>
+std::string printInteger(T val)
+{
+    char buf[24];
+    char *end = buf+sizeof(buf);
+    bool neg = val<0;
+    // negate in unsigned to handle minimum value
+    U mag = neg ? U(0u)-U(val) : U(val);
+    return std::string(printDecimal(end, mag, neg), end);
+}
+
+/* Find 6 significant digits of mag>0, correctly rounded, and the decimal exponent.
+ * mag is scaled by an exact power of 10 to [1e5, 1e6), which adds an error
+ * of less than 1e-9.  Gives up if the result is this close to a rounding tie.
+ */
+bool fastDigits(double mag, char *digits, int& exponent)
+{
+    if(mag>=1e22)
+        return false;
+
+    // estimate exponent.  Corrected below if necessary.
+    int exp = 0;
+    while(mag>=exactPow10[exp+1])
+        exp++;
+    while(exp>-17 && mag*exactPow10[-exp]<1.0)
+        exp--;
+
+    for(unsigned iter=0; iter<3u; iter++) {
+        const int k = 5-exp;
+        if(k<-22 || k>22)
+            return false;
+        const double scaled = k>=0 ? mag*exactPow10[k] : mag/exactPow10[-k];
+
+        if(scaled<1e5) {
+            exp--;
+            continue;
+        } else if(scaled>=1e6) {
+            exp++;
+            continue;
+        }
+
+        double ipart = floor(scaled);
+        const double frac = scaled - ipart;
+        if(fabs(frac-0.5)<1e-9)
+            return false; // too close to call
+
+        epics::pvData::uint32 rounded = epics::pvData::uint32(ipart) + (frac>0.5 ? 1u : 0u);
+        if(rounded==1000000u) {
+            rounded = 100000u;
+            exp++;
+        }
+        for(unsigned i=6u; i; i--) {
+            digits[i-1u] = char('0' + rounded%10u);
+            rounded /= 10u;
+        }
+        exponent = exp;
+        return true;
+    }
+    return false;
+}
+
+/* Equivalent to printf("%g"), precision 6.
+ * When not found by fastDigits(), the rounded digits are found with "%.5e",
+ * ignoring the decimal point character, which depends on locale.
+ */
+std::string printFloating(double val)
+{
+    char buf[40];
+
+    if(isnan(val) || isinf(val)) {
+        epicsSnprintf(buf, sizeof(buf), "%g", val);
+        return buf;
+    }
+
+    // sign bit, including -0.0
+    epics::pvData::uint64 bits;
+    memcpy(&bits, &val, sizeof(bits));
+    const bool neg = (bits>>63)!=0u;
+
+    const double mag = fabs(val);
+    if(mag<1e6 && mag==floor(mag)) {
+        // integer value printed without exponent.
+        char *end = buf+sizeof(buf);
+        return std::string(printDecimal(end, epics::pvData::uint32(mag), neg), end);
+    }
+
+    char digits[6];
+    unsigned ndigits = 6u;
+    int exponent;
+
+    if(!fastDigits(mag, digits, exponent)) {
+        epicsSnprintf(buf, sizeof(buf), "%.5e", val);
+
+        ndigits = 0u;
+        const char *pos = buf;
+        for(; *pos && *pos!='e'; pos++) {
+            if(*pos>='0' && *pos<='9' && ndigits<6u)
+                digits[ndigits++] = *pos;
+        }
+        if(ndigits!=6u || *pos!='e')
+            throw std::runtime_error("Cast to string failed");
+        exponent = atoi(pos+1);
+    }
+
+    // ignore trailing zeros
+    while(ndigits>1u && digits[ndigits-1u]=='0')
+        ndigits--;
+
+    std::string ret;
+    ret.reserve(16u);
+    if(neg)
+        ret.push_back('-');
+
+    if(exponent<-4 || exponent>=6) {
+        ret.push_back(digits[0]);
+        if(ndigits>1u) {
+            ret.push_back('.');
+            ret.append(digits+1, ndigits-1u);
+        }
+        char *end = buf+sizeof(buf);
+        char *start = printDecimal(end, unsigned(abs(exponent)), false);
+        if(end-start<2)
+            *--start = '0';
+        *--start = exponent<0 ? '-' : '+';
+        *--start = 'e';
+        ret.append(start, end);
+
+    } else if(exponent<0) {
+        ret.append("0.");
+        ret.append(size_t(-exponent-1), '0');
+        ret.append(digits, ndigits);
+
+    } else {
+        const unsigned nint = unsigned(exponent)+1u;
+        if(ndigits<=nint) {
+            ret.append(digits, ndigits);
+            ret.append(nint-ndigits, '0');
+        } else {
+            ret.append(digits, nint);
+            ret.push_back('.');
+            ret.append(digits+nint, ndigits-nint);
+        }
+    }
+    return ret;
+}
+
 } // end namespace
 
 namespace epics { namespace pvData {
 
+namespace detail {
+
+std::string printPOD(boolean v) { return v ? "true" : "false"; }
+std::string printPOD(int8 v) { return printInteger<int8, uint8>(v); }
+std::string printPOD(uint8 v) { return printInteger<uint8, uint8>(v); }
+std::string printPOD(int16_t v) { return printInteger<int16_t, uint16_t>(v); }
+std::string printPOD(uint16_t v) { return printInteger<uint16_t, uint16_t>(v); }
+std::string printPOD(int32_t v) { return printInteger<int32_t, uint32_t>(v); }
+std::string printPOD(uint32_t v) { return printInteger<uint32_t, uint32_t>(v); }
+std::string printPOD(int64_t v) { return printInteger<int64_t, uint64_t>(v); }
+std::string printPOD(uint64_t v) { return printInteger<uint64_t, uint64_t>(v); }
+std::string printPOD(float v) { return printFloating(v); }
+std::string printPOD(double v) { return printFloating(v); }
+
+} // namespace detail
+
 void castUnsafeV(size_t count, ScalarType to, void *dest, ScalarType from, const void *src)
 {
 #define COPYMEM(N) copyMem<N>(count, dest, src)
 #define CAST(TO, FROM) castVTyped<TO, FROM>(count, dest, src)
+#define CASTN(TO, FROM) castVNumeric<TO, FROM>(count, dest, src)
 
     switch(to) {
     case pvBoolean:
@@ -88,14 +411,14 @@ void castUnsafeV(size_t count, ScalarType to, void *dest, ScalarType from, const
         case pvBoolean: noconvert(); return;
         case pvByte:
         case pvUByte:   COPYMEM(1); return;
-        case pvShort:   CAST(int8, int16); return;
-        case pvUShort:  CAST(int8, uint16); return;
-        case pvInt:     CAST(int8, int32); return;
-        case pvUInt:    CAST(int8, uint32); return;
-        case pvLong:    CAST(int8, int64); return;
-        case pvULong:   CAST(int8, uint64); return;
-        case pvFloat:   CAST(int8, float); return;
-        case pvDouble:  CAST(int8, double); return;
+        case pvShort:   CASTN(int8, int16); return;
+        case pvUShort:  CASTN(int8, uint16); return;
+        case pvInt:     CASTN(int8, int32); return;
+        case pvUInt:    CASTN(int8, uint32); return;
+        case pvLong:    CASTN(int8, int64); return;
+        case pvULong:   CASTN(int8, uint64); return;
+        case pvFloat:   CASTN(int8, float); return;
+        case pvDouble:  CASTN(int8, double); return;
         case pvString:  CAST(int8, std::string); return;
         }
         break;
@@ -105,14 +428,14 @@ void castUnsafeV(size_t count, ScalarType to, void *dest, ScalarType from, const
         case pvBoolean: noconvert(); return;
         case pvByte:
         case pvUByte:   COPYMEM(1); return;
-        case pvShort:   CAST(uint8, int16); return;
-        case pvUShort:  CAST(uint8, uint16); return;
-        case pvInt:     CAST(uint8, int32); return;
-        case pvUInt:    CAST(uint8, uint32); return;
-        case pvLong:    CAST(uint8, int64); return;
-        case pvULong:   CAST(uint8, uint64); return;
-        case pvFloat:   CAST(uint8, float); return;
-        case pvDouble:  CAST(uint8, double); return;
+        case pvShort:   CASTN(uint8, int16); return;
+        case pvUShort:  CASTN(uint8, uint16); return;
+        case pvInt:     CASTN(uint8, int32); return;
+        case pvUInt:    CASTN(uint8, uint32); return;
+        case pvLong:    CASTN(uint8, int64); return;
+        case pvULong:   CASTN(uint8, uint64); return;
+        case pvFloat:   CASTN(uint8, float); return;
+        case pvDouble:  CASTN(uint8, double); return;
         case pvString:  CAST(uint8, std::string); return;
         }
         break;
@@ -120,16 +443,16 @@ void castUnsafeV(size_t count, ScalarType to, void *dest, ScalarType from, const
     case pvShort:
         switch(from) {
         case pvBoolean: noconvert(); return;
-        case pvByte:    CAST(int16, int8); return;
-        case pvUByte:   CAST(int16, uint8); return;
+        case pvByte:    CASTN(int16, int8); return;
+        case pvUByte:   CASTN(int16, uint8); return;
         case pvShort:
         case pvUShort:  COPYMEM(2); return;
-        case pvInt:     CAST(int16, int32); return;
-        case pvUInt:    CAST(int16, uint32); return;
-        case pvLong:    CAST(int16, int64); return;
-        case pvULong:   CAST(int16, uint64); return;
-        case pvFloat:   CAST(int16, float); return;
-        case pvDouble:  CAST(int16, double); return;
+        case pvInt:     CASTN(int16, int32); return;
+        case pvUInt:    CASTN(int16, uint32); return;
+        case pvLong:    CASTN(int16, int64); return;
+        case pvULong:   CASTN(int16, uint64); return;
+        case pvFloat:   CASTN(int16, float); return;
+        case pvDouble:  CASTN(int16, double); return;
         case pvString:  CAST(int16, std::string); return;
         }
         break;
@@ -137,16 +460,16 @@ void castUnsafeV(size_t count, ScalarType to, void *dest, ScalarType from, const
     case pvUShort:
         switch(from) {
         case pvBoolean: noconvert(); return;
-        case pvByte:    CAST(uint16, int8); return;
-        case pvUByte:   CAST(uint16, uint8); return;
+        case pvByte:    CASTN(uint16, int8); return;
+        case pvUByte:   CASTN(uint16, uint8); return;
         case pvShort:
         case pvUShort:  COPYMEM(2); return;
-        case pvInt:     CAST(uint16, int32); return;
-        case pvUInt:    CAST(uint16, uint32); return;
-        case pvLong:    CAST(uint16, int64); return;
-        case pvULong:   CAST(uint16, uint64); return;
-        case pvFloat:   CAST(uint16, float); return;
-        case pvDouble:  CAST(uint16, double); return;
+        case pvInt:     CASTN(uint16, int32); return;
+        case pvUInt:    CASTN(uint16, uint32); return;
+        case pvLong:    CASTN(uint16, int64); return;
+        case pvULong:   CASTN(uint16, uint64); return;
+        case pvFloat:   CASTN(uint16, float); return;
+        case pvDouble:  CASTN(uint16, double); return;
         case pvString:  CAST(uint16, std::string); return;
         }
         break;
@@ -154,16 +477,16 @@ void castUnsafeV(size_t count, ScalarType to, void *dest, ScalarType from, const
     case pvInt:
         switch(from) {
         case pvBoolean: noconvert(); return;
-        case pvByte:    CAST(int32, int8); return;
-        case pvUByte:   CAST(int32, uint8); return;
-        case pvShort:   CAST(int32, int16); return;
-        case pvUShort:  CAST(int32, uint16); return;
+        case pvByte:    CASTN(int32, int8); return;
+        case pvUByte:   CASTN(int32, uint8); return;
+        case pvShort:   CASTN(int32, int16); return;
+        case pvUShort:  CASTN(int32, uint16); return;
         case pvInt:
         case pvUInt:    COPYMEM(4); return;
-        case pvLong:    CAST(int32, int64); return;
-        case pvULong:   CAST(int32, uint64); return;
-        case pvFloat:   CAST(int32, float); return;
-        case pvDouble:  CAST(int32, double); return;
+        case pvLong:    CASTN(int32, int64); return;
+        case pvULong:   CASTN(int32, uint64); return;
+        case pvFloat:   CASTN(int32, float); return;
+        case pvDouble:  CASTN(int32, double); return;
         case pvString:  CAST(int32, std::string); return;
         }
         break;
@@ -171,16 +494,16 @@ void castUnsafeV(size_t count, ScalarType to, void *dest, ScalarType from, const
     case pvUInt:
         switch(from) {
         case pvBoolean: noconvert(); return;
-        case pvByte:    CAST(uint32, int8); return;
-        case pvUByte:   CAST(uint32, uint8); return;
-        case pvShort:   CAST(uint32, int16); return;
-        case pvUShort:  CAST(uint32, uint16); return;
+        case pvByte:    CASTN(uint32, int8); return;
+        case pvUByte:   CASTN(uint32, uint8); return;
+        case pvShort:   CASTN(uint32, int16); return;
+        case pvUShort:  CASTN(uint32, uint16); return;
         case pvInt:
         case pvUInt:    COPYMEM(4); return;
-        case pvLong:    CAST(uint32, int64); return;
-        case pvULong:   CAST(uint32, uint64); return;
-        case pvFloat:   CAST(uint32, float); return;
-        case pvDouble:  CAST(uint32, double); return;
+        case pvLong:    CASTN(uint32, int64); return;
+        case pvULong:   CASTN(uint32, uint64); return;
+        case pvFloat:   CASTN(uint32, float); return;
+        case pvDouble:  CASTN(uint32, double); return;
         case pvString:  CAST(uint32, std::string); return;
         }
         break;
@@ -188,16 +511,16 @@ void castUnsafeV(size_t count, ScalarType to, void *dest, ScalarType from, const
     case pvLong:
         switch(from) {
         case pvBoolean: noconvert(); return;
-        case pvByte:    CAST(int64, int8); return;
-        case pvUByte:   CAST(int64, uint8); return;
-        case pvShort:   CAST(int64, int16); return;
-        case pvUShort:  CAST(int64, uint16); return;
-        case pvInt:     CAST(int64, int32); return;
-        case pvUInt:    CAST(int64, uint32); return;
+        case pvByte:    CASTN(int64, int8); return;
+        case pvUByte:   CASTN(int64, uint8); return;
+        case pvShort:   CASTN(int64, int16); return;
+        case pvUShort:  CASTN(int64, uint16); return;
+        case pvInt:     CASTN(int64, int32); return;
+        case pvUInt:    CASTN(int64, uint32); return;
         case pvLong:
         case pvULong:   COPYMEM(8); return;
-        case pvFloat:   CAST(int64, float); return;
-        case pvDouble:  CAST(int64, double); return;
+        case pvFloat:   CASTN(int64, float); return;
+        case pvDouble:  CASTN(int64, double); return;
         case pvString:  CAST(int64, std::string); return;
         }
         break;
@@ -205,16 +528,16 @@ void castUnsafeV(size_t count, ScalarType to, void *dest, ScalarType from, const
     case pvULong:
         switch(from) {
         case pvBoolean: noconvert(); return;
-        case pvByte:    CAST(uint64, int8); return;
-        case pvUByte:   CAST(uint64, uint8); return;
-        case pvShort:   CAST(uint64, int16); return;
-        case pvUShort:  CAST(uint64, uint16); return;
-        case pvInt:     CAST(uint64, int32); return;
-        case pvUInt:    CAST(uint64, uint32); return;
+        case pvByte:    CASTN(uint64, int8); return;
+        case pvUByte:   CASTN(uint64, uint8); return;
+        case pvShort:   CASTN(uint64, int16); return;
+        case pvUShort:  CASTN(uint64, uint16); return;
+        case pvInt:     CASTN(uint64, int32); return;
+        case pvUInt:    CASTN(uint64, uint32); return;
         case pvLong:
         case pvULong:   COPYMEM(8); return;
-        case pvFloat:   CAST(uint64, float); return;
-        case pvDouble:  CAST(uint64, double); return;
+        case pvFloat:   CASTN(uint64, float); return;
+        case pvDouble:  CASTN(uint64, double); return;
         case pvString:  CAST(uint64, std::string); return;
         }
         break;
@@ -222,16 +545,16 @@ void castUnsafeV(size_t count, ScalarType to, void *dest, ScalarType from, const
     case pvFloat:
         switch(from) {
         case pvBoolean: noconvert(); return;
-        case pvByte:    CAST(float, int8); return;
-        case pvUByte:   CAST(float, uint8); return;
-        case pvShort:   CAST(float, int16); return;
-        case pvUShort:  CAST(float, uint16); return;
-        case pvInt:     CAST(float, int32); return;
-        case pvUInt:    CAST(float, uint32); return;
-        case pvLong:    CAST(float, int64); return;
-        case pvULong:   CAST(float, uint64); return;
+        case pvByte:    CASTN(float, int8); return;
+        case pvUByte:   CASTN(float, uint8); return;
+        case pvShort:   CASTN(float, int16); return;
+        case pvUShort:  CASTN(float, uint16); return;
+        case pvInt:     CASTN(float, int32); return;
+        case pvUInt:    CASTN(float, uint32); return;
+        case pvLong:    CASTN(float, int64); return;
+        case pvULong:   CASTN(float, uint64); return;
         case pvFloat:   COPYMEM(4); return;
-        case pvDouble:  CAST(float, double); return;
+        case pvDouble:  CASTN(float, double); return;
         case pvString:  CAST(float, std::string); return;
         }
         break;
@@ -239,15 +562,15 @@ void castUnsafeV(size_t count, ScalarType to, void *dest, ScalarType from, const
     case pvDouble:
         switch(from) {
         case pvBoolean: noconvert(); return;
-        case pvByte:    CAST(double, int8); return;
-        case pvUByte:   CAST(double, uint8); return;
-        case pvShort:   CAST(double, int16); return;
-        case pvUShort:  CAST(double, uint16); return;
-        case pvInt:     CAST(double, int32); return;
-        case pvUInt:    CAST(double, uint32); return;
-        case pvLong:    CAST(double, int64); return;
-        case pvULong:   CAST(double, uint64); return;
-        case pvFloat:   CAST(double, float); return;
+        case pvByte:    CASTN(double, int8); return;
+        case pvUByte:   CASTN(double, uint8); return;
+        case pvShort:   CASTN(double, int16); return;
+        case pvUShort:  CASTN(double, uint16); return;
+        case pvInt:     CASTN(double, int32); return;
+        case pvUInt:    CASTN(double, uint32); return;
+        case pvLong:    CASTN(double, int64); return;
+        case pvULong:   CASTN(double, uint64); return;
+        case pvFloat:   CASTN(double, float); return;
         case pvDouble:  COPYMEM(8); return;
         case pvString:  CAST(double, std::string); return;
         }
@@ -23,6 +23,8 @@
 #include <pv/typeCast.h>
 #include <pv/anyscalar.h>
 #include <pv/sharedVector.h>
+#include <pv/arrayDedup.h>
+#include <pv/bitSet.h>
 
 #include <shareLib.h>
 #include <compilerDependencies.h>
@@ -124,6 +126,47 @@ typedef std::tr1::shared_ptr<PVUnionArrayPtrArray> PVUnionArrayPtrArrayPtr;
 class PVDataCreate;
 typedef std::tr1::shared_ptr<PVDataCreate> PVDataCreatePtr;
 
+/**
+ * @brief Bytes of memory used by a tree of PVFields
+ *
+ * Returned by PVField::memoryUsage().  Sizes of objects are exact,
+ * while heap allocation overheads, and the sizes of shared_ptr
+ * control blocks, are estimates.
+ *
+ * @since 8.0.8
+ */
+struct MemoryUsage {
+    size_t fields;          //!< Number of PVField instances
+    size_t objectBytes;     //!< PVField instances, and the vectors of sub-fields of PVStructures
+    size_t stringBytes;     //!< Heap storage of PVString values
+    size_t exclusiveArrayBytes; //!< Array storage referenced only from this tree
+    size_t sharedArrayBytes;    //!< Array storage also referenced elsewhere.  eg. by a monitor queue
+    size_t controlBlockBytes;   //!< shared_ptr control blocks of PVFields and array storage
+    MemoryUsage()
+        :fields(0u), objectBytes(0u), stringBytes(0u)
+        ,exclusiveArrayBytes(0u), sharedArrayBytes(0u), controlBlockBytes(0u)
+    {}
+    //! All bytes, including shared array storage
+    size_t total() const {
+        return exclusive() + sharedArrayBytes;
+    }
+    //! Bytes which would be free'd if this tree were destroyed
+    size_t exclusive() const {
+        return objectBytes + stringBytes + exclusiveArrayBytes + controlBlockBytes;
+    }
+    MemoryUsage& operator+=(const MemoryUsage& o) {
+        fields += o.fields;
+        objectBytes += o.objectBytes;
+        stringBytes += o.stringBytes;
+        exclusiveArrayBytes += o.exclusiveArrayBytes;
+        sharedArrayBytes += o.sharedArrayBytes;
+        controlBlockBytes += o.controlBlockBytes;
+        return *this;
+    }
+};
+
+epicsShareExtern std::ostream& operator<<(std::ostream& o, const MemoryUsage& usage);
+
 /**
  * @brief This class is implemented by code that calls setPostHander
  *
@@ -140,6 +183,18 @@ public:
      * This is called every time postPut is called for this field.
      */
     virtual void postPut() = 0;
+    /**
+     * Called once when a PVStructure::Transaction on the structure with this handler ends,
+     * in place of postPut() for each field posted during the transaction.
+     * Not called if no field was posted.
+     *
+     * The default calls postPut() of each posted sub-field once,
+     * which calls any PostHandler of that sub-field, and then postPut() of this handler.
+     * @param top The structure with this handler.
+     * @param changed Offsets of the fields posted.
+     * @since 8.0.8
+     */
+    virtual void postTransaction(PVStructure& top, const BitSet& changed);
 };
 
 /**
@@ -163,7 +218,7 @@ public:
      * Get the fieldName for this field.
      * @return The name or empty string if top-level field.
      */
-    inline const std::string& getFieldName() const {return fieldName;}
+    inline const std::string& getFieldName() const {return fieldName.str();}
     /**
      * Fully expand the name of this field using the
      * names of its parent fields with a dot '.' separating
@@ -214,6 +269,7 @@ public:
     inline const PVStructure * getParent() const {return parent;}
     /**
      * postPut. Called when the field is updated by the implementation.
+     * Deferred while a PVStructure::Transaction is active on this field or a parent.
      */
     void postPut() ;
     /**
@@ -238,7 +294,32 @@ public:
     void copy(const PVField& from);
     void copyUnchecked(const PVField& from);
 
-    static size_t num_instances; // use atomic::get() or volatile* access
+    /** Memory used by this field, and any sub-fields.
+     *
+     * Elements of structure and union arrays are included.
+     * The introspection (Field) instances are not, as these are shared.
+     * See FieldCreate::cacheStats().
+     *
+     * @since 8.0.8
+     */
+    MemoryUsage memoryUsage() const;
+
+    /** Hash of the value of this field, and any sub-fields.
+     *
+     * Fields which compare equal with operator== have equal hashes.
+     * eg. 0.0 and -0.0 hash alike.  The field name is not included.
+     * A fast non-cryptographic hash, which may differ between releases.
+     *
+     * The hashes of large array buffers, which are shared, eg. with a monitor queue,
+     * are cached so that hashing the same buffer again is free.
+     * The cache holds a reference to each of these buffers, up to 64MB in total.
+     * A buffer no longer referenced elsewhere is released when another is cached.
+     *
+     * @since 8.0.8
+     */
+    size_t hashValue() const;
+
+    static ::epics::RefCounter num_instances; // use num_instances.get()
     enum {isPVField=1};
 protected:
     PVField::shared_pointer getPtrSelf()
@@ -246,11 +327,12 @@ protected:
         return shared_from_this();
     }
     explicit PVField(FieldConstPtr field);
-    void setParentAndName(PVStructure *parent, std::string const & fieldName);
+    void setParentAndName(PVStructure *parent, InternedString const & fieldName);
 private:
     static void computeOffset(const PVField *pvField);
     static void computeOffset(const PVField *pvField,std::size_t offset);
-    std::string fieldName;
+    // Shared with the Structure of our parent
+    InternedString fieldName;
     PVStructure *parent;
     const FieldConstPtr field;
     size_t fieldOffset;
@@ -630,6 +712,18 @@ public:
      */
     const ScalarArrayConstPtr getScalarArray() const ;
 
+    /** Replace the value with an equal one from the pool.  See ArrayDedup::dedup()
+     *
+     * The value is not changed, so postPut() is not called,
+     * and immutable arrays may be de-duplicated.
+     * Arrays which are not immutable, eg. waveforms, are skipped unless includeMutable is true,
+     * as the pool would otherwise hold on to each value put.
+     *
+     * @return true if the value now refers to a different buffer.
+     * @since 8.0.8
+     */
+    bool deduplicate(ArrayDedup& pool = ArrayDedup::global(), bool includeMutable = false);
+
 protected:
     virtual void _getAsVoid(shared_vector<const void>&) const = 0;
     virtual void _putFromVoid(const shared_vector<const void>&) = 0;
@@ -869,8 +963,57 @@ public:
     void copy(const PVStructure& from);
 
     void copyUnchecked(const PVStructure& from);
+    /** Copy only those fields of 'from' selected by maskBitSet.
+     *
+     * Bits are field offsets in the tree of 'from'.  A set bit for a sub-structure
+     * selects all of its fields.  With inverse=true, clear bits select fields.
+     *
+     * Sub-fields without a selected bit are skipped without being visited,
+     * so bringing a snapshot up to date with the fields changed since it was taken
+     * costs in proportion to the number of changes, not to the size of the structure.
+     * Array values are shared, not copied.
+     *
+     @code
+       // on each update
+       snapshot->copyUnchecked(*record, changed);
+     @endcode
+     */
     void copyUnchecked(const PVStructure& from, const BitSet& maskBitSet, bool inverse = false);
 
+    /** Pass each scalar array field through pool.  See PVScalarArray::deduplicate()
+     *
+     * Includes sub-structures, the values of unions, and the elements of
+     * structure and union arrays.  See ArrayDedup::stats() for totals.
+     * Arrays which are not immutable are skipped unless includeMutable is true.
+     *
+     @code
+       for(...) records[i]->deduplicate();
+       ArrayDedup::Stats stats(ArrayDedup::global().stats());
+     @endcode
+     *
+     * @return The number of arrays which now refer to a different buffer.
+     * @since 8.0.8
+     */
+    size_t deduplicate(ArrayDedup& pool = ArrayDedup::global(), bool includeMutable = false);
+
+    using PVField::hashValue;
+    /** Hash of the values of those fields selected by mask.
+     *
+     * Bits are field offsets, as for copyUnchecked() with a mask.
+     * A set bit for a sub-structure selects all of its fields.
+     * Equal values of the same selection have equal hashes.
+     *
+     @code
+       // key a cache by value and alarm, ignoring timeStamp
+       BitSet mask;
+       mask.set(pv->getSubFieldT("value")->getFieldOffset())
+           .set(pv->getSubFieldT("alarm")->getFieldOffset());
+       size_t key = pv->hashValue(mask);
+     @endcode
+     * @since 8.0.8
+     */
+    size_t hashValue(const BitSet& mask) const;
+
     struct Formatter {
         enum mode_t {
             Auto,
@@ -912,6 +1055,47 @@ public:
 
     FORCE_INLINE Formatter stream() const { return Formatter(*this); }
 
+    /** @brief Batch the postPut() notifications of a structure and its sub-fields.
+     *
+     * While a Transaction exists, PVField::postPut() of the structure or any sub-field
+     * only records the field offset.  When the Transaction is destroyed,
+     * PostHandler::postTransaction() of the structure is called once, with all of the
+     * posted offsets.  By default this calls the PostHandler of each posted sub-field.
+     * If the structure has no PostHandler, then those of the posted sub-fields are called.
+     *
+     * Puts are not undone, so notifications are delivered even when the scope
+     * is left by an exception, for those fields which were put() before it was thrown.
+     *
+     * A Transaction on a structure, or a sub-structure, which already has
+     * an active Transaction joins it, and delivers nothing itself.
+     * As with other methods of PVStructure, not thread safe.
+     *
+     @code
+       {
+           PVStructure::Transaction T(*pv);
+           value->put(1.0);
+           secondsPastEpoch->put(now);
+           nanoseconds->put(nanos);
+       } // one notification
+     @endcode
+     * @since 8.0.8
+     */
+    class epicsShareClass Transaction {
+        EPICS_NOT_COPYABLE(Transaction)
+    public:
+        explicit Transaction(PVStructure& top);
+        //! Delivers notifications if this is the outermost Transaction.
+        ~Transaction();
+        //! Offsets of the fields posted so far.
+        inline const BitSet& changed() const { return active->posted; }
+    private:
+        PVStructure *owner; // which holds the outermost Transaction
+        Transaction *active; // outermost, or this
+        BitSet posted; // only used by the outermost
+        unsigned depth; // count of Transactions joined to the outermost
+        friend class PVField;
+    };
+
 private:
 
     inline PVFieldPtr getSubFieldImpl(const std::string& name, bool throws) const {
@@ -919,11 +1103,14 @@ private:
     }
     PVFieldPtr getSubFieldImpl(const char *name, bool throws) const;
     PVFieldPtr getSubFieldImpl(std::size_t fieldOffset, bool throws) const;
+    void postTransaction(const BitSet& posted);
 
     PVFieldPtrArray pvFields;
     StructureConstPtr structurePtr;
     std::string extendsStructureName;
+    Transaction *transaction; // outermost active, or NULL
     friend class PVDataCreate;
+    friend class PVField;
     EPICS_NOT_COPYABLE(PVStructure)
 };
 
@@ -1223,6 +1410,7 @@ protected:
     explicit PVValueArray(ScalarArrayConstPtr const & scalar);
     const_svector value;
     friend class PVDataCreate;
+    friend class PVScalarArray;
     EPICS_NOT_COPYABLE(PVValueArray)
 };
 
@@ -1654,6 +1842,44 @@ bool epicsShareExtern operator==(const PVField&, const PVField&);
 static inline bool operator!=(const PVField& a, const PVField& b)
 {return !(a==b);}
 
+/** Find the fields of two PVStructures of the same type which differ in value.
+ *
+ * Sets the bit in 'changed' for each field of 'b' which differs from the same field of 'a'.
+ * Bits for sub-structures are not set, only those for the fields they contain,
+ * so the bits are those needed by a delta, eg. serialize() with a BitSet.
+ * Bits already set in 'changed' are not cleared.  See also BitSetUtil::compress().
+ *
+ * Scalars and arrays of numbers are compared bitwise, so a NaN is unchanged if its bits are,
+ * and 0.0 and -0.0 differ.  Arrays which share a buffer are equal without comparing elements.
+ * Unions and arrays of structures or unions are compared with operator==.
+ *
+ * Numeric scalars and arrays with an entry in deadbands, keyed by field offset in 'b',
+ * are unchanged unless some value differs by more than the deadband.
+ * 'a' should then be the last value sent, not the previous value, so that slow drift is eventually seen.
+ *
+ @code
+   std::map<uint32, double> deadbands;
+   deadbands[record->getSubFieldT("value")->getFieldOffset()] = 0.1;
+   ...
+   BitSet changed;
+   if(diff(*last, *record, changed, &deadbands)) {
+       last->copyUnchecked(*record, changed);
+       ...
+   }
+ @endcode
+ *
+ * @param a The old value
+ * @param b The new value
+ * @param changed Bits set for fields which differ, as offsets in 'b'
+ * @param deadbands Optional deadbands for numeric fields, keyed by field offset in 'b'
+ * @returns true if any field differs
+ * @throws std::invalid_argument if the structure definitions do not match.
+ *
+ * @since 8.0.8
+ */
+epicsShareExtern bool diff(const PVStructure& a, const PVStructure& b, BitSet& changed,
+                           const std::map<uint32, double>* deadbands = 0);
+
 }}
 
 /**
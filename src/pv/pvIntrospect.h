@@ -17,6 +17,8 @@
 #include <epicsAssert.h>
 
 #include <pv/lock.h>
+#include <pv/reftrack.h>
+#include <pv/internedString.h>
 #include <pv/noDefaultMethods.h>
 #include <pv/pvType.h>
 #include <pv/byteBuffer.h>
@@ -320,6 +322,9 @@ namespace ScalarTypeFunc {
 
 epicsShareExtern std::ostream& operator<<(std::ostream& o, const ScalarType& scalarType);
 
+namespace detail {
+struct field_compare;
+}
 
 /**
  * @brief This class implements introspection object for field.
@@ -329,7 +334,7 @@ class epicsShareClass Field :
     virtual public Serializable,
     public std::tr1::enable_shared_from_this<Field> {
 public:
-   static size_t num_instances;
+   static ::epics::RefCounter num_instances;
 
    POINTER_DEFINITIONS(Field);
    virtual ~Field();
@@ -369,6 +374,7 @@ private:
    unsigned int m_hash;
    struct Helper;
    friend struct Helper;
+   friend struct detail::field_compare;
 
    friend class StructureArray;
    friend class Structure;
@@ -808,6 +814,13 @@ public:
      * This will be -1 if the field is not in the structure.
      */
     std::size_t getFieldIndex(std::string const &fieldName) const;
+    /**
+     * Get the field index for the specified interned fieldName.
+     * Compares pointers instead of contents.
+     * @return The index, or -1 if the field is not in the structure.
+     * @since 8.0.8
+     */
+    std::size_t getFieldIndex(InternedString const &fieldName) const;
     /**
      * Get the fields in the structure.
      * @return The array of fields.
@@ -818,6 +831,15 @@ public:
      * @return The array of fieldNames.
      */
     StringArray const & getFieldNames() const {return fieldNames;}
+    /**
+     * Get the interned names of the fields in the structure.
+     * Same order as getFieldNames()
+     * @since 8.0.8
+     */
+    std::vector<InternedString> const & getInternedFieldNames() const {return internedNames;}
+    //! Interned getID()
+    //! @since 8.0.8
+    InternedString const & getInternedID() const {return id;}
     /**
      * Get the name of the field with the specified index;
      * @param fieldIndex The index of the desired field.
@@ -840,8 +862,9 @@ protected:
     Structure(StringArray const & fieldNames, FieldConstPtrArray const & fields, std::string const & id = defaultId());
 private:
     StringArray fieldNames;
+    std::vector<InternedString> internedNames;
     FieldConstPtrArray fields;
-    std::string id;
+    InternedString id;
 
     FieldConstPtr getFieldImpl(const std::string& fieldName, bool throws) const;
     void dumpFields(std::ostream& o) const;
@@ -988,6 +1011,13 @@ public:
      * This will be -1 if the field is not in the union.
      */
     std::size_t getFieldIndex(std::string const &fieldName) const;
+    /**
+     * Get the field index for the specified interned fieldName.
+     * Compares pointers instead of contents.
+     * @return The index, or -1 if the field is not in the union.
+     * @since 8.0.8
+     */
+    std::size_t getFieldIndex(InternedString const &fieldName) const;
     /**
      * Get the fields in the union.
      * @return The array of fields.
@@ -998,6 +1028,15 @@ public:
      * @return The array of fieldNames.
      */
     StringArray const & getFieldNames() const {return fieldNames;}
+    /**
+     * Get the interned names of the fields in the union.
+     * Same order as getFieldNames()
+     * @since 8.0.8
+     */
+    std::vector<InternedString> const & getInternedFieldNames() const {return internedNames;}
+    //! Interned getID()
+    //! @since 8.0.8
+    InternedString const & getInternedID() const {return id;}
     /**
      * Get the name of the field with the specified index;
      * @param fieldIndex The index of the desired field.
@@ -1037,8 +1076,9 @@ protected:
    Union(StringArray const & fieldNames, FieldConstPtrArray const & fields, std::string const & id = defaultId());
 private:
    StringArray fieldNames;
+   std::vector<InternedString> internedNames;
    FieldConstPtrArray fields;
-   std::string id;
+   InternedString id;
 
    FieldConstPtr getFieldImpl(const std::string& fieldName, bool throws) const;
    void dumpFields(std::ostream& o) const;
@@ -1382,7 +1422,26 @@ public:
      * @return a deserialized @c Field instance.
      */
     FieldConstPtr deserialize(ByteBuffer* buffer, DeserializableControl* control) const;
-        
+
+    /** @brief Summary of the cache of unique Field instances.
+     *
+     * Each create*() call which returns an existing instance is a hit.
+     * Each which adds a new instance is a miss.
+     * bytes is an estimate, including the cache entries.
+     *
+     * @since 8.0.8
+     */
+    struct CacheStats {
+        size_t entries; //!< Number of Field instances currently cached
+        size_t bytes;   //!< Estimated memory used by cached Field instances
+        size_t hits;    //!< Cumulative
+        size_t misses;  //!< Cumulative
+        CacheStats() :entries(0u), bytes(0u), hits(0u), misses(0u) {}
+    };
+    //! Current cache statistics
+    //! @since 8.0.8
+    CacheStats cacheStats() const;
+
 private:
     FieldCreate();
 
@@ -1392,9 +1451,11 @@ private:
     UnionConstPtr variantUnion;
     UnionArrayConstPtr variantUnionArray;
 
-    mutable Mutex mutex;
+    mutable TrackedMutex mutex;
     typedef std::multimap<unsigned int, Field*> cache_t;
     mutable cache_t cache;
+    // guarded by mutex
+    mutable size_t cacheHits, cacheMisses;
 
     struct Helper;
     friend class Field;
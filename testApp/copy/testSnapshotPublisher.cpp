@@ -0,0 +1,207 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <vector>
+
+#include <epicsThread.h>
+#include <epicsAtomic.h>
+
+#include <pv/pvUnitTest.h>
+#include <testMain.h>
+
+#include <pv/snapshotPublisher.h>
+#include <pv/standardField.h>
+#include <pv/thread.h>
+#include <pv/epicsException.h>
+
+namespace pvd = epics::pvData;
+
+namespace {
+
+pvd::StructureConstPtr recordType()
+{
+    return pvd::getStandardField()->scalar(pvd::pvInt, "alarm,timeStamp");
+}
+
+void testSequence()
+{
+    testDiag("testSequence()");
+    pvd::StructureConstPtr type(recordType());
+    pvd::PVStructurePtr record(type->build()), mine(type->build());
+    pvd::PVIntPtr value(record->getSubFieldT<pvd::PVInt>("value"));
+    pvd::PVStringPtr message(record->getSubFieldT<pvd::PVString>("alarm.message"));
+
+    pvd::SnapshotPublisher pub(type);
+    size_t seq = pvd::SnapshotPublisher::initial;
+    pvd::BitSet changed;
+
+    testOk1(pub.read(*mine, seq, &changed));
+    testEqual(seq, 0u);
+    testEqual(changed, pvd::BitSet().set(0));
+    testOk1(!pub.read(*mine, seq, &changed));
+
+    value->put(1);
+    message->put("first");
+    pub.publish(*record);
+
+    value->put(2);
+    pub.publish(*record, pvd::BitSet().set(value->getFieldOffset()));
+
+    // missed one update, so all fields are copied
+    testOk1(pub.read(*mine, seq, &changed));
+    testEqual(seq, 2u);
+    testEqual(changed, pvd::BitSet().set(0));
+    testEqual(*mine, *record);
+
+    // hold a snapshot while more are published
+    pvd::SnapshotPublisher::Snapshot::const_shared_pointer held(pub.current());
+
+    for(int i=3; i<10; i++) {
+        value->put(i);
+        pub.publish(*record, pvd::BitSet().set(value->getFieldOffset()));
+
+        testOk1(pub.read(*mine, seq, &changed));
+        testEqual(changed, pvd::BitSet().set(value->getFieldOffset()));
+    }
+    testEqual(seq, 9u);
+    testEqual(*mine, *record);
+
+    // the held snapshot was not re-used
+    testEqual(held->sequence, 2u);
+    testEqual(held->value->getSubFieldT<pvd::PVInt>("value")->get(), 2);
+    testEqual(held->value->getSubFieldT<pvd::PVString>("alarm.message")->get(), "first");
+
+    // re-used snapshots have all changes
+    message->put("second");
+    pub.publish(*record, pvd::BitSet().set(message->getFieldOffset()));
+    value->put(10);
+    pub.publish(*record, pvd::BitSet().set(value->getFieldOffset()));
+    testEqual(*pub.current()->value, *record);
+
+    // hold only the value of a snapshot while more are published
+    pvd::PVStructure::const_shared_pointer heldValue(pub.current()->value);
+    for(int i=11; i<13; i++) {
+        value->put(i);
+        pub.publish(*record, pvd::BitSet().set(value->getFieldOffset()));
+    }
+    testEqual(heldValue->getSubFieldT<pvd::PVInt>("value")->get(), 10);
+    testEqual(pub.current()->value->getSubFieldT<pvd::PVInt>("value")->get(), 12);
+
+    pvd::PVStructurePtr other(pvd::getStandardField()->scalar(pvd::pvDouble, "alarm")->build());
+    testThrows(std::invalid_argument, pub.publish(*other));
+    testThrows(std::invalid_argument, pub.read(*other, seq));
+}
+
+void testElements()
+{
+    testDiag("testElements()");
+    pvd::StructureConstPtr type(pvd::getFieldCreate()->createFieldBuilder()
+                                ->addNestedStructureArray("arr")
+                                    ->add("x", pvd::pvInt)
+                                ->endNested()
+                                ->createStructure());
+    pvd::PVStructurePtr record(type->build()), mine(type->build());
+    pvd::PVStructureArrayPtr arr(record->getSubFieldT<pvd::PVStructureArray>("arr"));
+    {
+        pvd::PVStructureArray::svector elems(1);
+        elems[0] = arr->getStructureArray()->getStructure()->build();
+        elems[0]->getSubFieldT<pvd::PVInt>("x")->put(1);
+        arr->replace(pvd::freeze(elems));
+    }
+
+    pvd::SnapshotPublisher pub(type);
+    size_t seq = pvd::SnapshotPublisher::initial;
+    pub.publish(*record);
+    pub.read(*mine, seq);
+
+    // modify the element in place
+    arr->view()[0]->getSubFieldT<pvd::PVInt>("x")->put(2);
+
+    pvd::SnapshotPublisher::Snapshot::const_shared_pointer snap(pub.current());
+    testEqual(snap->value->getSubFieldT<pvd::PVStructureArray>("arr")->view()[0]->getSubFieldT<pvd::PVInt>("x")->get(), 1);
+    testEqual(mine->getSubFieldT<pvd::PVStructureArray>("arr")->view()[0]->getSubFieldT<pvd::PVInt>("x")->get(), 1);
+
+    pub.publish(*record, pvd::BitSet().set(arr->getFieldOffset()));
+    testOk1(pub.read(*mine, seq));
+    testEqual(mine->getSubFieldT<pvd::PVStructureArray>("arr")->view()[0]->getSubFieldT<pvd::PVInt>("x")->get(), 2);
+    testOk1(mine->getSubFieldT<pvd::PVStructureArray>("arr")->view()[0]!=arr->view()[0]);
+}
+
+struct Racer {
+    pvd::SnapshotPublisher pub;
+    size_t nupdates;
+    int done;
+    size_t inconsistent;
+    explicit Racer(const pvd::StructureConstPtr& type) :pub(type), nupdates(20000u), done(0), inconsistent(0u) {}
+};
+
+// value and timeStamp.userTag are always updated together
+void readMany(void *raw)
+{
+    Racer *racer = static_cast<Racer*>(raw);
+    pvd::PVStructurePtr mine(racer->pub.current()->value->getStructure()->build());
+    pvd::PVIntPtr value(mine->getSubFieldT<pvd::PVInt>("value"));
+    pvd::PVIntPtr tag(mine->getSubFieldT<pvd::PVInt>("timeStamp.userTag"));
+    size_t seq = pvd::SnapshotPublisher::initial;
+
+    while(!epics::atomic::get(racer->done)) {
+        racer->pub.read(*mine, seq);
+        if(value->get()!=tag->get())
+            epics::atomic::increment(racer->inconsistent);
+
+        pvd::SnapshotPublisher::Snapshot::const_shared_pointer snap(racer->pub.current());
+        if(snap->value->getSubFieldT<pvd::PVInt>("value")->get()!=snap->value->getSubFieldT<pvd::PVInt>("timeStamp.userTag")->get())
+            epics::atomic::increment(racer->inconsistent);
+    }
+}
+
+void testRace()
+{
+    testDiag("testRace()");
+    pvd::StructureConstPtr type(recordType());
+    pvd::PVStructurePtr record(type->build());
+    pvd::PVIntPtr value(record->getSubFieldT<pvd::PVInt>("value"));
+    pvd::PVIntPtr tag(record->getSubFieldT<pvd::PVInt>("timeStamp.userTag"));
+    pvd::BitSet changed;
+    changed.set(value->getFieldOffset()).set(tag->getFieldOffset());
+
+    Racer racer(type);
+
+    std::vector<pvd::ThreadPtr> threads;
+    for(unsigned i=0; i<4; i++) {
+        pvd::Thread::Config conf(&readMany, &racer);
+        conf.prio(epicsThreadPriorityMedium)
+            .autostart(true);
+        threads.push_back(pvd::ThreadPtr(new pvd::Thread(conf<<"reader"<<i)));
+    }
+
+    for(size_t i=0; i<racer.nupdates; i++) {
+        value->put(pvd::int32(i));
+        tag->put(pvd::int32(i));
+        racer.pub.publish(*record, changed);
+    }
+    epics::atomic::set(racer.done, 1);
+
+    for(unsigned i=0; i<threads.size(); i++)
+        threads[i]->exitWait();
+
+    testEqual(racer.inconsistent, 0u);
+    testEqual(racer.pub.current()->sequence, racer.nupdates);
+}
+
+} // namespace
+
+MAIN(testSnapshotPublisher)
+{
+    testPlan(39);
+    try {
+        testSequence();
+        testElements();
+        testRace();
+    }catch(std::exception& e){
+        PRINT_EXCEPTION(e);
+        testAbort("Unexpected exception: %s", e.what());
+    }
+    return testDone();
+}
@@ -0,0 +1,200 @@
+// Conversion of large arrays between string and numeric types,
+// compared with std::ostream and epicsParse*()
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <math.h>
+
+#include <sstream>
+
+#include <testMain.h>
+#include <epicsUnitTest.h>
+#include <epicsStdlib.h>
+#include <epicsStdio.h>
+
+#include <pv/current_function.h>
+#include <pv/pvData.h>
+#include <pv/convert.h>
+
+namespace {
+
+namespace pvd = epics::pvData;
+
+struct TimeIt {
+    struct timespec m_start;
+    double sum, sum2;
+    size_t count;
+    TimeIt() { reset(); }
+    void reset() {
+        sum = sum2 = 0.0;
+        count = 0;
+    }
+    void start() {
+        clock_gettime(CLOCK_MONOTONIC, &m_start);
+    }
+    void end() {
+        struct timespec end;
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double diff = (end.tv_sec-m_start.tv_sec) + (end.tv_nsec-m_start.tv_nsec)*1e-9;
+        sum += diff;
+        sum2 += diff*diff;
+        count++;
+    }
+    void report(const char *unit ="s", double mult=1.0) const {
+        double mean = sum/count;
+        double mean2 = sum2/count;
+        double std = sqrt(mean2 - mean*mean);
+        printf("# %zu sample   %f +- %f %s\n", count, mean/mult, std/mult, unit);
+    }
+};
+
+const size_t nsamples = 10;
+const size_t nelem = 100000;
+
+void toString()
+{
+    testDiag("%s %zu elements", CURRENT_FUNCTION, nelem);
+
+    pvd::shared_vector<double> dvals(nelem);
+    pvd::shared_vector<pvd::int32> ivals(nelem);
+    for(size_t i=0; i<nelem; i++) {
+        dvals[i] = sin(i*0.001)*1e3;
+        ivals[i] = pvd::int32(i*7919u) - 1000000;
+    }
+    pvd::shared_vector<std::string> out(nelem);
+
+    TimeIt dostream, dcast, iostream, icast;
+
+    for(size_t n=0; n<nsamples; n++) {
+        dostream.start();
+        for(size_t i=0; i<nelem; i++) {
+            std::ostringstream strm;
+            strm<<dvals[i];
+            out[i] = strm.str();
+        }
+        dostream.end();
+
+        dcast.start();
+        pvd::castUnsafeV(nelem, pvd::pvString, out.data(), pvd::pvDouble, dvals.data());
+        dcast.end();
+
+        iostream.start();
+        for(size_t i=0; i<nelem; i++) {
+            std::ostringstream strm;
+            strm<<ivals[i];
+            out[i] = strm.str();
+        }
+        iostream.end();
+
+        icast.start();
+        pvd::castUnsafeV(nelem, pvd::pvString, out.data(), pvd::pvInt, ivals.data());
+        icast.end();
+    }
+
+    testDiag("double std::ostream");
+    dostream.report("ms", 1e-3);
+    testDiag("double castUnsafeV");
+    dcast.report("ms", 1e-3);
+    testDiag("int32 std::ostream");
+    iostream.report("ms", 1e-3);
+    testDiag("int32 castUnsafeV");
+    icast.report("ms", 1e-3);
+}
+
+void fromString()
+{
+    testDiag("%s %zu elements", CURRENT_FUNCTION, nelem);
+
+    pvd::shared_vector<std::string> dstrs(nelem), istrs(nelem);
+    for(size_t i=0; i<nelem; i++) {
+        char buf[32];
+        epicsSnprintf(buf, sizeof(buf), "%.6g", sin(i*0.001)*1e3);
+        dstrs[i] = buf;
+        epicsSnprintf(buf, sizeof(buf), "%d", int(i*7919u) - 1000000);
+        istrs[i] = buf;
+    }
+    pvd::shared_vector<double> dout(nelem);
+    pvd::shared_vector<pvd::int32> iout(nelem);
+
+    TimeIt dparse, dcast, iparse, icast;
+
+    for(size_t n=0; n<nsamples; n++) {
+        dparse.start();
+        for(size_t i=0; i<nelem; i++) {
+            if(epicsParseDouble(dstrs[i].c_str(), &dout[i], NULL))
+                testAbort("parse error");
+        }
+        dparse.end();
+
+        dcast.start();
+        pvd::castUnsafeV(nelem, pvd::pvDouble, dout.data(), pvd::pvString, dstrs.data());
+        dcast.end();
+
+        iparse.start();
+        for(size_t i=0; i<nelem; i++) {
+            epicsInt32 temp;
+            if(epicsParseInt32(istrs[i].c_str(), &temp, 0, NULL))
+                testAbort("parse error");
+            iout[i] = temp;
+        }
+        iparse.end();
+
+        icast.start();
+        pvd::castUnsafeV(nelem, pvd::pvInt, iout.data(), pvd::pvString, istrs.data());
+        icast.end();
+    }
+
+    testDiag("double epicsParseDouble()");
+    dparse.report("ms", 1e-3);
+    testDiag("double castUnsafeV");
+    dcast.report("ms", 1e-3);
+    testDiag("int32 epicsParseInt32()");
+    iparse.report("ms", 1e-3);
+    testDiag("int32 castUnsafeV");
+    icast.report("ms", 1e-3);
+}
+
+// the path taken by CSV loaders
+void convertArray()
+{
+    testDiag("%s %zu elements", CURRENT_FUNCTION, nelem);
+
+    pvd::PVDoubleArrayPtr darr(pvd::getPVDataCreate()->createPVScalarArray<pvd::PVDoubleArray>());
+    pvd::StringArray strs(nelem);
+    for(size_t i=0; i<nelem; i++) {
+        char buf[32];
+        epicsSnprintf(buf, sizeof(buf), "%.6g", i*0.25);
+        strs[i] = buf;
+    }
+
+    TimeIt from, to;
+
+    for(size_t n=0; n<nsamples; n++) {
+        from.start();
+        pvd::getConvert()->fromStringArray(darr, 0, nelem, strs, 0);
+        from.end();
+
+        pvd::StringArray out;
+        to.start();
+        pvd::getConvert()->toStringArray(darr, 0, nelem, out, 0);
+        to.end();
+
+        if(out!=strs)
+            testAbort("Round trip mismatch");
+    }
+
+    testDiag("Convert::fromStringArray()");
+    from.report("ms", 1e-3);
+    testDiag("Convert::toStringArray()");
+    to.report("ms", 1e-3);
+}
+
+} // namespace
+
+MAIN(performcast) {
+    testPlan(0);
+    toString();
+    fromString();
+    convertArray();
+    return testDone();
+}
@@ -0,0 +1,348 @@
+// Compare parsing of large, array heavy, JSON documents from a std::istream vs. from memory.
+// Also generic vs. compiled parsing of many small messages, and NDJSON export/import.
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <math.h>
+
+#include <sstream>
+#include <fstream>
+
+#include <testMain.h>
+#include <epicsUnitTest.h>
+
+#include <pv/current_function.h>
+#include <pv/pvData.h>
+#include <pv/json.h>
+#include <pv/bitSet.h>
+
+namespace {
+
+namespace pvd = epics::pvData;
+
+struct TimeIt {
+    struct timespec m_start;
+    double sum, sum2;
+    size_t count;
+    TimeIt() { reset(); }
+    void reset() {
+        sum = sum2 = 0.0;
+        count = 0;
+    }
+    void start() {
+        clock_gettime(CLOCK_MONOTONIC, &m_start);
+    }
+    void end() {
+        struct timespec end;
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double diff = (end.tv_sec-m_start.tv_sec) + (end.tv_nsec-m_start.tv_nsec)*1e-9;
+        sum += diff;
+        sum2 += diff*diff;
+        count++;
+    }
+    void report(const char *unit ="s", double mult=1.0) const {
+        double mean = sum/count;
+        double mean2 = sum2/count;
+        double std = sqrt(mean2 - mean*mean);
+        printf("# %zu sample   %f +- %f %s\n", count, mean/mult, std/mult, unit);
+    }
+    void reportRate(size_t nbytes) const {
+        double mean = sum/count;
+        printf("#   %.1f MB/s\n", nbytes/mean/1e6);
+    }
+};
+
+const size_t nsamples = 10;
+
+// Several MB of mostly numeric arrays.
+// With 'multiLine', one array element per line.  Otherwise a single (very long) line.
+std::string makeDoc(size_t nelem, bool multiLine)
+{
+    const char *sep = multiLine ? ",\n" : ",";
+    std::ostringstream strm;
+    strm.precision(17);
+    strm<<"{\"value\":[";
+    for(size_t i=0; i<nelem; i++) {
+        if(i) strm<<sep;
+        strm<<(i*0.25+0.125);
+    }
+    strm<<"],\n \"index\":[";
+    for(size_t i=0; i<nelem; i++) {
+        if(i) strm<<sep;
+        strm<<(i*7u);
+    }
+    strm<<"],\n \"names\":[";
+    for(size_t i=0; i<nelem/16u; i++) {
+        if(i) strm<<sep;
+        strm<<"\"element"<<i<<"\"";
+    }
+    strm<<"]}\n";
+    return strm.str();
+}
+
+struct handler {
+    yajl_handle handle;
+    handler(yajl_handle handle) :handle(handle)
+    {
+        if(!handle)
+            testAbort("Failed to allocate yajl handle");
+    }
+    ~handler() {
+        yajl_free(handle);
+    }
+    operator yajl_handle() { return handle; }
+};
+
+const yajl_callbacks nocbs = {0};
+
+yajl_handle allocNoop()
+{
+#ifndef EPICS_YAJL_VERSION
+    yajl_parser_config conf = {1, 1};
+    return yajl_alloc(&nocbs, &conf, NULL, NULL);
+#else
+    yajl_handle handle = yajl_alloc(&nocbs, NULL, NULL);
+    yajl_config(handle, yajl_allow_comments, 1);
+    return handle;
+#endif
+}
+
+// only the cost of tokenizing, and of getting text to the tokenizer
+void lexOnly(const std::string& doc)
+{
+    testDiag("%s %zu bytes", CURRENT_FUNCTION, doc.size());
+
+    TimeIt stream, buffer;
+
+    for(size_t i=0; i<nsamples; i++) {
+        {
+            std::istringstream strm(doc);
+            handler handle(allocNoop());
+            stream.start();
+            pvd::yajl_parse_helper(strm, handle);
+            stream.end();
+        }
+        {
+            handler handle(allocNoop());
+            buffer.start();
+            pvd::yajl_parse_helper(doc.c_str(), doc.size(), handle);
+            buffer.end();
+        }
+    }
+
+    testDiag("std::istream");
+    stream.report("ms", 1e-3);
+    stream.reportRate(doc.size());
+    testDiag("buffer");
+    buffer.report("ms", 1e-3);
+    buffer.reportRate(doc.size());
+}
+
+// includes building the PVStructure
+void parseAny(const std::string& doc)
+{
+    testDiag("%s %zu bytes", CURRENT_FUNCTION, doc.size());
+
+    TimeIt stream, buffer, file;
+
+    const char fname[] = "performjson.tmp";
+    {
+        std::ofstream out(fname);
+        out<<doc;
+    }
+
+    for(size_t i=0; i<nsamples; i++) {
+        {
+            std::istringstream strm(doc);
+            stream.start();
+            pvd::PVStructurePtr val(pvd::parseJSON(strm));
+            stream.end();
+        }
+        {
+            buffer.start();
+            pvd::PVStructurePtr val(pvd::parseJSON(doc.c_str(), doc.size()));
+            buffer.end();
+        }
+        {
+            file.start();
+            pvd::JSONMappedFile mapped(fname);
+            pvd::PVStructurePtr val(pvd::parseJSON(mapped));
+            file.end();
+        }
+    }
+
+    remove(fname);
+
+    testDiag("std::istream");
+    stream.report("ms", 1e-3);
+    stream.reportRate(doc.size());
+    testDiag("buffer");
+    buffer.report("ms", 1e-3);
+    buffer.reportRate(doc.size());
+    testDiag("JSONMappedFile");
+    file.report("ms", 1e-3);
+    file.reportRate(doc.size());
+}
+
+// 20 scalars and one array
+pvd::StructureConstPtr makeUpdateType()
+{
+    pvd::FieldBuilderPtr builder(pvd::getFieldCreate()->createFieldBuilder());
+    for(size_t i=0; i<20u; i++) {
+        std::ostringstream name;
+        name<<"field"<<i;
+        builder->add(name.str(), i%2u ? pvd::pvDouble : pvd::pvInt);
+    }
+    builder->addArray("value", pvd::pvDouble);
+    return builder->createStructure();
+}
+
+std::string makeUpdate()
+{
+    std::ostringstream strm;
+    strm<<"{";
+    for(size_t i=0; i<20u; i++) {
+        strm<<"\"field"<<i<<"\":"<<i<<(i%2u ? ".5" : "")<<", ";
+    }
+    strm<<"\"value\":[";
+    for(size_t i=0; i<256u; i++) {
+        if(i) strm<<",";
+        strm<<(i*0.25+0.125);
+    }
+    strm<<"]}";
+    return strm.str();
+}
+
+// Many small messages parsed into the same, known, structure
+void parseCompiled()
+{
+    testDiag("%s", CURRENT_FUNCTION);
+
+    const pvd::StructureConstPtr type(makeUpdateType());
+    const std::string msg(makeUpdate());
+    const size_t nmsg = 1000u;
+
+    pvd::PVStructurePtr generic(pvd::getPVDataCreate()->createPVStructure(type)),
+                        compiled(pvd::getPVDataCreate()->createPVStructure(type));
+    pvd::JSONStructureParser parser(type);
+    pvd::BitSet changed;
+
+    TimeIt tgeneric, tcompiled;
+
+    for(size_t i=0; i<nsamples; i++) {
+        tgeneric.start();
+        for(size_t n=0; n<nmsg; n++) {
+            // parseJSON() appends to arrays
+            generic->getSubFieldT<pvd::PVDoubleArray>("value")->setLength(0);
+            pvd::parseJSON(msg.c_str(), msg.size(), *generic, &changed);
+        }
+        tgeneric.end();
+
+        tcompiled.start();
+        for(size_t n=0; n<nmsg; n++) {
+            parser.parse(msg.c_str(), msg.size(), *compiled, &changed);
+        }
+        tcompiled.end();
+    }
+
+    if(*generic!=*compiled)
+        testAbort("Results differ");
+
+    testDiag("%zu messages of %zu bytes", nmsg, msg.size());
+    testDiag("parseJSON()");
+    tgeneric.report("ms", 1e-3);
+    tgeneric.reportRate(nmsg*msg.size());
+    testDiag("JSONStructureParser");
+    tcompiled.report("ms", 1e-3);
+    tcompiled.reportRate(nmsg*msg.size());
+}
+
+// Export and re-import a file of monitor updates.
+// Every 10th line is complete, others have only a few changed scalars.
+void ndjsonFile()
+{
+    testDiag("%s", CURRENT_FUNCTION);
+
+    const pvd::StructureConstPtr type(makeUpdateType());
+    pvd::PVStructurePtr val(pvd::getPVDataCreate()->createPVStructure(type));
+    {
+        const std::string msg(makeUpdate());
+        pvd::parseJSON(msg.c_str(), msg.size(), *val);
+    }
+    pvd::PVIntPtr counter(val->getSubFieldT<pvd::PVInt>("field0"));
+    pvd::PVDoublePtr reading(val->getSubFieldT<pvd::PVDouble>("field1"));
+
+    pvd::BitSet delta;
+    delta.set(counter->getFieldOffset())
+         .set(reading->getFieldOffset());
+
+    const char fname[] = "performjson.tmp";
+    const size_t nlines = 100000u;
+
+    TimeIt twrite, tread;
+    size_t nbytes = 0u;
+
+    for(size_t i=0; i<nsamples; i++) {
+        {
+            std::ofstream out(fname);
+            pvd::NDJSONWriter writer(out);
+
+            twrite.start();
+            for(size_t n=0; n<nlines; n++) {
+                counter->put(n);
+                reading->put(n*0.5);
+                if(n%10u==0u)
+                    writer.write(*val);
+                else
+                    writer.write(*val, delta);
+            }
+            out.flush();
+            twrite.end();
+            nbytes = out.tellp();
+        }
+        {
+            std::ifstream in(fname);
+            pvd::NDJSONReader reader(in, type);
+            pvd::PVStructurePtr dest(pvd::getPVDataCreate()->createPVStructure(type));
+            pvd::BitSet changed;
+
+            tread.start();
+            size_t n=0;
+            while(reader.next(*dest, &changed))
+                n++;
+            tread.end();
+
+            if(n!=nlines || *dest!=*val)
+                testAbort("Read back %zu of %zu lines", n, nlines);
+        }
+    }
+
+    remove(fname);
+
+    testDiag("%zu lines, %zu bytes", nlines, nbytes);
+    testDiag("NDJSONWriter");
+    twrite.report("ms", 1e-3);
+    twrite.reportRate(nbytes);
+    testDiag("NDJSONReader");
+    tread.report("ms", 1e-3);
+    tread.reportRate(nbytes);
+}
+
+} // namespace
+
+MAIN(performJSON) {
+    testPlan(0);
+    {
+        std::string doc(makeDoc(200000u, false));
+        lexOnly(doc);
+        parseAny(doc);
+    }
+    {
+        std::string doc(makeDoc(200000u, true));
+        lexOnly(doc);
+        parseAny(doc);
+    }
+    parseCompiled();
+    ndjsonFile();
+    return testDone();
+}
@@ -0,0 +1,210 @@
+// Cost of scheduling, cancelling, and re-scheduling many Timer callbacks,
+// and of expiring them.  Also callback latency with and without worker threads.
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <math.h>
+
+#include <vector>
+#include <algorithm>
+#include <sstream>
+
+#include <testMain.h>
+#include <epicsUnitTest.h>
+#include <epicsAtomic.h>
+#include <epicsThread.h>
+
+#include <pv/current_function.h>
+#include <pv/timer.h>
+#include <pv/event.h>
+
+namespace {
+
+namespace pvd = epics::pvData;
+
+struct TimeIt {
+    struct timespec m_start;
+    double sum, sum2;
+    size_t count;
+    TimeIt() { reset(); }
+    void reset() {
+        sum = sum2 = 0.0;
+        count = 0;
+    }
+    void start() {
+        clock_gettime(CLOCK_MONOTONIC, &m_start);
+    }
+    void end() {
+        struct timespec end;
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double diff = (end.tv_sec-m_start.tv_sec) + (end.tv_nsec-m_start.tv_nsec)*1e-9;
+        sum += diff;
+        sum2 += diff*diff;
+        count++;
+    }
+    void report(const char *unit ="s", double mult=1.0) const {
+        double mean = sum/count;
+        double mean2 = sum2/count;
+        double std = sqrt(mean2 - mean*mean);
+        printf("# %zu sample   %f +- %f %s\n", count, mean/mult, std/mult, unit);
+    }
+    void reportRate(size_t nops) const {
+        double mean = sum/count;
+        printf("#   %.1f ns/op\n", mean/nops*1e9);
+    }
+};
+
+const size_t nsamples = 5;
+const size_t ntimers = 100000;
+
+struct Noop : public pvd::TimerCallback {
+    size_t *remaining;
+    pvd::Event *done;
+    Noop() :remaining(0), done(0) {}
+    virtual ~Noop() {}
+    virtual void callback() {
+        if(remaining && epics::atomic::decrement(*remaining)==0)
+            done->signal();
+    }
+    virtual void timerStopped() {}
+};
+
+typedef std::vector<pvd::TimerCallbackPtr> callbacks_t;
+
+void makeCallbacks(callbacks_t& cbs)
+{
+    cbs.resize(ntimers);
+    for(size_t i=0; i<ntimers; i++)
+        cbs[i].reset(new Noop);
+}
+
+// Delays spread between 100 and 200 seconds, so nothing expires during the test.
+double farDelay()
+{
+    return 100.0 + (rand()%100000)*1e-3;
+}
+
+void scheduleCancel()
+{
+    testDiag("%s %zu timers", CURRENT_FUNCTION, ntimers);
+
+    pvd::Timer timer("performtimer", pvd::lowPriority);
+    callbacks_t cbs;
+    makeCallbacks(cbs);
+
+    TimeIt tschedule, treschedule, tcancel;
+
+    for(size_t n=0; n<nsamples; n++) {
+        tschedule.start();
+        for(size_t i=0; i<ntimers; i++)
+            timer.schedulePeriodic(cbs[i], farDelay(), 1.0);
+        tschedule.end();
+
+        std::random_shuffle(cbs.begin(), cbs.end());
+
+        // as when a scan period is changed
+        treschedule.start();
+        for(size_t i=0; i<ntimers; i++) {
+            timer.cancel(cbs[i]);
+            timer.schedulePeriodic(cbs[i], farDelay(), 1.0);
+        }
+        treschedule.end();
+
+        std::random_shuffle(cbs.begin(), cbs.end());
+
+        tcancel.start();
+        for(size_t i=0; i<ntimers; i++)
+            timer.cancel(cbs[i]);
+        tcancel.end();
+    }
+
+    testDiag("schedulePeriodic()");
+    tschedule.report("ms", 1e-3);
+    tschedule.reportRate(ntimers);
+    testDiag("cancel() and schedulePeriodic()");
+    treschedule.report("ms", 1e-3);
+    treschedule.reportRate(ntimers);
+    testDiag("cancel()");
+    tcancel.report("ms", 1e-3);
+    tcancel.reportRate(ntimers);
+}
+
+void expire()
+{
+    testDiag("%s %zu timers", CURRENT_FUNCTION, ntimers);
+
+    pvd::Timer timer("performtimer", pvd::lowPriority);
+    callbacks_t cbs;
+    makeCallbacks(cbs);
+    pvd::Event done;
+    size_t remaining;
+
+    for(size_t i=0; i<ntimers; i++) {
+        Noop *cb = static_cast<Noop*>(cbs[i].get());
+        cb->remaining = &remaining;
+        cb->done = &done;
+    }
+
+    TimeIt texpire;
+
+    for(size_t n=0; n<nsamples; n++) {
+        remaining = ntimers;
+        texpire.start();
+        // all expire within 10ms
+        for(size_t i=0; i<ntimers; i++)
+            timer.scheduleAfterDelay(cbs[i], (rand()%10000)*1e-6);
+        done.wait();
+        texpire.end();
+    }
+
+    testDiag("scheduleAfterDelay() and expire");
+    texpire.report("ms", 1e-3);
+    texpire.reportRate(ntimers);
+}
+
+struct Slow : public pvd::TimerCallback {
+    virtual ~Slow() {}
+    virtual void callback() {
+        epicsThreadSleep(0.05);
+    }
+    virtual void timerStopped() {}
+};
+
+// Many fast periodic callbacks, and one slow one.
+// Compare callback latency when run by the timer thread, or by workers.
+void slowNeighbour(unsigned nworkers)
+{
+    testDiag("%s %u workers", CURRENT_FUNCTION, nworkers);
+
+    pvd::Timer timer("performtimer", pvd::lowPriority, nworkers);
+    callbacks_t cbs;
+    cbs.resize(1000u);
+    for(size_t i=0; i<cbs.size(); i++) {
+        cbs[i].reset(new Noop);
+        timer.schedulePeriodic(cbs[i], 0.01, 0.01);
+    }
+    pvd::TimerCallbackPtr slow(new Slow);
+    timer.schedulePeriodic(slow, 0.01, 0.1);
+
+    epicsThreadSleep(2.0);
+
+    std::ostringstream strm;
+    timer.dump(strm);
+    std::istringstream lines(strm.str());
+    std::string line;
+    while(std::getline(lines, line)) {
+        if(line.find("latency")==0u || line.find("duration")==0u)
+            testDiag("%s", line.c_str());
+    }
+}
+
+} // namespace
+
+MAIN(performTimer) {
+    testPlan(0);
+    scheduleCancel();
+    expire();
+    slowNeighbour(0u);
+    slowNeighbour(4u);
+    return testDone();
+}
@@ -0,0 +1,212 @@
+// Memory bandwidth spent preparing large array buffers which will then be overwritten,
+// as when each monitor update of a waveform is deserialized.
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+#include <testMain.h>
+#include <epicsUnitTest.h>
+
+#include <pv/current_function.h>
+#include <pv/pvData.h>
+#include <pv/serialize.h>
+#include <pv/byteBuffer.h>
+#include <pv/arrayAllocator.h>
+#include <pv/pvSubArrayCopy.h>
+
+namespace {
+
+namespace pvd = epics::pvData;
+
+struct TimeIt {
+    struct timespec m_start;
+    double sum, sum2;
+    size_t count;
+    TimeIt() { reset(); }
+    void reset() {
+        sum = sum2 = 0.0;
+        count = 0;
+    }
+    void start() {
+        clock_gettime(CLOCK_MONOTONIC, &m_start);
+    }
+    void end() {
+        struct timespec end;
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double diff = (end.tv_sec-m_start.tv_sec) + (end.tv_nsec-m_start.tv_nsec)*1e-9;
+        sum += diff;
+        sum2 += diff*diff;
+        count++;
+    }
+    void report(const char *unit ="s", double mult=1.0) const {
+        double mean = sum/count;
+        double mean2 = sum2/count;
+        double std = sqrt(mean2 - mean*mean);
+        printf("# %zu sample   %f +- %f %s\n", count, mean/mult, std/mult, unit);
+    }
+    void reportRate(size_t nbytes) const {
+        double mean = sum/count;
+        printf("#   %.1f MB/s\n", nbytes/mean/1e6);
+    }
+};
+
+const size_t nsamples = 20;
+// 16 MB frames
+const size_t nelem = 2u*1024u*1024u;
+
+struct NoopControl : public pvd::DeserializableControl {
+    virtual void ensureData(size_t) {}
+    virtual bool directDeserialize(pvd::ByteBuffer*, char*, size_t, size_t) { return false; }
+    virtual std::tr1::shared_ptr<const pvd::Field> cachedDeserialize(pvd::ByteBuffer*) {
+        return std::tr1::shared_ptr<const pvd::Field>();
+    }
+};
+
+// Each update replaces 'value' while a reader (eg. a monitor queue) still holds the previous frame.
+void frameUpdate()
+{
+    testDiag("%s %zu bytes", CURRENT_FUNCTION, nelem*sizeof(double));
+
+    std::vector<double> src(nelem, 1.5);
+
+    TimeIt tresize, tinit, tnew, toverwrite;
+
+    pvd::shared_vector<const double> value(nelem, 0.0), held;
+
+    for(size_t i=0; i<nsamples; i++) {
+        {
+            // previous PVValueArray::deserialize().  thaw() copies the old frame
+            held = value;
+            tresize.start();
+            pvd::shared_vector<double> next(pvd::thaw(value));
+            next.resize(nelem);
+            memcpy(next.data(), &src[0], nelem*sizeof(double));
+            value = pvd::freeze(next);
+            held.clear();
+            tresize.end();
+        }
+        {
+            held = value;
+            tinit.start();
+            pvd::shared_vector<double> next(nelem, 0.0);
+            memcpy(next.data(), &src[0], nelem*sizeof(double));
+            value = pvd::freeze(next);
+            held.clear();
+            tinit.end();
+        }
+        {
+            held = value;
+            tnew.start();
+            pvd::shared_vector<double> next(nelem);
+            memcpy(next.data(), &src[0], nelem*sizeof(double));
+            value = pvd::freeze(next);
+            held.clear();
+            tnew.end();
+        }
+        {
+            held = value;
+            toverwrite.start();
+            pvd::shared_vector<double> next;
+            value.clear();
+            pvd::resize_for_overwrite(next, nelem, pvd::ArrayAllocator::CacheLine);
+            memcpy(next.data(), &src[0], nelem*sizeof(double));
+            value = pvd::freeze(next);
+            held.clear();
+            toverwrite.end();
+        }
+    }
+
+    testDiag("thaw() and resize()");
+    tresize.report("ms", 1e-3);
+    tresize.reportRate(nelem*sizeof(double));
+    testDiag("value initialized new[]");
+    tinit.report("ms", 1e-3);
+    tinit.reportRate(nelem*sizeof(double));
+    testDiag("uninitialized new[]");
+    tnew.report("ms", 1e-3);
+    tnew.reportRate(nelem*sizeof(double));
+    testDiag("resize_for_overwrite() from ArrayPool");
+    toverwrite.report("ms", 1e-3);
+    toverwrite.reportRate(nelem*sizeof(double));
+}
+
+void deserializeUpdate()
+{
+    testDiag("%s %zu bytes", CURRENT_FUNCTION, nelem*sizeof(double));
+
+    pvd::ByteBuffer buf(nelem*sizeof(double)+16u);
+    {
+        pvd::shared_vector<double> src(nelem, 1.5);
+        pvd::PVDoubleArrayPtr arr(pvd::getPVDataCreate()->createPVScalarArray<pvd::PVDoubleArray>());
+        arr->replace(pvd::freeze(src));
+        struct NoopSerialize : public pvd::SerializableControl {
+            virtual void flushSerializeBuffer() {}
+            virtual void ensureBuffer(size_t) {}
+            virtual bool directSerialize(pvd::ByteBuffer*, const char*, size_t, size_t) { return false; }
+            virtual void cachedSerialize(std::tr1::shared_ptr<const pvd::Field> const &, pvd::ByteBuffer*) {}
+        } scontrol;
+        arr->serialize(&buf, &scontrol);
+        buf.flip();
+    }
+
+    pvd::PVDoubleArrayPtr dest(pvd::getPVDataCreate()->createPVScalarArray<pvd::PVDoubleArray>());
+    pvd::PVDoubleArray::const_svector held;
+    NoopControl control;
+    TimeIt tdeserial;
+
+    for(size_t i=0; i<nsamples; i++) {
+        held = dest->view();
+        buf.setPosition(0);
+        tdeserial.start();
+        dest->deserialize(&buf, &control);
+        held.clear();
+        tdeserial.end();
+    }
+
+    testDiag("PVDoubleArray::deserialize() with previous value held");
+    tdeserial.report("ms", 1e-3);
+    tdeserial.reportRate(nelem*sizeof(double));
+}
+
+void subArrayCopy()
+{
+    testDiag("%s %zu bytes", CURRENT_FUNCTION, nelem*sizeof(double));
+
+    pvd::PVDoubleArrayPtr from(pvd::getPVDataCreate()->createPVScalarArray<pvd::PVDoubleArray>()),
+                          to(pvd::getPVDataCreate()->createPVScalarArray<pvd::PVDoubleArray>());
+    {
+        pvd::shared_vector<double> src(nelem, 1.5);
+        from->replace(pvd::freeze(src));
+    }
+
+    TimeIt tcopy;
+
+    for(size_t i=0; i<nsamples; i++) {
+        tcopy.start();
+        pvd::copy(*from, 0, 1, *to, 0, 1, nelem);
+        tcopy.end();
+    }
+
+    testDiag("pvSubArrayCopy contiguous");
+    tcopy.report("ms", 1e-3);
+    tcopy.reportRate(nelem*sizeof(double));
+}
+
+} // namespace
+
+MAIN(performVector) {
+    testPlan(0);
+    frameUpdate();
+    deserializeUpdate();
+    subArrayCopy();
+    {
+        pvd::ArrayPool::shared_pointer pool(std::tr1::dynamic_pointer_cast<pvd::ArrayPool>(pvd::ArrayAllocator::current()));
+        if(pool) {
+            pvd::ArrayPool::Stats stats(pool->stats());
+            testDiag("ArrayPool hit rate %.2f, %zu bytes retained", stats.hitRate(), stats.bytesRetained);
+        }
+    }
+    return testDone();
+}
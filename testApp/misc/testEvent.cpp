@@ -3,10 +3,16 @@
  * found in the file LICENSE that is included with the distribution
  */
 
+#include <vector>
+
 #include <epicsUnitTest.h>
 #include <testMain.h>
+#include <epicsEvent.h>
+#include <epicsTime.h>
+#include <epicsAtomic.h>
 
 #include <pv/event.h>
+#include <pv/thread.h>
 
 using namespace epics::pvData;
 
@@ -41,9 +47,115 @@ static void testBasicEvent()
     testOk1(!e.tryWait());
 }
 
+static void testTimeout()
+{
+    testDiag("testTimeout");
+
+    Event e;
+    epicsTime start(epicsTime::getCurrent());
+    bool ok = e.wait(0.1);
+    double elapsed = epicsTime::getCurrent() - start;
+    testOk(!ok && elapsed>=0.09, "wait(0.1) on empty %c after %f sec", ok?'Y':'N', elapsed);
+
+    Event full(true);
+    testOk1(full.wait(0.1));
+}
+
+namespace {
+struct Waiters {
+    Event e, woke;
+    size_t count;
+    Waiters() :count(0u) {}
+    static void run(void *raw)
+    {
+        Waiters *self = (Waiters*)raw;
+        self->e.wait();
+        epics::atomic::increment(self->count);
+        self->woke.signal();
+    }
+};
+}
+
+static void testManyWaiters()
+{
+    testDiag("testManyWaiters");
+
+    Waiters W;
+    std::vector<Thread*> threads(4u);
+    for(size_t i=0; i<threads.size(); i++) {
+        threads[i] = new Thread(Thread::Config(&Waiters::run, &W)
+                                .prio(epicsThreadPriorityMedium)
+                                <<"waiter"<<i);
+    }
+    epicsThreadSleep(0.1);
+
+    // each signal() wakes one waiter
+    for(size_t i=0; i<threads.size(); i++) {
+        W.e.signal();
+        W.woke.wait();
+    }
+    for(size_t i=0; i<threads.size(); i++)
+        delete threads[i]; // joins
+    testOk(W.count==threads.size(), "woke %zu of %zu", W.count, threads.size());
+}
+
+namespace {
+const size_t npingpong = 20000u;
+
+template<typename E>
+struct PingPong {
+    E ping, pong;
+    size_t count;
+    PingPong() :count(0u) {}
+    static void echo(void *raw)
+    {
+        PingPong *self = (PingPong*)raw;
+        for(size_t i=0; i<npingpong; i++) {
+            self->ping.wait();
+            self->count++;
+            self->pong.signal();
+        }
+    }
+    // mean round trip time in seconds
+    double run()
+    {
+        Thread peer(Thread::Config(&echo, this)
+                    .prio(epicsThreadGetPrioritySelf())
+                    <<"pong");
+        epicsTime start(epicsTime::getCurrent());
+        for(size_t i=0; i<npingpong; i++) {
+            ping.signal();
+            pong.wait();
+        }
+        double elapsed = epicsTime::getCurrent() - start;
+        return elapsed/npingpong;
+    }
+};
+}
+
+// Latency of a hand-off between two threads, and back.
+static void testPingPong()
+{
+    testDiag("testPingPong %zu round trips", npingpong);
+
+    PingPong<epicsEvent> base;
+    double tbase = base.run();
+    testDiag("epicsEvent     %.0f ns per round trip", tbase*1e9);
+
+    PingPong<Event> pvd;
+    double tpvd = pvd.run();
+    testDiag("pvData::Event  %.0f ns per round trip", tpvd*1e9);
+
+    testOk(base.count==npingpong && pvd.count==npingpong,
+           "round trips %zu, %zu", base.count, pvd.count);
+}
+
 MAIN(testEvent)
 {
-    testPlan(9);
+    testPlan(13);
     testBasicEvent();
+    testTimeout();
+    testManyWaiters();
+    testPingPong();
     return testDone();
 }
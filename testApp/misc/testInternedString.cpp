@@ -0,0 +1,111 @@
+/*
+ * Copyright information and license terms for this software can be
+ * found in the file LICENSE that is included with the distribution
+ */
+#include <vector>
+#include <sstream>
+
+#include <epicsThread.h>
+#include <epicsAtomic.h>
+
+#include <pv/pvUnitTest.h>
+#include <testMain.h>
+
+#include <pv/internedString.h>
+#include <pv/thread.h>
+#include <pv/epicsException.h>
+
+namespace pvd = epics::pvData;
+
+namespace {
+
+void testEmpty()
+{
+    testDiag("testEmpty()");
+    pvd::InternedString A, B(""), C((const char*)0);
+
+    testOk1(A.empty());
+    testOk1(A==B && B==C);
+    testEqual(A.str(), "");
+    testEqual(A.size(), 0u);
+    testEqual(A.hash(), pvd::InternedString::hashOf(""));
+}
+
+void testShare()
+{
+    testDiag("testShare()");
+    size_t before = pvd::InternedString::count();
+    {
+        pvd::InternedString A("testShare"), B(std::string("testShare")), C("testShareOther");
+
+        testEqual(pvd::InternedString::count(), before+2u);
+        testOk1(A==B);
+        testOk1(A!=C);
+        testOk1(&A.str()==&B.str());
+        testOk1(A=="testShare");
+        testEqual(A.hash(), pvd::InternedString::hashOf("testShare"));
+
+        pvd::InternedString D(A);
+        testOk1(D==A);
+        D = C;
+        testOk1(D==C);
+        D = pvd::InternedString();
+        testOk1(D.empty());
+
+        std::ostringstream strm;
+        strm<<A;
+        testEqual(strm.str(), "testShare");
+    }
+    testEqual(pvd::InternedString::count(), before);
+}
+
+size_t raceErrors;
+
+// Intern and release the same few strings from several threads,
+// racing the release of the last reference with lookups.
+void internMany(void *)
+{
+    for(size_t n=0; n<10000; n++) {
+        std::ostringstream strm;
+        strm<<"racer"<<(n%4u);
+        pvd::InternedString A(strm.str());
+        pvd::InternedString B(A);
+        if(A!=B || A.str()!=strm.str())
+            epics::atomic::increment(raceErrors);
+    }
+}
+
+void testRace()
+{
+    testDiag("testRace()");
+    size_t before = pvd::InternedString::count();
+
+    std::vector<pvd::ThreadPtr> threads;
+    for(unsigned i=0; i<4; i++) {
+        pvd::Thread::Config conf(&internMany, 0);
+        conf.prio(epicsThreadPriorityMedium)
+            .autostart(true);
+        threads.push_back(pvd::ThreadPtr(new pvd::Thread(conf<<"racer"<<i)));
+    }
+    for(unsigned i=0; i<threads.size(); i++)
+        threads[i]->exitWait();
+
+    testEqual(raceErrors, 0u);
+    testEqual(pvd::InternedString::count(), before);
+}
+
+} // namespace
+
+MAIN(testInternedString)
+{
+    testPlan(18);
+    try {
+        testEmpty();
+        testShare();
+        testRace();
+    }catch(std::exception& e){
+        PRINT_EXCEPTION(e);
+        testAbort("Unexpected exception: %s", e.what());
+    }
+    return testDone();
+}
@@ -11,11 +11,13 @@
 #include <stdio.h>
 
 #include <vector>
+#include <stdexcept>
 
 #include <pv/pvUnitTest.h>
 #include <testMain.h>
 
 #include "pv/sharedVector.h"
+#include "pv/arrayAllocator.h"
 
 namespace {
 
@@ -694,11 +696,108 @@ void testCXX11Init()
 #endif
 }
 
+void testArrayPool()
+{
+    testDiag("Test allocation from ArrayPool");
+
+    pvd::ArrayPool::shared_pointer pool(new pvd::ArrayPool(1024u*1024u, 64u*1024u));
+    pvd::ArrayAllocator::install(pool);
+    testOk1(pvd::ArrayAllocator::current()==pool);
+
+    const double *check;
+    {
+        pvd::shared_vector<double> A(pvd::allocate_shared_vector<double>(10000u));
+        testOk1(A.size()==10000u);
+        testOk1(A.unique());
+        check = A.data();
+        A[9999] = 42.0;
+
+        pvd::ArrayPool::Stats stats(pool->stats());
+        testOk(stats.requests==1u && stats.hits==0u, "requests=%zu hits=%zu", stats.requests, stats.hits);
+    }
+    {
+        pvd::ArrayPool::Stats stats(pool->stats());
+        testOk(stats.releases==1u && stats.buffersRetained==1u, "releases=%zu buffersRetained=%zu",
+               stats.releases, stats.buffersRetained);
+        testOk(stats.bytesRetained>=10000u*sizeof(double), "bytesRetained=%zu", stats.bytesRetained);
+    }
+    {
+        // slightly smaller is in the same size class
+        pvd::shared_vector<const double> B(pvd::allocate_shared_vector<const double>(9900u));
+        testOk1(B.data()==check);
+
+        pvd::ArrayPool::Stats stats(pool->stats());
+        testOk(stats.hits==1u && stats.buffersRetained==0u && stats.bytesRetained==0u,
+               "hits=%zu buffersRetained=%zu bytesRetained=%zu",
+               stats.hits, stats.buffersRetained, stats.bytesRetained);
+        testOk(stats.hitRate()==0.5, "hitRate=%f", stats.hitRate());
+    }
+    {
+        // too small to be pooled
+        pvd::shared_vector<pvd::int8> C(pvd::allocate_shared_vector<pvd::int8>(100u));
+        testOk1(C.size()==100u);
+        testOk1(pool->stats().requests==2u);
+    }
+    pool->trim();
+    testOk1(pool->stats().bytesRetained==0u);
+    {
+        // more than maxRetained
+        std::vector<pvd::shared_vector<pvd::uint8> > bufs(4u);
+        for(size_t i=0; i<bufs.size(); i++)
+            bufs[i] = pvd::allocate_shared_vector<pvd::uint8>(300u*1024u);
+    }
+    {
+        pvd::ArrayPool::Stats stats(pool->stats());
+        testOk(stats.dropped==1u && stats.buffersRetained==3u, "dropped=%zu buffersRetained=%zu",
+               stats.dropped, stats.buffersRetained);
+        testOk(stats.bytesRetained<=1024u*1024u, "bytesRetained=%zu", stats.bytesRetained);
+    }
+
+    testOk1(pvd::allocate_shared_vector<double>(0u).empty());
+    {
+        pvd::shared_vector<double> small(pvd::allocate_shared_vector<double>(3u, pvd::ArrayAllocator::CacheLine)),
+                                   large(pvd::allocate_shared_vector<double>(100000u, pvd::ArrayAllocator::CacheLine));
+        testOk1(((size_t)small.data() % pvd::ArrayAllocator::CacheLine)==0u);
+        testOk1(((size_t)large.data() % pvd::ArrayAllocator::CacheLine)==0u);
+        testOk1(pvd::allocate_shared_vector<std::string>(2u).size()==2u);
+        try {
+            pvd::allocate_shared_vector<double>(3u, 3u);
+            testFail("Missing expected exception");
+        } catch(std::invalid_argument& e) {
+            testPass("Expected exception: %s", e.what());
+        }
+    }
+    {
+        testDiag("resize_for_overwrite()");
+        pvd::shared_vector<pvd::int32> A(pvd::allocate_shared_vector<pvd::int32>(100000u, pvd::ArrayAllocator::CacheLine));
+        const pvd::int32 *check = A.data();
+
+        pvd::resize_for_overwrite(A, 50000u, pvd::ArrayAllocator::CacheLine);
+        testOk1(A.size()==50000u && A.data()==check);
+
+        pvd::shared_vector<pvd::int32> B(A);
+        pvd::resize_for_overwrite(A, 60000u);
+        testOk1(A.unique() && B.unique());
+        testOk1(A.size()==60000u && A.data()!=check);
+        testOk1(B.size()==50000u && B.data()==check);
+
+        pvd::resize_for_overwrite(A, 0u);
+        testOk1(A.empty() && A.unique());
+
+        pvd::shared_vector<pvd::int32> C(5, 1);
+        pvd::resize_for_overwrite(C, 200000u);
+        testOk1(C.size()==200000u && C.unique());
+    }
+
+    pvd::ArrayAllocator::install(pvd::ArrayAllocator::shared_pointer());
+    testOk1(pvd::ArrayAllocator::current()!=pool);
+}
+
 } // namespace
 
 MAIN(testSharedVector)
 {
-    testPlan(192);
+    testPlan(218);
     testDiag("Tests for shared_vector");
 
     testDiag("sizeof(shared_vector<pvd::int32>)=%lu",
@@ -722,5 +821,6 @@ MAIN(testSharedVector)
     testAutoSwap();
     testCXX11Move();
     testCXX11Init();
+    testArrayPool();
     return testDone();
 }
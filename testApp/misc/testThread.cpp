@@ -16,13 +16,23 @@
 #include <cstdio>
 #include <cstring>
 #include <list>
+#include <sstream>
+#include <vector>
+#include <stdexcept>
+
+#if defined(__linux__)
+#  include <sched.h>
+#endif
 
 #include <epicsUnitTest.h>
 #include <testMain.h>
+#include <epicsAtomic.h>
 
 
 #include <pv/event.h>
 #include <pv/thread.h>
+#include <pv/threadPool.h>
+#include <pv/lock.h>
 
 using namespace epics::pvData;
 using std::string;
@@ -152,11 +162,304 @@ static void testBinders()
 #endif
 }
 
+namespace {
+struct poolCount {
+    size_t cnt;
+    std::string name;
+    unsigned prio;
+    poolCount() :cnt(0u), prio(0u) {}
+};
+
+void poolInc(void *raw)
+{
+    poolCount *arg = (poolCount*)raw;
+    arg->name = epicsThreadGetNameSelf();
+    arg->prio = epicsThreadGetPrioritySelf();
+    epics::atomic::increment(arg->cnt);
+}
+
+void poolThrow(void *)
+{
+    throw std::runtime_error("poolThrow");
+}
+
+void poolMark(void *raw, size_t first, size_t last)
+{
+    std::vector<int>& marks = *(std::vector<int>*)raw;
+    for(size_t i=first; i<last; i++)
+        epics::atomic::increment(marks[i]);
+}
+
+void poolMarkThrow(void *raw, size_t first, size_t last)
+{
+    if(first<=500u && 500u<last)
+        throw std::runtime_error("poolMarkThrow");
+    poolMark(raw, first, last);
+}
+
+struct nestedFor {
+    epics::pvData::ThreadPool *pool;
+    std::vector<int> marks;
+    static void outer(void *raw, size_t first, size_t last)
+    {
+        nestedFor *self = (nestedFor*)raw;
+        for(size_t i=first; i<last; i++)
+            self->pool->parallel_for(i*100u, (i+1u)*100u, 7u, &poolMark, &self->marks);
+    }
+};
+
+bool allOnce(const std::vector<int>& marks)
+{
+    for(size_t i=0; i<marks.size(); i++)
+        if(marks[i]!=1)
+            return false;
+    return true;
+}
+}
+
+static void testThreadPool()
+{
+    testDiag("Testing ThreadPool");
+
+    epics::pvData::Thread::Config conf;
+    conf.prio(epicsThreadPriorityMedium)
+        <<"tpool";
+    epics::pvData::ThreadPool pool(conf, 3u);
+
+    {
+        poolCount info;
+        epics::pvData::ThreadPool::Future F(pool.submit(&poolInc, &info));
+        F.wait();
+        testOk(F.done() && info.cnt==1u, "done=%c cnt (%zu) == 1", F.done()?'Y':'N', info.cnt);
+        testOk(info.name.substr(0, 6)=="tpool-", "worker name '%s'", info.name.c_str());
+    }
+
+    {
+        poolCount info;
+        std::vector<epics::pvData::ThreadPool::Future> futures;
+        for(size_t i=0; i<1000u; i++)
+            futures.push_back(pool.submit(&poolInc, &info));
+        for(size_t i=0; i<futures.size(); i++)
+            futures[i].wait();
+        testOk(info.cnt==1000u, "cnt (%zu) == 1000", info.cnt);
+    }
+
+    try {
+        pool.submit(&poolThrow, 0).wait();
+        testFail("Missing exception");
+    } catch(std::runtime_error& e) {
+        testOk(strcmp(e.what(), "poolThrow")==0, "Caught expected '%s'", e.what());
+    }
+
+    {
+        std::vector<int> marks(10000u, 0);
+        pool.parallel_for(0u, marks.size(), 64u, &poolMark, &marks);
+        testOk(allOnce(marks), "parallel_for() visits each index once");
+    }
+
+    {
+        nestedFor nest;
+        nest.pool = &pool;
+        nest.marks.resize(10000u, 0);
+        pool.parallel_for(0u, 100u, 1u, &nestedFor::outer, &nest);
+        testOk(allOnce(nest.marks), "nested parallel_for() visits each index once");
+    }
+
+    try {
+        std::vector<int> marks(1000u, 0);
+        pool.parallel_for(0u, marks.size(), 10u, &poolMarkThrow, &marks);
+        testFail("Missing exception");
+    } catch(std::runtime_error& e) {
+        testOk(strcmp(e.what(), "poolMarkThrow")==0, "Caught expected '%s'", e.what());
+    }
+
+    testOk1(epics::pvData::ThreadPool::Future().done());
+
+#if __cplusplus>=201103L
+    {
+        size_t sum = 0u;
+        pool.submit([&sum]() { sum = 42u; }).wait();
+        std::vector<int> marks(1000u, 0);
+        pool.parallel_for(0u, marks.size(), 10u, [&marks](size_t first, size_t last) {
+            for(size_t i=first; i<last; i++)
+                marks[i]++;
+        });
+        testOk(sum==42u && allOnce(marks), "C++11 lambda submit() and parallel_for()");
+    }
+#else
+    testSkip(1, "Not built as C++11");
+#endif
+}
+
+static void testGlobalPool()
+{
+    testDiag("Testing ThreadPool::global()");
+
+    epics::pvData::ThreadPool& high = epics::pvData::ThreadPool::global(epicsThreadPriorityHigh);
+    testOk1(&high==&epics::pvData::ThreadPool::global(epicsThreadPriorityHigh));
+    testOk1(&high!=&epics::pvData::ThreadPool::global(epicsThreadPriorityLow));
+    testOk1(&epics::pvData::ThreadPool::global()==&epics::pvData::ThreadPool::global(epicsThreadGetPrioritySelf()));
+
+    poolCount info;
+    high.submit(&poolInc, &info).wait();
+    testOk(info.prio==epicsThreadPriorityHigh, "worker priority %u == %u", info.prio, unsigned(epicsThreadPriorityHigh));
+}
+
+namespace {
+struct schedInfo {
+    bool ok;
+    int ncpus, policy;
+    int first; // lowest CPU in the mask
+    schedInfo() :ok(false), ncpus(0), policy(-1), first(-1) {}
+};
+
+void readSched(void *raw)
+{
+    schedInfo *info = (schedInfo*)raw;
+#if defined(__linux__)
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    info->ok = sched_getaffinity(0, sizeof(mask), &mask)==0;
+    info->ncpus = CPU_COUNT(&mask);
+    for(int i=0; i<CPU_SETSIZE && info->first<0; i++)
+        if(CPU_ISSET(i, &mask))
+            info->first = i;
+    info->policy = sched_getscheduler(0);
+#endif
+}
+}
+
+static void testAffinity()
+{
+    testDiag("Testing Thread::Config affinity() and policy()");
+#if defined(__linux__)
+    // CPU 0 may be excluded, eg. by taskset or a cpuset, so use one we may run on
+    schedInfo self;
+    readSched(&self);
+    const unsigned cpu = self.first>=0 ? unsigned(self.first) : 0u;
+    testDiag("Using CPU %u", cpu);
+    {
+        schedInfo info;
+        epics::pvData::Thread foo(epics::pvData::Thread::Config(&readSched, (void*)&info)
+                   .affinity(cpu)
+                   .policy(epics::pvData::Thread::SchedOther)
+                   <<"testaff");
+        foo.exitWait();
+
+        testOk(info.ok && info.ncpus==1 && info.first==int(cpu),
+               "sched_getaffinity() ok=%c ncpus=%d first=%d",
+               info.ok?'Y':'N', info.ncpus, info.first);
+        testOk(info.policy==SCHED_OTHER, "policy %d == SCHED_OTHER", info.policy);
+    }
+    {
+        schedInfo info;
+        epics::pvData::Thread::Config conf;
+        conf.affinity(cpu)
+            <<"testaffpool";
+        epics::pvData::ThreadPool pool(conf, 2u);
+        pool.submit(&readSched, &info).wait();
+
+        testOk(info.ok && info.ncpus==1 && info.first==int(cpu),
+               "ThreadPool worker sched_getaffinity() ok=%c ncpus=%d first=%d",
+               info.ok?'Y':'N', info.ncpus, info.first);
+    }
+#else
+    testSkip(3, "sched_getaffinity() only on Linux");
+#endif
+}
+
+namespace {
+struct holder {
+    TrackedMutex *mutex;
+    Event locked;
+    static void run(void *raw)
+    {
+        holder *self = (holder*)raw;
+        Lock G(*self->mutex);
+        self->locked.signal();
+        epicsThreadSleep(0.05);
+    }
+};
+
+size_t sum(const size_t *hist)
+{
+    size_t ret = 0u;
+    for(unsigned i=0; i<MutexSnapshot::Stats::NBuckets; i++)
+        ret += hist[i];
+    return ret;
+}
+}
+
+static void testMutexStats()
+{
+    testDiag("Testing TrackedMutex");
+
+    TrackedMutex mutex("testMutex");
+    MutexSnapshot before, after;
+
+    enableMutexStats(true);
+    before.update();
+    for(size_t i=0; i<10u; i++) {
+        Lock G(mutex);
+    }
+    {
+        Lock G(mutex);
+        mutex.lock(); // recursive counts once
+        mutex.unlock();
+    }
+    if(mutex.tryLock())
+        mutex.unlock();
+    after.update();
+    {
+        MutexSnapshot::Stats S((after-before)["testMutex"]);
+        testOk(S.acquired==12u && S.contended==0u && sum(S.hold)==12u,
+               "acquired %zu contended %zu held %zu", S.acquired, S.contended, sum(S.hold));
+    }
+
+    before.update();
+    {
+        holder H;
+        H.mutex = &mutex;
+        epics::pvData::Thread T(epics::pvData::Thread::Config(&holder::run, &H)
+                                <<"holder");
+        H.locked.wait();
+        Lock G(mutex);
+    }
+    after.update();
+    {
+        MutexSnapshot::Stats S((after-before)["testMutex"]);
+        testOk(S.acquired==2u && S.contended==1u && sum(S.wait)==1u && S.wait[0]==0u,
+               "acquired %zu contended %zu waited %zu", S.acquired, S.contended, sum(S.wait));
+        testOk(S.contention()==0.5, "contention %f", S.contention());
+    }
+
+    enableMutexStats(false);
+    before.update();
+    for(size_t i=0; i<10u; i++) {
+        Lock G(mutex);
+    }
+    after.update();
+    testOk((after-before)["testMutex"].acquired==0u, "not counted when disabled");
+
+    std::ostringstream strm;
+    strm<<after;
+    testOk(strm.str().find("testMutex:\t14 acquired, 1 contended")!=std::string::npos,
+           "printed");
+    std::istringstream lines(strm.str());
+    std::string line;
+    while(std::getline(lines, line))
+        testDiag("%s", line.c_str());
+}
+
 MAIN(testThread)
 {
-    testPlan(6);
+    testPlan(27);
     testDiag("Tests thread");
     testThreadRun();
     testBinders();
+    testThreadPool();
+    testGlobalPool();
+    testAffinity();
+    testMutexStats();
     return testDone();
 }
@@ -16,10 +16,14 @@
 #include <cstdio>
 #include <iostream>
 #include <exception>
+#include <stdexcept>
+#include <vector>
+#include <sstream>
 
 #include <epicsUnitTest.h>
 #include <testMain.h>
 #include <epicsGuard.h>
+#include <epicsThread.h>
 
 #include <pv/timeStamp.h>
 #include <pv/event.h>
@@ -219,9 +223,248 @@ static void testCancel(unsigned oneOrd, unsigned twoOrd, unsigned threeOrd,
     }
 }
 
+namespace {
+struct OrderCallback : public TimerCallback {
+    POINTER_DEFINITIONS(OrderCallback);
+
+    const unsigned id;
+    std::vector<unsigned>& order;
+    Mutex& mutex;
+    Event& done;
+    OrderCallback(unsigned id, std::vector<unsigned>& order, Mutex& mutex, Event& done)
+        :id(id), order(order), mutex(mutex), done(done)
+    {}
+    virtual ~OrderCallback() {}
+    virtual void callback()
+    {
+        epicsGuard<Mutex> G(mutex);
+        order.push_back(id);
+        done.signal();
+    }
+    virtual void timerStopped() {}
+};
+}
+
+static void testMany()
+{
+    const unsigned N = 200u;
+    testDiag("testMany %u", N);
+
+    Timer timer("timer" ,middlePriority), other("other", middlePriority);
+
+    Marker::shared_pointer marker(new Marker);
+    std::vector<unsigned> order;
+    Mutex mutex;
+    Event done;
+    std::vector<OrderCallback::shared_pointer> cbs(N);
+
+    timer.scheduleAfterDelay(marker, 0.0);
+    marker->wait.wait();
+    // timer worker is blocked
+
+    // scheduled in reverse order of expiration
+    for(unsigned i=0; i<N; i++) {
+        cbs[i].reset(new OrderCallback(i, order, mutex, done));
+        timer.scheduleAfterDelay(cbs[i], (N-i)*0.001);
+    }
+
+    bool ok = true;
+    for(unsigned i=0; i<N; i+=3u) {
+        ok &= timer.cancel(cbs[i]);
+    }
+    testOk(ok, "cancel() every third");
+
+    ok = true;
+    for(unsigned i=0; i<N; i++)
+        ok &= timer.isScheduled(cbs[i]) == (i%3u!=0u);
+    testOk(ok, "isScheduled() after cancel()");
+
+    try {
+        other.cancel(cbs[1]);
+        testFail("Missing expected exception");
+    } catch(std::logic_error& e) {
+        testPass("Expected exception: %s", e.what());
+    }
+
+    marker->hold.signal(); // let the worker loose
+
+    std::vector<unsigned> expect;
+    for(unsigned i=N; i>0u; i--) {
+        if((i-1u)%3u!=0u)
+            expect.push_back(i-1u);
+    }
+
+    while(true) {
+        {
+            epicsGuard<Mutex> G(mutex);
+            if(order.size()>=expect.size())
+                break;
+        }
+        done.wait(1.0);
+    }
+
+    epicsGuard<Mutex> G(mutex);
+    testOk(order==expect, "%zu callbacks run in order of expiration", order.size());
+}
+
+namespace {
+struct OverlapCallback : public TimerCallback {
+    POINTER_DEFINITIONS(OverlapCallback);
+
+    Mutex mutex;
+    unsigned active, maxActive, count;
+    OverlapCallback() :active(0u), maxActive(0u), count(0u) {}
+    virtual ~OverlapCallback() {}
+    virtual void callback()
+    {
+        {
+            epicsGuard<Mutex> G(mutex);
+            active++;
+            count++;
+            if(active>maxActive)
+                maxActive = active;
+        }
+        epicsThreadSleep(0.005);
+        {
+            epicsGuard<Mutex> G(mutex);
+            active--;
+        }
+    }
+    virtual void timerStopped() {}
+};
+}
+
+static void testWorkers()
+{
+    testDiag("testWorkers");
+
+    Timer timer("timer", middlePriority, 2u);
+
+    Marker::shared_pointer marker(new Marker);
+    MyCallbackPtr callbackOne(new MyCallback("one"));
+    OverlapCallback::shared_pointer periodic(new OverlapCallback);
+
+    timer.scheduleAfterDelay(marker, 0.0);
+    marker->wait.wait();
+    // one worker is blocked
+
+    callbackOne->clear();
+    timer.scheduleAfterDelay(callbackOne, 0.01);
+    testOk(callbackOne->wait.wait(5.0), "callback runs while another is blocked");
+
+    // period shorter than callback
+    timer.schedulePeriodic(periodic, 0.0, 0.001);
+    epicsThreadSleep(0.1);
+    testOk1(timer.cancel(periodic));
+
+    // wait for a callback in progress to complete
+    while(true) {
+        epicsGuard<Mutex> G(periodic->mutex);
+        if(!periodic->active)
+            break;
+        epicsGuardRelease<Mutex> U(G);
+        epicsThreadSleep(0.01);
+    }
+    testOk1(!timer.isScheduled(periodic));
+    {
+        epicsGuard<Mutex> G(periodic->mutex);
+        testOk(periodic->count>1u && periodic->maxActive==1u,
+               "periodic callback ran %u times, without overlap (%u)", periodic->count, periodic->maxActive);
+    }
+
+    marker->hold.signal();
+
+    std::ostringstream strm;
+    timer.dump(strm);
+    std::istringstream lines(strm.str());
+    std::string line;
+    while(std::getline(lines, line))
+        testDiag("%s", line.c_str());
+    testOk(strm.str().find("latency ")!=std::string::npos, "dump() includes latency histogram");
+}
+
+namespace {
+struct SelfSchedule : public OverlapCallback {
+    POINTER_DEFINITIONS(SelfSchedule);
+
+    Timer& timer;
+    TimerCallbackPtr self;
+    Event done;
+    explicit SelfSchedule(Timer& timer) :timer(timer) {}
+    virtual ~SelfSchedule() {}
+    virtual void callback()
+    {
+        OverlapCallback::callback();
+        bool again;
+        {
+            epicsGuard<Mutex> G(mutex);
+            again = count<10u;
+        }
+        if(again) {
+            // already expired when this returns
+            timer.scheduleAfterDelay(self, 0.0);
+            epicsThreadSleep(0.01);
+        } else {
+            done.signal();
+        }
+    }
+};
+}
+
+static void testReschedule()
+{
+    testDiag("testReschedule");
+
+    Timer timer("timer", middlePriority, 2u);
+
+    SelfSchedule::shared_pointer cb(new SelfSchedule(timer));
+    cb->self = cb;
+
+    timer.scheduleAfterDelay(cb, 0.0);
+    testOk(cb->done.wait(5.0), "re-scheduled from callback()");
+    cb->self.reset();
+    {
+        epicsGuard<Mutex> G(cb->mutex);
+        testOk(cb->count==10u && cb->maxActive==1u,
+               "callback ran %u times, without overlap (%u)", cb->count, cb->maxActive);
+    }
+    testOk1(!timer.isScheduled(cb));
+}
+
+static void testCancelReady()
+{
+    testDiag("testCancelReady");
+
+    Timer timer("timer", middlePriority, 1u);
+
+    Marker::shared_pointer marker(new Marker);
+    MyCallbackPtr callbackOne(new MyCallback("one"));
+
+    timer.scheduleAfterDelay(marker, 0.0);
+    marker->wait.wait();
+    // the only worker is blocked
+
+    timer.scheduleAfterDelay(callbackOne, 0.0);
+    // wait for callbackOne to expire, and wait for a worker
+    while(timer.isScheduled(callbackOne))
+        epicsThreadSleep(0.01);
+
+    testOk1(timer.cancel(callbackOne));
+
+    marker->hold.signal();
+    testOk(!callbackOne->wait.wait(0.5), "cancelled callback does not run");
+    {
+        epicsGuard<Mutex> G(MyCallback::gbl_mutex);
+        testOk1(callbackOne->counter==0u);
+    }
+
+    timer.scheduleAfterDelay(callbackOne, 0.0);
+    testOk(callbackOne->wait.wait(5.0), "runs when scheduled again");
+}
+
 MAIN(testTimer)
 {
-    testPlan(315);
+    testPlan(331);
     try {
         testDiag("Tests timer");
 
@@ -234,6 +477,11 @@ MAIN(testTimer)
         testBasic(0, 2, 1);
         testCancel(0, 2, 1, 0, 1);
 
+        testMany();
+        testWorkers();
+        testCancelReady();
+        testReschedule();
+
     }catch(std::exception& e) {
         testFail("Unhandled exception: %s", e.what());
     }
@@ -9,6 +9,7 @@
 #include <algorithm>
 #include <limits>
 #include <typeinfo>
+#include <vector>
 #include <stddef.h>
 #include <stdlib.h>
 #include <stddef.h>
@@ -16,6 +17,8 @@
 #include <stdio.h>
 #include <float.h>
 #include <epicsMath.h>
+#include <epicsStdio.h>
+#include <dbDefs.h>
 
 #include <epicsUnitTest.h>
 #include <testMain.h>
@@ -106,6 +109,31 @@ namespace {
     };
 
 
+    // compare castUnsafeV() with castUnsafe<>() of each element.
+    // source values chosen to be in range of the destination type
+    template<typename TO, typename FROM>
+    struct testvector {
+        static void op(epics::pvData::ScalarType to, epics::pvData::ScalarType from,
+                       size_t count, double span, double offset)
+        {
+            std::vector<FROM> inp(count);
+            std::vector<TO> actual(count);
+            for(size_t i=0; i<count; i++)
+                inp[i] = FROM(((i*7919u)%count)*span/count + offset);
+
+            epics::pvData::castUnsafeV(count, to, &actual[0], from, &inp[0]);
+
+            size_t i=0;
+            for(; i<count; i++) {
+                TO expect(::epics::pvData::castUnsafe<TO,FROM>(inp[i]));
+                if(memcmp(&expect, &actual[i], sizeof(TO))!=0)
+                    break;
+            }
+            testOk(i==count, "vcast %zu elements %s -> %s, first %zu match",
+                   count, typeid(FROM).name(), typeid(TO).name(), i);
+        }
+    };
+
 // Test cast
 #define TEST(TTO, VTO, TFRO, VFRO) testcase<TTO, TFRO>::op(VTO, VFRO)
 
@@ -119,7 +147,7 @@ namespace {
 
 MAIN(testTypeCast)
 {
-    testPlan(124);
+    testPlan(160);
 
 try {
 
@@ -414,6 +442,78 @@ try {
     FAIL(epics::pvData::boolean, string, "T");
     FAIL(epics::pvData::boolean, string, "F");
 
+    testDiag("Number formats");
+
+    TEST(string, "0", double, 0.0);
+    TEST(string, "-0", double, -0.0);
+    TEST(string, "123456", double, 123456.0);
+    TEST(string, "1.23457e+06", double, 1234567.0);
+    TEST(string, "1e+06", double, 999999.5);
+    TEST(string, "0.0001", double, 0.0001);
+    TEST(string, "1.5e-07", double, 1.5e-7);
+    TEST(string, "-2.5", float, -2.5f);
+    TEST(string, "-9223372036854775808", int64_t, std::numeric_limits<int64_t>::min());
+
+    TEST(int32_t, 42, string, " 42 ");
+    TEST(int8_t, -128, string, "-128");
+    TEST(uint16_t, 65535, string, "+65535");
+    TEST(double, 0.5, string, " +.5 ");
+    TEST(double, -250.0, string, "\t-2.5e+2\n");
+    TEST(double, 1.0, string, "1.");
+    TEST(float, 0.1f, string, "0.1");
+
+    FAIL(uint8_t, string, "256");
+    FAIL(int32_t, string, "1 2");
+    FAIL(int32_t, string, "--1");
+    FAIL(double, string, ".");
+    FAIL(double, string, "1e");
+    FAIL(float, string, "1e39");
+
+    {
+        testDiag("Compare with std::ostream");
+        const double dvals[] = {0.0, -0.0, 1.0, -1.0, 0.5, 1.1, 2.5, 100.0, 1e5, 123456.0,
+                                999999.0, 999999.4, 999999.5, 1234567.0, 1e6, 0.0001, 0.00012345678,
+                                0.000099999999, 1e-5, 1.1e-100, 1.1e100, -1.5e-7, 3.14159265358979,
+                                1e21, 12345.678, 0.1+0.2, DBL_MAX, DBL_MIN, 4.9e-324,
+                                epicsINF, -epicsINF, epicsNAN};
+        size_t nfail = 0u;
+        for(size_t i=0; i<NELEMENTS(dvals); i++) {
+            std::ostringstream dstrm, fstrm;
+            dstrm<<dvals[i];
+            fstrm<<float(dvals[i]);
+            string dactual(epics::pvData::castUnsafe<string>(dvals[i])),
+                   factual(epics::pvData::castUnsafe<string>(float(dvals[i])));
+            if(dactual!=dstrm.str() || factual!=fstrm.str()) {
+                testDiag("%s != %s or %s != %s", dactual.c_str(), dstrm.str().c_str(),
+                         factual.c_str(), fstrm.str().c_str());
+                nfail++;
+            }
+        }
+        testOk(nfail==0u, "Print floating point as std::ostream");
+    }
+
+    {
+        testDiag("Compare with strtod()");
+        size_t nfail = 0u;
+        unsigned seed = 1u;
+        for(size_t i=0; i<10000u; i++) {
+            char buf[64];
+            seed = seed*1103515245u + 12345u;
+            unsigned a = seed>>8;
+            seed = seed*1103515245u + 12345u;
+            unsigned b = seed>>8;
+            int e = int(seed%45u) - 22;
+            epicsSnprintf(buf, sizeof(buf), "%s%u.%ue%d", (a&1u) ? "-" : "", a%100000u, b, e);
+
+            double expect = strtod(buf, NULL), actual = epics::pvData::castUnsafe<double>(string(buf));
+            if(memcmp(&expect, &actual, sizeof(expect))!=0) {
+                testDiag("%s -> %.17g != %.17g", buf, actual, expect);
+                nfail++;
+            }
+        }
+        testOk(nfail==0u, "Parse floating point as strtod()");
+    }
+
     testDiag("Floating point overflows");
 
     TEST(float, FLT_MAX, double, 1e300);
@@ -438,6 +538,60 @@ try {
         testOk1(result[2]=="42424242");
     }
 
+    {
+        const string in[3] = { "1", "x", "3" };
+
+        testDiag("Test vcast string -> int32 error");
+        try {
+            int32_t out[3];
+            epics::pvData::castUnsafeV(3, epics::pvData::pvInt, (void*)out,
+                                       epics::pvData::pvString, (void*)in);
+            testFail("Missing expected exception");
+        }catch(std::runtime_error& e){
+            testOk(strstr(e.what(), "index 1")!=NULL, "Error: %s", e.what());
+        }
+    }
+
+    {
+        using namespace epics::pvData;
+        // large enough to be split between threads, with a remainder
+        const size_t N = (1u<<20) + 13u;
+
+        testDiag("Test vcast of numeric arrays");
+        testvector<double, int16_t>::op(pvDouble, pvShort, N, 65535.0, -32768.0);
+        testvector<int16_t, double>::op(pvShort, pvDouble, N, 32000.0, -16000.0);
+        testvector<float, int32_t>::op(pvFloat, pvInt, N, 4e9, -2e9);
+        testvector<double, float>::op(pvDouble, pvFloat, N, 2000.0, -1000.0);
+        testvector<float, double>::op(pvFloat, pvDouble, N, 2e300, -1e300); // includes overflows
+        testvector<int32_t, uint8_t>::op(pvInt, pvUByte, N, 255.0, 0.0);
+        testvector<double, int64_t>::op(pvDouble, pvLong, N, 2e17, -1e17);
+        testvector<uint16_t, uint32_t>::op(pvUShort, pvUInt, N, 4e9, 0.0);
+        testvector<uint64_t, int8_t>::op(pvULong, pvByte, N, 255.0, -128.0);
+        testvector<int32_t, double>::op(pvInt, pvDouble, 17u, 8.0, -4.0);
+
+        testDiag("Test vcast double -> float with special values");
+        double din[130];
+        float fout[130];
+        for(size_t i=0; i<130u; i++)
+            din[i] = i*0.5 - 20.0; // includes 0.0
+        din[3] = -0.0;
+        din[100] = -0.0;
+        din[5] = 1e-300;
+        din[6] = -1e300;
+        din[7] = epicsINF;
+        din[8] = -epicsINF;
+        din[9] = epicsNAN;
+        din[10] = FLT_MAX;
+        castUnsafeV(130u, pvFloat, fout, pvDouble, din);
+        size_t i=0;
+        for(; i<130u; i++) {
+            float expect = castUnsafe<float>(din[i]);
+            if(memcmp(&expect, &fout[i], sizeof(expect))!=0)
+                break;
+        }
+        testOk(i==130u, "vcast double -> float special values, first %zu match", i);
+    }
+
 } catch(std::exception& e) {
     testAbort("Uncaught exception: %s", e.what());
 }
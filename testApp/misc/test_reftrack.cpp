@@ -4,12 +4,14 @@
  */
 
 #include <stdexcept>
+#include <vector>
 
 #include <epicsUnitTest.h>
 #include <testMain.h>
 
 #include <pv/epicsException.h>
 #include <pv/reftrack.h>
+#include <pv/thread.h>
 
 namespace {
 
@@ -86,14 +88,56 @@ void testSnap()
     testOk1(delta13["cnt3"]==epics::RefSnapshot::Count(23, 23));
 }
 
+epics::RefCounter shardcnt;
+
+void shardWork(void *)
+{
+    for(size_t i=0; i<1000u; i++)
+        REFTRACE_INCREMENT(shardcnt);
+    for(size_t i=0; i<500u; i++)
+        REFTRACE_DECREMENT(shardcnt);
+}
+
+void testSharded()
+{
+    testDiag("testSharded()");
+
+    epics::registerRefCounter("shardcnt", &shardcnt);
+
+    epics::RefSnapshot snap1;
+    snap1.update();
+
+    {
+        std::vector<epics::pvData::Thread*> threads(4u);
+        for(size_t i=0; i<threads.size(); i++)
+            threads[i] = new epics::pvData::Thread(epics::pvData::Thread::Config(&shardWork, 0)
+                                                   <<"shard"<<i);
+        for(size_t i=0; i<threads.size(); i++)
+            delete threads[i]; // joins
+    }
+    // decrement in a different thread than increment
+    REFTRACE_DECREMENT(shardcnt);
+
+    testOk(epics::readRefCounter("shardcnt")==1999u, "readRefCounter() %zu == 1999",
+           epics::readRefCounter("shardcnt"));
+
+    epics::RefSnapshot snap2;
+    snap2.update();
+    testOk1((snap2-snap1)["shardcnt"]==epics::RefSnapshot::Count(1999, 1999));
+
+    epics::unregisterRefCounter("shardcnt", &shardcnt);
+    testOk1(epics::readRefCounter("shardcnt")==0);
+}
+
 } // namespace
 
 MAIN(test_reftrack)
 {
-    testPlan(18);
+    testPlan(21);
     try {
         testReg();
         testSnap();
+        testSharded();
     }catch(std::exception& e){
         PRINT_EXCEPTION(e);
         testAbort("Unexpected exception: %s", e.what());
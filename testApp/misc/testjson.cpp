@@ -3,6 +3,10 @@
  * found in the file LICENSE that is included with the distribution
  */
 
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
 #include <testMain.h>
 
 #include <pv/pvdVersion.h>
@@ -271,11 +275,224 @@ void testroundtrip()
                       "}");
 }
 
+void testbuffer()
+{
+    testDiag("testbuffer()");
+
+    {
+        const char text[] = "{\"hello\":42, \"one\":{\"two\":\"test\"}} trailing junk not passed";
+
+        pvd::PVStructurePtr val(pvd::parseJSON(text, 34));
+
+        testFieldEqual<pvd::PVLong>(val, "hello", 42);
+        testFieldEqual<pvd::PVString>(val, "one.two", "test");
+    }
+
+    {
+        pvd::PVStructurePtr val(pvd::getPVDataCreate()->createPVStructure(bigtype));
+        pvd::BitSet assigned;
+
+        pvd::parseJSON(bigtest, sizeof(bigtest)-1, *val, &assigned);
+
+        testFieldEqual<pvd::PVInt>(val, "scalar", 42);
+        testFieldEqual<pvd::PVInt>(val, "sub.x.y", 43);
+        testOk1(!assigned.get(val->getSubFieldT("extra")->getFieldOffset()));
+
+        // compare with stream parse
+        pvd::PVStructurePtr val2(pvd::getPVDataCreate()->createPVStructure(bigtype));
+        std::istringstream strm(bigtest);
+        pvd::parseJSON(strm, val2);
+
+        testEqual(*val, *val2);
+    }
+
+    testThrows(std::runtime_error, pvd::parseJSON("{} x", 4));
+    testThrows(std::runtime_error, pvd::parseJSON("{\"a\":", 5));
+    {
+        pvd::PVIntPtr fld(pvd::getPVDataCreate()->createPVScalar<pvd::PVInt>());
+        testThrows(std::runtime_error, pvd::parseJSON("\n\n[1, 2", 8, *fld));
+    }
+}
+
+void testmappedfile()
+{
+    testDiag("testmappedfile()");
+
+    const char fname[] = "testjson.tmp";
+    {
+        std::ofstream out(fname);
+        out<<bigtest;
+    }
+
+    {
+        pvd::JSONMappedFile file(fname);
+        testEqual(file.size(), sizeof(bigtest)-1);
+        testDiag("mapped %c", file.mapped() ? 'Y' : 'N');
+
+        pvd::PVStructurePtr val(pvd::getPVDataCreate()->createPVStructure(bigtype));
+        pvd::parseJSON(file, *val);
+
+        testFieldEqual<pvd::PVInt>(val, "scalar", 42);
+        testFieldEqual<pvd::PVString>(val, "any", "4.2");
+    }
+
+    remove(fname);
+
+    testThrows(std::runtime_error, pvd::JSONMappedFile file("testjson.does.not.exist"));
+}
+
+void testcompiled()
+{
+    testDiag("testcompiled()");
+
+    pvd::JSONStructureParser parser(bigtype);
+
+    pvd::PVStructurePtr expect(pvd::getPVDataCreate()->createPVStructure(bigtype));
+    pvd::BitSet expectAssigned;
+    {
+        std::istringstream strm(bigtest);
+        pvd::parseJSON(strm, *expect, &expectAssigned);
+    }
+
+    pvd::PVStructurePtr val(pvd::getPVDataCreate()->createPVStructure(bigtype));
+    pvd::BitSet assigned;
+    {
+        std::istringstream strm(bigtest);
+        parser.parse(strm, *val, &assigned);
+    }
+
+    testEqual(*val, *expect);
+    testEqual(assigned, expectAssigned);
+
+    testDiag("parse again.  Arrays are replaced, not appended");
+    assigned.clear();
+    parser.parse(bigtest, strlen(bigtest), *val, &assigned);
+
+    testEqual(*val, *expect);
+    testEqual(assigned, expectAssigned);
+
+    assigned.clear();
+    {
+        const char msg[] = "{\"ivec\":[4], \"sarr\":[], \"sub\":{\"x\":{\"y\":-1}}}";
+        parser.parse(msg, strlen(msg), *val, &assigned);
+    }
+    {
+        pvd::PVLongArray::svector ivec(1, 4);
+        testFieldEqual<pvd::PVLongArray>(val, "ivec", pvd::freeze(ivec));
+    }
+    testEqual(val->getSubFieldT<pvd::PVStructureArray>("sarr")->getLength(), 0u);
+    testFieldEqual<pvd::PVInt>(val, "sub.x.y", -1);
+    testFieldEqual<pvd::PVInt>(val, "scalar", 42);
+    testEqual(assigned, pvd::BitSet()
+              .set(val->getSubField("ivec")->getFieldOffset())
+              .set(val->getSubField("sub.x.y")->getFieldOffset())
+              .set(val->getSubField("sarr")->getFieldOffset()));
+
+    testDiag("fields of structure array elements are not marked as assigned");
+    {
+        pvd::StructureConstPtr type(pvd::getFieldCreate()->createFieldBuilder()
+                                    ->add("w", pvd::pvInt)
+                                    ->add("x", pvd::pvInt)
+                                    ->addNestedStructureArray("arr")
+                                        ->add("y", pvd::pvInt)
+                                        ->addArray("v", pvd::pvDouble)
+                                        ->addNestedStructure("s")
+                                            ->add("z", pvd::pvInt)
+                                        ->endNested()
+                                    ->endNested()
+                                    ->add("after", pvd::pvInt)
+                                    ->createStructure());
+        const char msg[] = "{\"arr\":[{\"y\":5, \"v\":[1.5], \"s\":{\"z\":1}}]}";
+
+        pvd::PVStructurePtr generic(type->build()), compiled(type->build());
+        pvd::BitSet genericAssigned, compiledAssigned;
+        pvd::parseJSON(msg, strlen(msg), *generic, &genericAssigned);
+        pvd::JSONStructureParser(type).parse(msg, strlen(msg), *compiled, &compiledAssigned);
+
+        testEqual(*compiled, *generic);
+        testEqual(compiledAssigned, genericAssigned);
+        testEqual(compiledAssigned, pvd::BitSet().set(compiled->getSubField("arr")->getFieldOffset()));
+    }
+
+    testThrows(std::runtime_error, parser.parse("{\"nosuch\":1}", 13, *val));
+    testThrows(std::runtime_error, parser.parse("{\"sub\":{\"y\":1}}", 16, *val));
+    testThrows(std::runtime_error, parser.parse("{\"scalar\":null}", 15, *val));
+    testThrows(std::runtime_error, parser.parse("{\"scalar\":[1]}", 14, *val));
+
+    pvd::PVStructurePtr other(pvd::getPVDataCreate()->createPVStructure(
+                                  pvd::getFieldCreate()->createFieldBuilder()
+                                  ->add("scalar", pvd::pvInt)
+                                  ->createStructure()));
+    testThrows(std::invalid_argument, parser.parse("{}", 2, *other));
+}
+
+void testndjson()
+{
+    testDiag("testndjson()");
+
+    pvd::PVStructurePtr val(pvd::getPVDataCreate()->createPVStructure(bigtype));
+    {
+        std::istringstream strm(bigtest);
+        pvd::parseJSON(strm, *val);
+    }
+
+    pvd::BitSet delta;
+    delta.set(val->getSubField("sub.x.y")->getFieldOffset())
+         .set(val->getSubField("ivec")->getFieldOffset());
+
+    std::ostringstream out;
+    {
+        pvd::NDJSONWriter writer(out);
+        writer.write(*val);
+        val->getSubFieldT<pvd::PVInt>("sub.x.y")->put(44);
+        writer.write(*val, delta);
+        writer.write(*val, pvd::BitSet());
+        testEqual(writer.count(), 3u);
+    }
+
+    testEqual(out.str().substr(out.str().find('\n')+1u),
+              "{\"ivec\":[1,2,3],\"sub\":{\"x\":{\"y\":44}}}\n"
+              "{}\n");
+
+    std::istringstream in(out.str()+"\n  \n{\"scalar\":5}\n{\"scalar\":}\n{\"scalar\":6}");
+    pvd::NDJSONReader reader(in, bigtype);
+
+    pvd::PVStructurePtr copy(pvd::getPVDataCreate()->createPVStructure(bigtype));
+    pvd::BitSet assigned;
+
+    testOk1(reader.next(*copy, &assigned));
+    testEqual(reader.lineNumber(), 1u);
+    val->getSubFieldT<pvd::PVInt>("sub.x.y")->put(43);
+    testEqual(*copy, *val);
+    testOk1(assigned.get(val->getSubField("any")->getFieldOffset()));
+
+    testOk1(reader.next(*copy, &assigned));
+    testEqual(assigned, pvd::BitSet()
+              .set(val->getSubField("ivec")->getFieldOffset())
+              .set(val->getSubField("sub.x.y")->getFieldOffset()));
+    testFieldEqual<pvd::PVInt>(copy, "sub.x.y", 44);
+
+    testOk1(reader.next(*copy, &assigned));
+    testOk1(assigned.isEmpty());
+
+    testDiag("blank lines skipped");
+    testOk1(reader.next(*copy, &assigned));
+    testEqual(reader.lineNumber(), 6u);
+    testFieldEqual<pvd::PVInt>(copy, "scalar", 5);
+
+    testThrows(std::runtime_error, reader.next(*copy, &assigned));
+    testEqual(reader.lineNumber(), 7u);
+
+    testOk1(reader.next(*copy, &assigned));
+    testFieldEqual<pvd::PVInt>(copy, "scalar", 6);
+    testOk1(!reader.next(*copy, &assigned));
+}
+
 } // namespace
 
 MAIN(testjson)
 {
-    testPlan(29);
+    testPlan(78);
     try {
         testparseany();
         testparseanyarray();
@@ -283,6 +500,10 @@ MAIN(testjson)
         testparseanyjunk();
         testInto();
         testroundtrip();
+        testbuffer();
+        testmappedfile();
+        testcompiled();
+        testndjson();
     }catch(std::exception& e){
         testAbort("Unexpected exception: %s", e.what());
     }
@@ -0,0 +1,144 @@
+// Cost to a writer of publishing updates of a record while reader threads take consistent copies,
+// with SnapshotPublisher, and with a lock shared by the writer and readers.
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <math.h>
+
+#include <vector>
+
+#include <testMain.h>
+#include <epicsUnitTest.h>
+#include <epicsThread.h>
+#include <epicsAtomic.h>
+#include <dbDefs.h>
+
+#include <pv/current_function.h>
+#include <pv/pvData.h>
+#include <pv/standardField.h>
+#include <pv/snapshotPublisher.h>
+#include <pv/thread.h>
+#include <pv/lock.h>
+
+namespace {
+
+namespace pvd = epics::pvData;
+
+struct TimeIt {
+    struct timespec m_start;
+    double sum, sum2;
+    size_t count;
+    TimeIt() { reset(); }
+    void reset() {
+        sum = sum2 = 0.0;
+        count = 0;
+    }
+    void start() {
+        clock_gettime(CLOCK_MONOTONIC, &m_start);
+    }
+    void end() {
+        struct timespec end;
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double diff = (end.tv_sec-m_start.tv_sec) + (end.tv_nsec-m_start.tv_nsec)*1e-9;
+        sum += diff;
+        sum2 += diff*diff;
+        count++;
+    }
+    void report(const char *unit ="s", double mult=1.0) const {
+        double mean = sum/count;
+        double mean2 = sum2/count;
+        double std = sqrt(mean2 - mean*mean);
+        printf("# %zu sample   %f +- %f %s\n", count, mean/mult, std/mult, unit);
+    }
+};
+
+const size_t nsamples = 10;
+const size_t nupdate = 10000;
+
+struct Shared {
+    pvd::StructureConstPtr type;
+    pvd::PVStructurePtr record;
+    pvd::SnapshotPublisher pub;
+    pvd::Mutex lock; // guards record when !usePublisher
+    bool usePublisher;
+    int done;
+    size_t reads;
+    Shared(const pvd::StructureConstPtr& type, bool usePublisher)
+        :type(type), record(type->build()), pub(type), usePublisher(usePublisher), done(0), reads(0u)
+    {}
+};
+
+void reader(void *raw)
+{
+    Shared *S = static_cast<Shared*>(raw);
+    pvd::PVStructurePtr mine(S->type->build());
+    pvd::BitSet changed;
+    size_t seq = pvd::SnapshotPublisher::initial;
+
+    while(!epics::atomic::get(S->done)) {
+        if(S->usePublisher) {
+            S->pub.read(*mine, seq, &changed);
+        } else {
+            pvd::Lock G(S->lock);
+            mine->copyUnchecked(*S->record);
+        }
+        epics::atomic::increment(S->reads);
+    }
+}
+
+void publish(size_t nreaders, bool usePublisher)
+{
+    testDiag("%s %zu readers, %s", CURRENT_FUNCTION, nreaders, usePublisher ? "SnapshotPublisher" : "Mutex");
+
+    pvd::StructureConstPtr type(pvd::getStandardField()->scalar(pvd::pvDouble, "alarm,timeStamp,display,control"));
+    Shared S(type, usePublisher);
+
+    pvd::PVDoublePtr value(S.record->getSubFieldT<pvd::PVDouble>("value"));
+    pvd::PVLongPtr sec(S.record->getSubFieldT<pvd::PVLong>("timeStamp.secondsPastEpoch"));
+    pvd::BitSet changed;
+    changed.set(value->getFieldOffset()).set(sec->getFieldOffset());
+
+    std::vector<pvd::ThreadPtr> threads;
+    for(size_t i=0; i<nreaders; i++) {
+        pvd::Thread::Config conf(&reader, &S);
+        conf.prio(epicsThreadPriorityMedium)
+            .autostart(true);
+        threads.push_back(pvd::ThreadPtr(new pvd::Thread(conf<<"reader"<<i)));
+    }
+
+    TimeIt tpublish;
+    for(size_t n=0; n<nsamples; n++) {
+        tpublish.start();
+        for(size_t i=0; i<nupdate; i++) {
+            if(usePublisher) {
+                value->put(i);
+                sec->put(i);
+                S.pub.publish(*S.record, changed);
+            } else {
+                pvd::Lock G(S.lock);
+                value->put(i);
+                sec->put(i);
+            }
+        }
+        tpublish.end();
+    }
+    epics::atomic::set(S.done, 1);
+
+    for(size_t i=0; i<threads.size(); i++)
+        threads[i]->exitWait();
+
+    testDiag("writer, per update.  %zu reads", S.reads);
+    tpublish.report("us", 1e-6*nupdate);
+}
+
+} // namespace
+
+MAIN(performSnapshot) {
+    testPlan(0);
+    const size_t nreaders[] = {0u, 1u, 2u, 4u, 8u};
+    for(size_t i=0; i<NELEMENTS(nreaders); i++) {
+        publish(nreaders[i], false);
+        publish(nreaders[i], true);
+    }
+    return testDone();
+}
@@ -1,9 +1,12 @@
-// Attempt to qualtify the effects of de-duplication on the time need to allocate a PVStructure
+// Attempt to qualtify the effects of de-duplication on the time need to allocate a PVStructure,
+// and the time and memory needed to build many PVStructures of one type.
 #include <stdlib.h>
 #include <stdio.h>
 #include <time.h>
 #include <math.h>
 
+#include <vector>
+
 #include <testMain.h>
 #include <epicsUnitTest.h>
 #include <epicsStdio.h>
@@ -11,11 +14,14 @@
 #include <pv/current_function.h>
 #include <pv/pvData.h>
 #include <pv/standardField.h>
+#include <pv/bitSet.h>
 
 namespace {
 
 namespace pvd = epics::pvData;
 
+const size_t nsamples = 10;
+
 struct TimeIt {
     struct timespec m_start;
     double sum, sum2;
@@ -106,11 +112,110 @@ void buildHit()
     record.report("us", 1e-6);
 }
 
+// A record of about 30 fields, as served by an IOC.
+pvd::StructureConstPtr recordType()
+{
+    pvd::StandardFieldPtr standard(pvd::getStandardField());
+    return pvd::getFieldCreate()->createFieldBuilder()
+            ->setId("epics:nt/NTScalar:1.0")
+            ->add("value", pvd::pvDouble)
+            ->add("alarm", standard->alarm())
+            ->add("timeStamp", standard->timeStamp())
+            ->add("display", standard->display())
+            ->add("control", standard->control())
+            ->add("valueAlarm", standard->doubleAlarm())
+            ->createStructure();
+}
+
+void buildRecords()
+{
+    const size_t nrecords = 20000u;
+    testDiag("%s %zu records", CURRENT_FUNCTION, nrecords);
+
+    pvd::StructureConstPtr type(recordType());
+    std::vector<pvd::PVStructurePtr> records(nrecords);
+    TimeIt tbuild, tdestroy;
+
+    for(size_t n=0; n<5; n++) {
+        tbuild.start();
+        for(size_t i=0; i<nrecords; i++)
+            records[i] = type->build();
+        tbuild.end();
+
+        tdestroy.start();
+        for(size_t i=0; i<nrecords; i++)
+            records[i].reset();
+        tdestroy.end();
+    }
+
+    pvd::PVStructurePtr one(type->build());
+    pvd::MemoryUsage usage(one->memoryUsage());
+
+    // What a std::string copy of each name would add
+    size_t copies = 0u;
+    {
+        const size_t inplace = std::string().capacity();
+        for(size_t i=1, N=one->getNumberFields(); i<N; i++) {
+            const std::string& name = one->getSubFieldT(i)->getFieldName();
+            copies += sizeof(std::string) + (name.capacity()>inplace ? name.capacity()+1u : 0u);
+        }
+    }
+
+    testDiag("%zu fields per record, %zu bytes, %zu bytes would be copies of field names",
+             usage.fields, usage.total(), copies);
+    testDiag("build()");
+    tbuild.report("us", 1e-6*nrecords);
+    testDiag("destroy");
+    tdestroy.report("us", 1e-6*nrecords);
+}
+
+// Bring a snapshot of a large structure up to date after a few fields change,
+// as for a monitor queue, compared with taking a full copy.
+void snapshotSparse()
+{
+    const size_t nfields = 10000u, nchanged = 3u, nupdate = 1000u;
+    testDiag("%s %zu fields, %zu changed", CURRENT_FUNCTION, nfields, nchanged);
+
+    pvd::FieldBuilderPtr builder(pvd::getFieldCreate()->createFieldBuilder());
+    for(size_t i=0; i<nfields; i++) {
+        char buf[16];
+        epicsSnprintf(buf, sizeof(buf), "f%lu", (unsigned long) i);
+        builder->add(buf, pvd::pvDouble);
+    }
+    pvd::StructureConstPtr type(builder->createStructure());
+
+    pvd::PVStructurePtr record(type->build()), snapshot(type->build());
+    pvd::BitSet changed;
+    for(size_t i=0; i<nchanged; i++)
+        changed.set(1u + (i+1u)*nfields/(nchanged+1u));
+
+    TimeIt tfull, tsparse;
+
+    for(size_t n=0; n<nsamples; n++) {
+        tfull.start();
+        for(size_t i=0; i<nupdate/100u; i++)
+            snapshot->copyUnchecked(*record);
+        tfull.end();
+
+        tsparse.start();
+        for(size_t i=0; i<nupdate; i++)
+            snapshot->copyUnchecked(*record, changed);
+        tsparse.end();
+    }
+
+    testDiag("full copy");
+    tfull.report("us", 1e-6*(nupdate/100u));
+    testDiag("changed fields only");
+    tsparse.report("us", 1e-6*nupdate);
+}
+
 } // namespace
 
 MAIN(performStruct) {
     testPlan(0);
     buildMiss();
     buildHit();
+    buildRecords();
+    snapshotSparse();
     return testDone();
 }
@@ -0,0 +1,104 @@
+// Cost of decoding a variant union whose value has the same type in each update,
+// as for a monitor of a field whose type is not known in advance.
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <math.h>
+
+#include <testMain.h>
+#include <epicsUnitTest.h>
+
+#include <pv/current_function.h>
+#include <pv/pvData.h>
+#include <pv/standardField.h>
+#include <pv/serialize.h>
+#include <pv/byteBuffer.h>
+
+namespace {
+
+namespace pvd = epics::pvData;
+
+struct TimeIt {
+    struct timespec m_start;
+    double sum, sum2;
+    size_t count;
+    TimeIt() { reset(); }
+    void reset() {
+        sum = sum2 = 0.0;
+        count = 0;
+    }
+    void start() {
+        clock_gettime(CLOCK_MONOTONIC, &m_start);
+    }
+    void end() {
+        struct timespec end;
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double diff = (end.tv_sec-m_start.tv_sec) + (end.tv_nsec-m_start.tv_nsec)*1e-9;
+        sum += diff;
+        sum2 += diff*diff;
+        count++;
+    }
+    void report(const char *unit ="s", double mult=1.0) const {
+        double mean = sum/count;
+        double mean2 = sum2/count;
+        double std = sqrt(mean2 - mean*mean);
+        printf("# %zu sample   %f +- %f %s\n", count, mean/mult, std/mult, unit);
+    }
+};
+
+const size_t nsamples = 20;
+const size_t ndecode = 10000;
+
+// Types are sent in full with each value.  Decoded through FieldCreate.
+struct FullControl : public pvd::SerializableControl, public pvd::DeserializableControl {
+    virtual void flushSerializeBuffer() {}
+    virtual void ensureBuffer(size_t) {}
+    virtual bool directSerialize(pvd::ByteBuffer*, const char*, size_t, size_t) { return false; }
+    virtual void cachedSerialize(std::tr1::shared_ptr<const pvd::Field> const & field, pvd::ByteBuffer* buffer) {
+        field->serialize(buffer, this);
+    }
+    virtual void ensureData(size_t) {}
+    virtual bool directDeserialize(pvd::ByteBuffer*, char*, size_t, size_t) { return false; }
+    virtual std::tr1::shared_ptr<const pvd::Field> cachedDeserialize(pvd::ByteBuffer* buffer) {
+        return pvd::getFieldCreate()->deserialize(buffer, this);
+    }
+};
+
+void variantDecode(const pvd::FieldConstPtr& type, const char *name)
+{
+    testDiag("%s %s", CURRENT_FUNCTION, name);
+
+    FullControl control;
+    pvd::ByteBuffer buf(16u*1024u);
+    {
+        pvd::PVUnionPtr src(pvd::getPVDataCreate()->createPVVariantUnion());
+        src->set(pvd::getPVDataCreate()->createPVField(type));
+        src->serialize(&buf, &control);
+        buf.flip();
+    }
+
+    pvd::PVUnionPtr dest(pvd::getPVDataCreate()->createPVVariantUnion());
+    TimeIt tdecode;
+
+    for(size_t n=0; n<nsamples; n++) {
+        tdecode.start();
+        for(size_t i=0; i<ndecode; i++) {
+            buf.setPosition(0);
+            dest->deserialize(&buf, &control);
+        }
+        tdecode.end();
+    }
+
+    tdecode.report("us", 1e-6*ndecode);
+}
+
+} // namespace
+
+MAIN(performUnion) {
+    testPlan(0);
+    pvd::StandardFieldPtr standard(pvd::getStandardField());
+    variantDecode(pvd::getFieldCreate()->createScalar(pvd::pvDouble), "double");
+    variantDecode(standard->scalar(pvd::pvDouble, "alarm,timeStamp"), "NTScalar");
+    variantDecode(standard->scalar(pvd::pvDouble, "alarm,timeStamp,display,control,valueAlarm"), "NTScalar all properties");
+    return testDone();
+}
@@ -406,9 +406,93 @@ static void testMapping()
 
 }
 
+static void testInterned()
+{
+    testDiag("testInterned");
+
+    StructureConstPtr A(fieldCreate->createFieldBuilder()
+                        ->setId("foo_t")
+                        ->add("a", pvInt)
+                        ->add("b", pvDouble)
+                        ->createStructure()),
+                      B(fieldCreate->createFieldBuilder()
+                        ->add("b", pvString)
+                        ->createStructure());
+
+    testOk1(A->getInternedID()==InternedString("foo_t"));
+    testOk1(A->getInternedFieldNames().size()==2u);
+    testOk1(A->getInternedFieldNames()[1]==B->getInternedFieldNames()[0]);
+    testOk1(&A->getInternedFieldNames()[1].str()==&B->getInternedFieldNames()[0].str());
+    testOk1(A->getFieldIndex(InternedString("b"))==1u);
+    testOk1(A->getFieldIndex(InternedString("c"))==size_t(-1));
+
+    UnionConstPtr U(fieldCreate->createFieldBuilder()
+                    ->add("b", pvInt)
+                    ->createUnion());
+    testOk1(U->getInternedFieldNames()[0]==B->getInternedFieldNames()[0]);
+    testOk1(U->getFieldIndex(InternedString("b"))==0u);
+}
+
+static void testCacheIdentity()
+{
+    testDiag("testCacheIdentity");
+
+    // equal types built separately are the same instance
+    StructureConstPtr A(fieldCreate->createFieldBuilder()
+                        ->add("value", pvDouble)
+                        ->addArray("arr", pvInt)
+                        ->addNestedStructureArray("sarr")
+                            ->add("x", pvInt)
+                        ->endNested()
+                        ->createStructure()),
+                      B(fieldCreate->createFieldBuilder()
+                        ->add("value", pvDouble)
+                        ->addArray("arr", pvInt)
+                        ->addNestedStructureArray("sarr")
+                            ->add("x", pvInt)
+                        ->endNested()
+                        ->createStructure()),
+                      C(fieldCreate->createFieldBuilder()
+                        ->add("value", pvDouble)
+                        ->addArray("arr", pvInt)
+                        ->addNestedStructureArray("sarr")
+                            ->add("y", pvInt)
+                        ->endNested()
+                        ->createStructure());
+    testOk1(A.get()==B.get());
+    testOk1(A.get()!=C.get());
+    testOk1(!compare(*A, *C));
+    testOk1(!compare(static_cast<const Field&>(*A), static_cast<const Field&>(*C)));
+
+    // found in the cache without constructing another instance
+    {
+        FieldCreate::CacheStats before(fieldCreate->cacheStats());
+        StructureConstPtr D(fieldCreate->createStructure(A->getFieldNames(), A->getFields()));
+        FieldCreate::CacheStats after(fieldCreate->cacheStats());
+        testOk1(D.get()==A.get());
+        testOk(after.hits==before.hits+1u && after.misses==before.misses,
+               "hits %u -> %u, misses %u -> %u",
+               unsigned(before.hits), unsigned(after.hits), unsigned(before.misses), unsigned(after.misses));
+    }
+    {
+        UnionConstPtr U(fieldCreate->createUnion(A->getFieldNames(), A->getFields())),
+                      V(fieldCreate->createUnion(A->getFieldNames(), A->getFields()));
+        testOk1(U.get()==V.get());
+        testOk1(static_cast<const Field*>(U.get())!=static_cast<const Field*>(A.get()));
+        testOk1(fieldCreate->createStructure("other_t", A->getFieldNames(), A->getFields()).get()!=A.get());
+    }
+
+    // array kind and size, and string bound, distinguish types
+    testOk1(fieldCreate->createFixedScalarArray(pvInt, 4).get()!=fieldCreate->createBoundedScalarArray(pvInt, 4).get());
+    testOk1(fieldCreate->createFixedScalarArray(pvInt, 4).get()!=fieldCreate->createFixedScalarArray(pvInt, 5).get());
+    testOk1(fieldCreate->createFixedScalarArray(pvInt, 4).get()==fieldCreate->createFixedScalarArray(pvInt, 4).get());
+    testOk1(fieldCreate->createBoundedString(4).get()!=fieldCreate->createBoundedString(5).get());
+    testOk1(fieldCreate->createBoundedString(4).get()==fieldCreate->createBoundedString(4).get());
+}
+
 MAIN(testIntrospect)
 {
-    testPlan(358);
+    testPlan(380);
     fieldCreate = getFieldCreate();
     pvDataCreate = getPVDataCreate();
     standardField = getStandardField();
@@ -419,5 +503,7 @@ MAIN(testIntrospect)
     testBoundedString();
     testError();
     testMapping();
+    testInterned();
+    testCacheIdentity();
     return testDone();
 }
@@ -10,6 +10,10 @@
 #include <cstddef>
 #include <string>
 #include <cstdio>
+#include <sstream>
+#include <algorithm>
+
+#include <epicsMath.h>
 
 #include <pv/pvUnitTest.h>
 #include <testMain.h>
@@ -766,9 +770,367 @@ static void testSubField()
     testEqual(value->getSubField(9), PVFieldPtr());
 }
 
+static void testDiff()
+{
+    testDiag("testDiff");
+
+    StructureConstPtr type(fieldCreate->createFieldBuilder()
+                           ->add("value", pvDouble)
+                           ->add("alarm", standardField->alarm())
+                           ->addArray("array", pvDouble)
+                           ->addArray("names", pvString)
+                           ->add("any", fieldCreate->createVariantUnion())
+                           ->createStructure());
+
+    PVStructurePtr a(type->build()), b(type->build());
+    PVDoublePtr value(b->getSubFieldT<PVDouble>("value"));
+    PVDoubleArrayPtr array(b->getSubFieldT<PVDoubleArray>("array"));
+    const uint32 valueOffset = value->getFieldOffset(), arrayOffset = array->getFieldOffset();
+
+    BitSet changed;
+    testOk1(!diff(*a, *b, changed));
+    testOk1(changed.isEmpty());
+
+    value->put(1.0);
+    b->getSubFieldT<PVString>("alarm.message")->put("bad");
+    testOk1(diff(*a, *b, changed));
+    testEqual(changed, BitSet().set(valueOffset).set(b->getSubFieldT("alarm.message")->getFieldOffset()));
+
+    a->copyUnchecked(*b);
+    changed.clear();
+    {
+        PVDoubleArray::svector arr(4, 1.0);
+        array->replace(freeze(arr));
+    }
+    a->getSubFieldT<PVDoubleArray>("array")->replace(array->view());
+    testOk1(!diff(*a, *b, changed)); // shared buffer
+
+    {
+        PVDoubleArray::svector arr(4, 1.0);
+        a->getSubFieldT<PVDoubleArray>("array")->replace(freeze(arr));
+    }
+    testOk1(!diff(*a, *b, changed)); // equal contents
+
+    {
+        PVDoubleArray::svector arr(4, 1.0);
+        arr[3] = 1.05;
+        array->replace(freeze(arr));
+    }
+    testOk1(diff(*a, *b, changed));
+    testEqual(changed, BitSet().set(arrayOffset));
+
+    std::map<uint32, double> deadbands;
+    deadbands[valueOffset] = 0.1;
+    deadbands[arrayOffset] = 0.1;
+    changed.clear();
+    value->put(1.05);
+    testOk1(!diff(*a, *b, changed, &deadbands));
+    value->put(1.2);
+    testOk1(diff(*a, *b, changed, &deadbands));
+    testEqual(changed, BitSet().set(valueOffset));
+
+    // NaN is unchanged only when compared with NaN
+    a->copyUnchecked(*b);
+    value->put(epicsNAN);
+    changed.clear();
+    testOk1(diff(*a, *b, changed, &deadbands));
+    a->copyUnchecked(*b);
+    testOk1(!diff(*a, *b, changed) && !diff(*a, *b, changed, &deadbands));
+
+    b->getSubFieldT<PVUnion>("any")->set(pvDataCreate->createPVScalar(pvInt));
+    changed.clear();
+    changed.set(0);
+    testOk1(diff(*a, *b, changed));
+    testEqual(changed, BitSet().set(0).set(b->getSubFieldT("any")->getFieldOffset()));
+
+    testThrows(std::invalid_argument, diff(*a, *standardPVField->scalar(pvDouble, "alarm"), changed));
+}
+
+static void testHashValue()
+{
+    testDiag("testHashValue");
+
+    StructureConstPtr type(standardField->scalar(pvDouble, "alarm,timeStamp"));
+    PVStructurePtr a(type->build()), b(type->build());
+
+    testEqual(a->hashValue(), b->hashValue());
+    b->getSubFieldT<PVDouble>("value")->put(1.0);
+    testNotEqual(a->hashValue(), b->hashValue());
+    b->getSubFieldT<PVDouble>("value")->put(-0.0);
+    testOk1(*a==*b);
+    testEqual(a->hashValue(), b->hashValue());
+
+    // only selected fields
+    BitSet mask;
+    mask.set(b->getSubFieldT("value")->getFieldOffset())
+        .set(b->getSubFieldT("alarm")->getFieldOffset());
+    b->getSubFieldT<PVLong>("timeStamp.secondsPastEpoch")->put(1234);
+    testNotEqual(a->hashValue(), b->hashValue());
+    testEqual(a->hashValue(mask), b->hashValue(mask));
+    b->getSubFieldT<PVString>("alarm.message")->put("bad");
+    testNotEqual(a->hashValue(mask), b->hashValue(mask));
+
+    // element boundaries of strings are significant
+    PVStringArrayPtr sa(pvDataCreate->createPVScalarArray<PVStringArray>()),
+                     sb(pvDataCreate->createPVScalarArray<PVStringArray>());
+    {
+        PVStringArray::svector va(2), vb(2);
+        va[0] = "ab"; va[1] = "c";
+        vb[0] = "a"; vb[1] = "bc";
+        sa->replace(freeze(va));
+        sb->replace(freeze(vb));
+    }
+    testNotEqual(sa->hashValue(), sb->hashValue());
+
+    PVUnionPtr ua(pvDataCreate->createPVVariantUnion()), ub(pvDataCreate->createPVVariantUnion());
+    testEqual(ua->hashValue(), ub->hashValue());
+    ua->set(pvDataCreate->createPVScalar<PVInt>());
+    ub->set(pvDataCreate->createPVScalar<PVInt>());
+    testEqual(ua->hashValue(), ub->hashValue());
+    ub->get<PVInt>()->put(5);
+    testNotEqual(ua->hashValue(), ub->hashValue());
+
+    // a large buffer shared with another field has its hash cached
+    PVDoubleArrayPtr da(pvDataCreate->createPVScalarArray<PVDoubleArray>()),
+                     db(pvDataCreate->createPVScalarArray<PVDoubleArray>()),
+                     dc(pvDataCreate->createPVScalarArray<PVDoubleArray>());
+    {
+        PVDoubleArray::svector v(1000);
+        for(size_t i=0; i<v.size(); i++)
+            v[i] = i;
+        da->replace(freeze(v));
+    }
+    {
+        PVDoubleArray::svector v(da->view().size());
+        std::copy(da->view().begin(), da->view().end(), v.begin());
+        v[0] = -0.0;
+        dc->replace(freeze(v));
+    }
+    db->replace(da->view());
+    const size_t first = da->hashValue();
+    testEqual(da->hashValue(), first);
+    testEqual(db->hashValue(), first);
+    testEqual(dc->hashValue(), first);
+
+    {
+        PVDoubleArray::svector v(da->reuse());
+        v[999] = 0.5;
+        da->replace(freeze(v));
+    }
+    testNotEqual(da->hashValue(), first);
+    testEqual(db->hashValue(), first);
+
+    // the cache does not keep a buffer which is no longer referenced elsewhere
+    std::tr1::weak_ptr<const double> buf(db->view().dataPtr());
+    db->replace(PVDoubleArray::const_svector());
+    PVDoubleArray::const_svector held(dc->view());
+    testEqual(dc->hashValue(), first); // cached, so releases the unreferenced buffer
+    testOk1(buf.expired());
+}
+
+static void testSparseCopy()
+{
+    testDiag("testSparseCopy");
+
+    FieldBuilderPtr builder(fieldCreate->createFieldBuilder());
+    for(size_t i=0; i<100; i++) {
+        std::ostringstream name;
+        name<<"f"<<i;
+        builder->add(name.str(), pvDouble);
+    }
+    StructureConstPtr type(builder->add("alarm", standardField->alarm())
+                                  ->addArray("array", pvInt)
+                                  ->createStructure());
+
+    PVStructurePtr src(type->build()), dest(type->build());
+    for(size_t i=0; i<100; i++)
+        src->getSubFieldT<PVDouble>(i+1)->put(i);
+    src->getSubFieldT<PVInt>("alarm.severity")->put(2);
+    src->getSubFieldT<PVString>("alarm.message")->put("bad");
+    {
+        PVIntArray::svector arr(3, 7);
+        src->getSubFieldT<PVIntArray>("array")->replace(freeze(arr));
+    }
+
+    BitSet changed;
+    changed.set(src->getSubFieldT("f3")->getFieldOffset())
+           .set(src->getSubFieldT("f97")->getFieldOffset())
+           .set(src->getSubFieldT("alarm.severity")->getFieldOffset())
+           .set(src->getSubFieldT("array")->getFieldOffset());
+
+    dest->copyUnchecked(*src, changed);
+    testEqual(dest->getSubFieldT<PVDouble>("f3")->get(), 3.0);
+    testEqual(dest->getSubFieldT<PVDouble>("f97")->get(), 97.0);
+    testEqual(dest->getSubFieldT<PVDouble>("f4")->get(), 0.0);
+    testEqual(dest->getSubFieldT<PVInt>("alarm.severity")->get(), 2);
+    testEqual(dest->getSubFieldT<PVString>("alarm.message")->get(), "");
+    testOk1(dest->getSubFieldT<PVIntArray>("array")->view().data()==src->getSubFieldT<PVIntArray>("array")->view().data());
+
+    // with inverse, a clear bit for a structure selects all of it
+    BitSet keep(changed);
+    keep.set(0).set(src->getSubFieldT("alarm")->getFieldOffset());
+
+    PVStructurePtr rest(type->build());
+    rest->copyUnchecked(*src, keep, true);
+    testEqual(rest->getSubFieldT<PVDouble>("f3")->get(), 0.0);
+    testEqual(rest->getSubFieldT<PVDouble>("f4")->get(), 4.0);
+    testEqual(rest->getSubFieldT<PVString>("alarm.message")->get(), "bad");
+    testEqual(rest->getSubFieldT<PVInt>("alarm.severity")->get(), 0);
+
+    dest->copyUnchecked(*src, changed, true);
+    testEqual(*dest, *src);
+}
+
+namespace {
+struct CountPuts : public PostHandler {
+    POINTER_DEFINITIONS(CountPuts);
+    size_t puts;
+    CountPuts() :puts(0u) {}
+    virtual ~CountPuts() {}
+    virtual void postPut() { puts++; }
+};
+struct CountTransactions : public CountPuts {
+    POINTER_DEFINITIONS(CountTransactions);
+    size_t transactions;
+    BitSet changed;
+    CountTransactions() :transactions(0u) {}
+    virtual ~CountTransactions() {}
+    virtual void postTransaction(PVStructure& top, const BitSet& changed) {
+        transactions++;
+        this->changed = changed;
+    }
+};
+}
+
+static void testTransaction()
+{
+    testDiag("testTransaction");
+
+    PVStructurePtr pv(standardField->scalar(pvDouble, "alarm,timeStamp")->build());
+    PVDoublePtr value(pv->getSubFieldT<PVDouble>("value"));
+    PVLongPtr sec(pv->getSubFieldT<PVLong>("timeStamp.secondsPastEpoch"));
+    PVIntPtr nsec(pv->getSubFieldT<PVInt>("timeStamp.nanoseconds"));
+
+    CountPuts::shared_pointer valuePuts(new CountPuts);
+    CountTransactions::shared_pointer topPuts(new CountTransactions);
+    value->setPostHandler(valuePuts);
+    pv->setPostHandler(topPuts);
+
+    value->put(1.0);
+    testEqual(valuePuts->puts, 1u);
+
+    BitSet expect;
+    expect.set(value->getFieldOffset())
+          .set(sec->getFieldOffset())
+          .set(nsec->getFieldOffset());
+    {
+        PVStructure::Transaction T(*pv);
+        value->put(2.0);
+        value->put(3.0);
+        {
+            // joins the outer Transaction
+            PVStructure::Transaction T2(*pv->getSubFieldT<PVStructure>("timeStamp"));
+            sec->put(1234);
+            nsec->put(5678);
+        }
+        testEqual(valuePuts->puts, 1u);
+        testEqual(topPuts->transactions, 0u);
+        testEqual(T.changed(), expect);
+    }
+    // only the aggregated notification
+    testEqual(valuePuts->puts, 1u);
+    testEqual(topPuts->transactions, 1u);
+    testEqual(topPuts->changed, expect);
+    testEqual(topPuts->puts, 0u);
+
+    {
+        PVStructure::Transaction T(*pv);
+    }
+    testEqual(topPuts->transactions, 1u);
+
+    // the default postTransaction() calls the handlers of sub-fields, then postPut()
+    PVStructurePtr alarm(pv->getSubFieldT<PVStructure>("alarm"));
+    PVIntPtr severity(alarm->getSubFieldT<PVInt>("severity"));
+    CountPuts::shared_pointer alarmPuts(new CountPuts), severityPuts(new CountPuts);
+    alarm->setPostHandler(alarmPuts);
+    severity->setPostHandler(severityPuts);
+    {
+        PVStructure::Transaction T(*alarm);
+        severity->put(2);
+        severity->put(3);
+        alarm->getSubFieldT<PVString>("message")->put("bad");
+    }
+    testEqual(severityPuts->puts, 1u);
+    testEqual(alarmPuts->puts, 1u);
+    testEqual(topPuts->transactions, 1u);
+
+    // delivered when left by an exception
+    try {
+        PVStructure::Transaction T(*pv);
+        value->put(4.0);
+        throw std::runtime_error("oops");
+    } catch(std::runtime_error&) {
+    }
+    testEqual(topPuts->transactions, 2u);
+    testEqual(topPuts->changed, BitSet().set(value->getFieldOffset()));
+}
+
+static void testMemoryUsage()
+{
+    testDiag("testMemoryUsage");
+
+    FieldCreate::CacheStats before(fieldCreate->cacheStats());
+
+    PVStructurePtr value(getFieldCreate()->createFieldBuilder()
+                         ->add("value", pvDouble)
+                         ->addArray("arr", pvDouble)
+                         ->add("averyveryverylongfieldnamewhichcannotbeinline", pvInt)
+                         ->createStructure()->build());
+
+    FieldCreate::CacheStats after(fieldCreate->cacheStats());
+    testOk(after.hits+after.misses > before.hits+before.misses, "cache %zu hits %zu misses",
+           after.hits, after.misses);
+    testOk1(after.entries>0u && after.bytes>after.entries*sizeof(Field));
+
+    PVDoubleArrayPtr arr(value->getSubFieldT<PVDoubleArray>("arr"));
+    {
+        PVDoubleArray::svector temp(100u, 1.0);
+        arr->replace(freeze(temp));
+    }
+
+    MemoryUsage usage(value->memoryUsage());
+    {
+        std::ostringstream strm;
+        strm<<usage;
+        std::istringstream lines(strm.str());
+        std::string line;
+        while(std::getline(lines, line))
+            testDiag("%s", line.c_str());
+    }
+    testEqual(usage.fields, 4u);
+    testEqual(usage.exclusiveArrayBytes, 100u*sizeof(double));
+    testEqual(usage.sharedArrayBytes, 0u);
+
+    // as if queued for a monitor
+    PVDoubleArray::const_svector held(arr->view());
+
+    usage = value->memoryUsage();
+    testEqual(usage.exclusiveArrayBytes, 0u);
+    testOk1(usage.sharedArrayBytes>=100u*sizeof(double));
+    testOk1(usage.total()>usage.exclusive());
+
+    testDiag("Sub-field outlives parent, and its Structure");
+    PVIntPtr longname(value->getSubFieldT<PVInt>("averyveryverylongfieldnamewhichcannotbeinline"));
+    const std::string& name = longname->getFieldName();
+    value.reset();
+    testEqual(longname->getFieldName(), "averyveryverylongfieldnamewhichcannotbeinline");
+    // a reference taken before remains valid
+    testEqual(name, "averyveryverylongfieldnamewhichcannotbeinline");
+}
+
 MAIN(testPVData)
 {
-    testPlan(271);
+    testPlan(340);
     try{
         fieldCreate = getFieldCreate();
         pvDataCreate = getPVDataCreate();
@@ -785,6 +1147,11 @@ MAIN(testPVData)
         testFieldAccess();
         testAnyScalar();
         testSubField();
+        testSparseCopy();
+        testDiff();
+        testHashValue();
+        testTransaction();
+        testMemoryUsage();
     }catch(std::exception& e){
         PRINT_EXCEPTION(e);
         testAbort("Unhandled Exception: %s", e.what());
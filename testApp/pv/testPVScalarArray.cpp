@@ -12,6 +12,7 @@
 #include <cstdio>
 
 #include <epicsAssert.h>
+#include <epicsMath.h>
 #include <epicsExit.h>
 #include <epicsUnitTest.h>
 #include <testMain.h>
@@ -21,6 +22,8 @@
 #include <pv/convert.h>
 #include <pv/standardField.h>
 #include <pv/standardPVField.h>
+#include <pv/pvSubArrayCopy.h>
+#include <pv/arrayAllocator.h>
 
 using namespace epics::pvData;
 using std::tr1::static_pointer_cast;
@@ -196,11 +199,253 @@ static void testVoid()
     testOk1(iarr->getLength()==4);
 }
 
+static void testSetLength()
+{
+    testDiag("Check PVScalarArray::setLength() growth");
+
+    PVDoubleArrayPtr arr = getPVDataCreate()->createPVScalarArray<PVDoubleArray>();
+
+    PVDoubleArray::const_svector cdata(100000u, 1.0);
+    arr->replace(cdata);
+    testOk1(!cdata.unique());
+
+    arr->setLength(200000u);
+    testOk1(arr->getLength()==200000u);
+    testOk1(cdata.size()==100000u);
+    PVDoubleArray::const_svector grown(arr->view());
+    testOk1(grown.data()!=cdata.data());
+    testOk1(grown[99999]==1.0);
+    testOk1(grown[100000]==0.0 && grown[199999]==0.0);
+
+    arr->setLength(50000u);
+    testOk1(arr->getLength()==50000u);
+
+    testDiag("Spare capacity of re-used storage is zeroed");
+    const size_t N = 16384u; // large enough to be pooled
+    PVDoubleArrayPtr arr2 = getPVDataCreate()->createPVScalarArray<PVDoubleArray>();
+    arr2->replace(PVDoubleArray::const_svector(N, 0.0));
+    arr2->setLength(1u);
+    PVDoubleArray::const_svector held(arr2->view());
+    {
+        PVDoubleArray::svector junk(allocate_shared_vector<double>(N));
+        std::fill(junk.begin(), junk.end(), 42.0);
+    }
+    arr2->setLength(2u); // shared, so re-allocates with the same capacity
+    held.clear();
+    arr2->setLength(N);  // grows in place
+    held = arr2->view();
+    testOk1(held.size()==N && held[1]==0.0 && held[N-1]==0.0);
+}
+
+static void testSubArrayCopy()
+{
+    testDiag("Check pvSubArrayCopy");
+
+    PVIntArrayPtr from = getPVDataCreate()->createPVScalarArray<PVIntArray>(),
+                  to = getPVDataCreate()->createPVScalarArray<PVIntArray>();
+    {
+        PVIntArray::svector temp(6);
+        for(size_t i=0; i<temp.size(); i++)
+            temp[i] = int32(i+1);
+        from->replace(freeze(temp));
+    }
+    to->replace(PVIntArray::const_svector(2, 9));
+
+    PVIntArray::const_svector held(to->view());
+    copy(*from, 1, 1, *to, 1, 1, 4);
+    PVIntArray::const_svector result(to->view());
+    testOk1(result.size()==5 && result[0]==9 && result[1]==2 && result[4]==5);
+    testOk1(held.size()==2 && held[1]==9);
+
+    // value not shared, so updated in place
+    held.clear();
+    const int32 *check = result.data();
+    result.clear();
+    copy(*from, 0, 2, *to, 0, 2, 2);
+    result = to->view();
+    testOk1(result.size()==5 && result[0]==1 && result[1]==2 && result[2]==3 && result[4]==5);
+    testOk1(result.data()==check);
+    result.clear();
+
+    copy(*to, 0, 1, *to, 2, 1, 5);
+    result = to->view();
+    testOk1(result.size()==7 && result[2]==1 && result[6]==5);
+    result.clear();
+
+    // destination left unchanged on failure
+    PVIntArrayPtr bounded(getFieldCreate()->createFieldBuilder()
+                          ->addBoundedArray("x", pvInt, 4)
+                          ->createStructure()->build()
+                          ->getSubFieldT<PVIntArray>("x"));
+    bounded->replace(PVIntArray::const_svector(3, 7));
+    try {
+        copy(*from, 0, 1, *bounded, 2, 1, 3);
+        testFail("copy beyond bound did not throw");
+    } catch(std::invalid_argument& e) {
+        testPass("copy beyond bound throws: %s", e.what());
+    }
+    result = bounded->view();
+    testOk1(result.size()==3 && result[0]==7 && result[2]==7);
+}
+
+static void fillDedup(const PVStructurePtr& rec)
+{
+    PVStringArray::svector choices(2);
+    choices[0] = "Off";
+    choices[1] = "On";
+    rec->getSubFieldT<PVStringArray>("choices")->replace(freeze(choices));
+    rec->getSubFieldT<PVStringArray>("choices")->setImmutable();
+
+    PVDoubleArray::svector limits(2);
+    limits[0] = 0.0;
+    limits[1] = 10.0;
+    rec->getSubFieldT<PVDoubleArray>("limits")->replace(freeze(limits));
+
+    limits.resize(2);
+    limits[0] = 0.0;
+    limits[1] = 10.0;
+    rec->getSubFieldT<PVDoubleArray>("sub.limits")->replace(freeze(limits));
+}
+
+static void testDedup()
+{
+    testDiag("Check de-duplication");
+
+    ArrayDedup pool;
+    StructureConstPtr type(getFieldCreate()->createFieldBuilder()
+                           ->addArray("choices", pvString)
+                           ->addArray("limits", pvDouble)
+                           ->addNestedStructure("sub")
+                               ->addArray("limits", pvDouble)
+                           ->endNested()
+                           ->createStructure());
+
+    PVStructurePtr A(type->build()), B(type->build());
+    fillDedup(A);
+    fillDedup(B);
+
+    testOk1(A->getSubFieldT<PVDoubleArray>("limits")->view().data()
+            !=A->getSubFieldT<PVDoubleArray>("sub.limits")->view().data());
+
+    // only the immutable "choices" is added
+    testOk1(A->deduplicate(pool)==0u);
+    testOk1(pool.stats().entries==1u);
+    A->setImmutable();
+    testOk1(A->deduplicate(pool)==1u);
+    testOk1(A->getSubFieldT<PVDoubleArray>("limits")->view().data()
+            ==A->getSubFieldT<PVDoubleArray>("sub.limits")->view().data());
+
+    testOk1(B->deduplicate(pool, true)==3u);
+    testOk1(A->getSubFieldT<PVStringArray>("choices")->view().data()
+            ==B->getSubFieldT<PVStringArray>("choices")->view().data());
+    testOk1(B->getSubFieldT<PVDoubleArray>("limits")->view().data()
+            ==A->getSubFieldT<PVDoubleArray>("limits")->view().data());
+    // again is a no-op
+    testOk1(B->deduplicate(pool, true)==0u);
+
+    {
+        ArrayDedup::Stats stats(pool.stats());
+        testDiag("lookups %u hits %u bytesSaved %u entries %u bytesRetained %u",
+                 unsigned(stats.lookups), unsigned(stats.hits), unsigned(stats.bytesSaved),
+                 unsigned(stats.entries), unsigned(stats.bytesRetained));
+        testOk1(stats.lookups==10u);
+        testOk1(stats.hits==4u);
+        testOk1(stats.entries==2u);
+        testOk1(stats.bytesSaved==2u*sizeof(std::string) + 3u*2u*sizeof(double));
+    }
+
+    {
+        PVDoubleArray::svector other(2);
+        other[0] = -0.0; // bitwise compare, so distinct from 0.0
+        other[1] = 10.0;
+        PVDoubleArray::const_svector fother(freeze(other));
+        testOk1(pool.dedup(fother).data()==fother.data());
+    }
+    testOk1(pool.prune()==1u);
+
+    A.reset();
+    B.reset();
+    testOk1(pool.prune()==2u);
+    testOk1(pool.stats().entries==0u);
+
+    {
+        // released buffers are pruned as others are added
+        for(size_t i=0; i<1000u; i++) {
+            PVDoubleArray::svector temp(1u, double(i));
+            pool.dedup(freeze(temp));
+        }
+        ArrayDedup::Stats stats(pool.stats());
+        testOk(stats.entries<=64u, "entries %u <= 64", unsigned(stats.entries));
+    }
+
+    {
+        ArrayDedup small(1024u);
+        PVDoubleArray::svector big(200u);
+        PVDoubleArray::const_svector fbig(freeze(big));
+        testOk1(small.dedup(fbig).data()==fbig.data());
+        testOk1(small.stats().entries==0u);
+    }
+}
+
+static void testCompare()
+{
+    testDiag("Check array comparison");
+
+    PVDoubleArrayPtr A(getPVDataCreate()->createPVScalarArray<PVDoubleArray>()),
+                     B(getPVDataCreate()->createPVScalarArray<PVDoubleArray>());
+    testOk1(*A==*B);
+
+    // long enough to use both the blocks and the remainder
+    PVDoubleArray::svector a(37), b(37);
+    for(size_t i=0; i<a.size(); i++)
+        a[i] = b[i] = i;
+    b[0] = -0.0;
+    A->replace(freeze(a));
+    B->replace(freeze(b));
+    testOk1(*A==*B);
+
+    b = B->reuse();
+    b[20] = 0.5;
+    B->replace(freeze(b));
+    testOk1(*A!=*B);
+
+    b = B->reuse();
+    b[20] = 20.0;
+    b[35] = 0.5;
+    B->replace(freeze(b));
+    testOk1(*A!=*B);
+
+    b = B->reuse();
+    b.resize(36);
+    B->replace(freeze(b));
+    testOk1(*A!=*B);
+
+    // a NaN differs from itself, even in a shared buffer
+    a = A->reuse();
+    a[3] = epicsNAN;
+    A->replace(freeze(a));
+    B->replace(A->view());
+    testOk1(*A!=*B);
+
+    PVIntArrayPtr I(getPVDataCreate()->createPVScalarArray<PVIntArray>()),
+                  J(getPVDataCreate()->createPVScalarArray<PVIntArray>());
+    PVIntArray::svector i(33, 1), j(33, 1);
+    I->replace(freeze(i));
+    J->replace(freeze(j));
+    testOk1(*I==*J);
+    j = J->reuse();
+    j[32] = 2;
+    J->replace(freeze(j));
+    testOk1(*I!=*J);
+    J->replace(I->view());
+    testOk1(*I==*J);
+}
+
 } // end namespace
 
 MAIN(testPVScalarArray)
 {
-    testPlan(158);
+    testPlan(202);
     testFactory();
     testBasic<PVByteArray>();
     testBasic<PVUByteArray>();
@@ -209,5 +454,9 @@ MAIN(testPVScalarArray)
     testBasic<PVStringArray>();
     testShare();
     testVoid();
+    testSetLength();
+    testSubArrayCopy();
+    testDedup();
+    testCompare();
     return testDone();
 }
@@ -9,10 +9,12 @@
 #include <cstdlib>
 #include <cstddef>
 #include <string>
+#include <algorithm>
 #include <cstdio>
 
 #include <epicsAssert.h>
 #include <epicsExit.h>
+#include <epicsMath.h>
 
 #include <pv/pvIntrospect.h>
 #include <pv/pvData.h>
@@ -155,9 +157,49 @@ static void testFromRaw()
     PVStructureArray::svector cont(raw, 1, 2);
 }
 
+static void testCompare()
+{
+    testDiag("Compare structure arrays");
+
+    StructureArrayConstPtr type(fieldCreate->createStructureArray(
+                                    standardField->scalar(pvDouble, "alarm")));
+    PVStructureArrayPtr A(type->build()), B(type->build());
+
+    PVStructureArray::svector elems(3);
+    elems[0] = pvDataCreate->createPVStructure(type->getStructure());
+    elems[2] = pvDataCreate->createPVStructure(type->getStructure());
+    elems[2]->getSubFieldT<PVDouble>("value")->put(epicsNAN);
+
+    PVStructureArray::const_svector shared(freeze(elems));
+    A->replace(shared);
+    B->replace(shared);
+    testOk1(*A==*B);
+
+    // the same elements in another vector
+    {
+        PVStructureArray::svector other(shared.size());
+        std::copy(shared.begin(), shared.end(), other.begin());
+        B->replace(freeze(other));
+    }
+    testOk1(B->view().data()!=A->view().data());
+    testOk1(*A==*B);
+
+    // an equal copy of an element holding NaN is not equal
+    elems = B->reuse();
+    elems[2] = pvDataCreate->createPVStructure(elems[2]);
+    B->replace(freeze(elems));
+    testOk1(*A!=*B);
+
+    elems = B->reuse();
+    elems[2] = A->view()[2];
+    elems[1] = pvDataCreate->createPVStructure(type->getStructure());
+    B->replace(freeze(elems));
+    testOk1(*A!=*B);
+}
+
 MAIN(testPVStructureArray)
 {
-    testPlan(23);
+    testPlan(28);
     testDiag("Testing structure array handling");
     fieldCreate = getFieldCreate();
     pvDataCreate = getPVDataCreate();
@@ -167,5 +209,6 @@ MAIN(testPVStructureArray)
     testCompress();
     testRemove();
     testFromRaw();
+    testCompare();
     return testDone();
 }